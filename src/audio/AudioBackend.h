@@ -0,0 +1,54 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+// Stream parameters shared by every backend
+struct AudioStreamConfig {
+  unsigned sampleRate = 48000;
+  unsigned frames = 128;        // requested block size; backends may round it
+  int inputChannel = -1;        // capture channel, -1 = output only
+  unsigned outputChannels = 2;
+  unsigned outputDevice = 0;    // AudioDeviceInfo::id, 0 = system default
+  unsigned inputDevice = 0;
+};
+
+struct AudioDeviceInfo {
+  unsigned id = 0;
+  std::string name;
+  unsigned outputChannels = 0;
+  unsigned inputChannels = 0;
+  std::vector<unsigned> sampleRates;
+  unsigned preferredRate = 0;
+  bool isDefaultOutput = false;
+  bool isDefaultInput = false;
+};
+
+// A source of audio callbacks. RtAudio drives a sound card; the null and file
+// backends drive the same callback from their own thread so the clients run
+// unchanged on machines without audio hardware.
+class AudioBackend {
+public:
+  // Flags passed with a block when the device reports a dropout before it
+  enum Status : unsigned { OutputUnderflow = 1u, InputOverflow = 2u };
+
+  // Called on the backend's audio thread; `out` is zeroed and interleaved.
+  using Process = std::function<void(const float* in, float* out, unsigned nframes, unsigned status)>;
+
+  virtual ~AudioBackend() = default;
+  virtual const char* name() const = 0;
+
+  // Opens and starts the stream. Returns false if nothing could be opened.
+  virtual bool open(const AudioStreamConfig& cfg, Process process) = 0;
+  virtual void close() = 0;
+  virtual bool start() = 0;
+  virtual bool stop() = 0;
+  virtual bool is_running() const = 0;
+  virtual bool has_input() const = 0;
+  virtual unsigned channels() const = 0;
+  virtual unsigned sample_rate() const = 0;   // of the open stream
+  virtual unsigned buffer_frames() const = 0; // block size the device settled on
+  virtual unsigned latency_frames() { return 0; }
+  virtual unsigned input_channel_count() { return 0; } // on the configured input device
+  virtual std::vector<AudioDeviceInfo> devices() { return {}; }
+};
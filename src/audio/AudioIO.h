@@ -1,21 +1,57 @@
 #pragma once
-#include <rtaudio/RtAudio.h>
+#include "AudioBackend.h"
+#include "DspLoadMeter.h"
 #include <functional>
+#include <memory>
+#include <string>
+
+// Builds a backend from a command-line spec:
+//   "rtaudio" (default sound card), "null" (timer-paced, no hardware),
+//   "file:<out.wav>[,<in.wav>]" (offline, faster than real time; `seconds`
+//   bounds the render, 0 = length of the input file).
+// Returns nullptr for an unknown spec.
+std::unique_ptr<AudioBackend> make_audio_backend(const std::string& spec, double seconds = 0.0);
 
 class AudioIO {
 public:
-  using Callback = std::function<void(float* out, unsigned nframes)>;
+  // `in` is the captured (mono) input channel, or nullptr when the stream is
+  // output-only; `out` holds `channels()` interleaved channels.
+  using Callback = std::function<void(const float* in, float* out, unsigned nframes)>;
+  static constexpr int kNoInput = -1;
+
+  AudioIO(); // RtAudio
+  explicit AudioIO(std::unique_ptr<AudioBackend> backend);
+  ~AudioIO();
 
-  bool open(unsigned sampleRate = 48000, unsigned frames = 128);
+  // Opens the backend's output with `outputChannels` (falling back to mono if
+  // the device has fewer); with inputChannel >= 0 the stream is full duplex
+  // and also captures that input channel. Falls back to output-only if the
+  // input cannot be opened.
+  bool open(unsigned sampleRate = 48000, unsigned frames = 128, int inputChannel = kNoInput,
+            unsigned outputChannels = 2);
+  bool open(const AudioStreamConfig& cfg); // also picks devices
   void close();
   void set_callback(Callback cb) { cb_ = std::move(cb); }
-  bool is_running() const { return audio_.isStreamOpen() && audio_.isStreamRunning(); }
-  bool start();
-  bool stop();
+  bool is_running() const { return backend_->is_running(); }
+  bool has_input() const { return backend_->has_input(); }
+  unsigned channels() const { return backend_->channels(); }
+  // Of the open stream; everything rate-dependent should follow these.
+  unsigned sample_rate() const { return backend_->sample_rate(); }
+  unsigned buffer_frames() const { return backend_->buffer_frames(); }
+  std::vector<AudioDeviceInfo> devices() { return backend_->devices(); }
+  unsigned latency_frames() { return backend_->latency_frames(); }
+  unsigned input_channel_count() { return backend_->input_channel_count(); }
+  const char* backend_name() const { return backend_->name(); }
+  AudioBackend& backend() { return *backend_; }
+  // Callback timing and dropouts; callbacks mark their own stages on it.
+  DspLoadMeter& meter() { return meter_; }
+  bool start() { return backend_->start(); }
+  bool stop() { return backend_->stop(); }
 
 private:
-  static int rt_cb(void* out, void* in, unsigned nFrames, double streamTime,
-                   RtAudioStreamStatus status, void* userData);
-  RtAudio audio_;
+  void process(const float* in, float* out, unsigned nframes, unsigned status);
+
+  std::unique_ptr<AudioBackend> backend_;
   Callback cb_;
+  DspLoadMeter meter_;
 };
@@ -0,0 +1,76 @@
+#include "AudioSender.h"
+
+#include <algorithm>
+#include <cstring>
+
+AudioSender::AudioSender(UdpSocket& udp, const ClientSession& session)
+    : udp_(udp), session_(session), queue_(kQueueBlocks) {}
+
+AudioSender::~AudioSender() { stop(); }
+
+void AudioSender::start() {
+  if (running_.exchange(true)) return;
+  thread_ = std::thread([this] { run(); });
+}
+
+void AudioSender::stop() {
+  if (!running_.exchange(false)) return;
+  pending_.fetch_add(1, std::memory_order_release);
+  pending_.notify_one();
+  if (thread_.joinable()) thread_.join();
+}
+
+bool AudioSender::submit(const float* samples, unsigned nframes, unsigned channels, uint64_t timestampNs,
+                         uint32_t sampleRate) {
+  channels = std::clamp<unsigned>(channels, 1, kMaxWireChannels);
+  bool ok = true;
+  for (unsigned off = 0; off < nframes;) {
+    Block* b = queue_.prepare();
+    if (!b) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      ok = false;
+      break;
+    }
+    unsigned n = std::min(nframes - off, kBlockFrames);
+    b->timestampNs = timestampNs + static_cast<uint64_t>(off) * 1000000000ull / sampleRate;
+    b->sampleRate = sampleRate;
+    b->frames = n;
+    b->channels = channels;
+    std::memcpy(b->samples, samples + static_cast<size_t>(off) * channels, n * channels * sizeof(float));
+    queue_.commit();
+    off += n;
+  }
+  pending_.fetch_add(1, std::memory_order_release);
+  pending_.notify_one();
+  return ok;
+}
+
+void AudioSender::run() {
+  uint32_t seen = pending_.load(std::memory_order_acquire);
+  while (running_.load()) {
+    while (Block* b = queue_.front()) {
+      if (session_.ready.load()) send_block(*b);
+      queue_.pop();
+    }
+    pending_.wait(seen, std::memory_order_acquire);
+    seen = pending_.load(std::memory_order_acquire);
+  }
+}
+
+void AudioSender::send_block(const Block& block) {
+  PacketHeader hdr;
+  hdr.sender_id = session_.senderId.load();
+  hdr.format = session_.sample_format();
+  hdr.channels = static_cast<uint8_t>(block.channels);
+  hdr.sample_rate = block.sampleRate;
+  unsigned packet = std::clamp<unsigned>(session_.blockFrames.load(), 1,
+                                         static_cast<unsigned>(max_frames_per_packet(hdr.channels, hdr.format)));
+  uint8_t bytes[kMaxDatagram];
+  for (unsigned off = 0; off < block.frames; off += packet) {
+    hdr.frames = static_cast<uint16_t>(std::min(packet, block.frames - off));
+    hdr.seq = seq_++;
+    hdr.timestamp_ns = block.timestampNs + static_cast<uint64_t>(off) * 1000000000ull / hdr.sample_rate;
+    size_t len = encode_audio(bytes, sizeof(bytes), hdr, block.samples + static_cast<size_t>(off) * block.channels);
+    if (len) udp_.send(bytes, len);
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "common/Session.h"
+#include "common/SpscQueue.h"
+#include "common/UdpSocket.h"
+
+// Send path for the local signal. The audio callback only copies finished
+// blocks into a preallocated SPSC queue; a dedicated thread packetizes them
+// in the negotiated block size/format and does the (blocking) socket sends.
+class AudioSender {
+public:
+  static constexpr unsigned kBlockFrames = 512; // frames per queued block
+  static constexpr size_t kQueueBlocks = 64;
+
+  AudioSender(UdpSocket& udp, const ClientSession& session);
+  ~AudioSender();
+
+  void start();
+  void stop();
+
+  // Audio thread, wait-free. Queues `nframes` interleaved frames of
+  // `channels` starting at `timestampNs`; returns false if the sender fell
+  // behind and audio had to be dropped.
+  bool submit(const float* samples, unsigned nframes, unsigned channels, uint64_t timestampNs,
+              uint32_t sampleRate);
+
+  uint64_t dropped_blocks() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  struct Block {
+    uint64_t timestampNs = 0;
+    uint32_t sampleRate = 0;
+    uint32_t frames = 0;
+    uint32_t channels = 1;
+    float samples[kBlockFrames * kMaxWireChannels];
+  };
+
+  void run();
+  void send_block(const Block& block);
+
+  UdpSocket& udp_;
+  const ClientSession& session_;
+  SpscQueue<Block> queue_;
+  std::atomic<uint32_t> pending_{0}; // bumped per submit, waited on by the sender
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> dropped_{0};
+  std::thread thread_;
+  uint32_t seq_ = 0; // sender thread only
+};
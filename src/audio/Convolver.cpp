@@ -0,0 +1,304 @@
+#include "Convolver.h"
+#include "WavFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LANJAM_CONV_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+constexpr size_t kMaxChunk = 64;                 // frames between segment checks
+constexpr size_t kHistLen = Convolver::kDirectTaps - 1 + kMaxChunk;
+constexpr size_t kRing = 8192;                   // > furthest result written ahead (4096)
+constexpr size_t kTailStart = 2 * Convolver::kTailBlock;
+constexpr double kMaxSeconds = 10.0;
+
+// Audio thread segments: {block, end of the range they cover}
+constexpr struct { size_t block, end; } kHeadLayout[] = {{64, 1024}, {512, kTailStart}};
+
+// acc += x * h over split complex spectra
+void cmac(float* accRe, float* accIm, const float* xRe, const float* xIm, const float* hRe, const float* hIm,
+          size_t n) {
+  size_t i = 0;
+#ifdef LANJAM_CONV_SSE2
+  for (; i + 4 <= n; i += 4) {
+    __m128 xr = _mm_loadu_ps(xRe + i), xi = _mm_loadu_ps(xIm + i);
+    __m128 hr = _mm_loadu_ps(hRe + i), hi = _mm_loadu_ps(hIm + i);
+    __m128 re = _mm_sub_ps(_mm_mul_ps(xr, hr), _mm_mul_ps(xi, hi));
+    __m128 im = _mm_add_ps(_mm_mul_ps(xr, hi), _mm_mul_ps(xi, hr));
+    _mm_storeu_ps(accRe + i, _mm_add_ps(_mm_loadu_ps(accRe + i), re));
+    _mm_storeu_ps(accIm + i, _mm_add_ps(_mm_loadu_ps(accIm + i), im));
+  }
+#endif
+  for (; i < n; ++i) {
+    accRe[i] += xRe[i] * hRe[i] - xIm[i] * hIm[i];
+    accIm[i] += xRe[i] * hIm[i] + xIm[i] * hRe[i];
+  }
+}
+
+// sum a[i] * b[i], n a multiple of 4
+float dot(const float* a, const float* b, size_t n) {
+#ifdef LANJAM_CONV_SSE2
+  __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  for (; i < n; i += 4) s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  alignas(16) float lanes[4];
+  _mm_store_ps(lanes, _mm_add_ps(s0, s1));
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+  float s = 0.0f;
+  for (size_t i = 0; i < n; ++i) s += a[i] * b[i];
+  return s;
+#endif
+}
+} // namespace
+
+void Convolver::Segment::build(const float* ir, size_t irFrames, unsigned irChannels) {
+  fft = std::make_unique<RealFft>(2 * block);
+  const size_t bins = fft->bins();
+  hRe.assign(irChannels * parts * bins, 0.0f);
+  hIm.assign(irChannels * parts * bins, 0.0f);
+  time.assign(2 * block, 0.0f);
+  for (unsigned c = 0; c < irChannels; ++c) {
+    for (size_t p = 0; p < parts; ++p) {
+      // partition in the first half, zeros after (overlap-save keeps the last block)
+      std::fill(time.begin(), time.end(), 0.0f);
+      for (size_t k = 0; k < block; ++k) {
+        size_t f = start + p * block + k;
+        if (f < irFrames) time[k] = ir[f * irChannels + c];
+      }
+      size_t off = (c * parts + p) * bins;
+      fft->forward(time.data(), hRe.data() + off, hIm.data() + off);
+    }
+  }
+  fdlRe.assign(kMaxChannels * parts * bins, 0.0f);
+  fdlIm.assign(kMaxChannels * parts * bins, 0.0f);
+  prev.assign(kMaxChannels * block, 0.0f);
+  cur.assign(kMaxChannels * block, 0.0f);
+  accRe.assign(bins, 0.0f);
+  accIm.assign(bins, 0.0f);
+  result.assign(kMaxChannels * block, 0.0f);
+}
+
+void Convolver::Segment::clear() {
+  std::fill(fdlRe.begin(), fdlRe.end(), 0.0f);
+  std::fill(fdlIm.begin(), fdlIm.end(), 0.0f);
+  std::fill(prev.begin(), prev.end(), 0.0f);
+  fdlPos = 0;
+  fill = 0;
+}
+
+void Convolver::Segment::run(unsigned channels, unsigned irChannels) {
+  const size_t bins = fft->bins();
+  for (unsigned c = 0; c < channels; ++c) {
+    float* p = prev.data() + c * block;
+    float* x = cur.data() + c * block;
+    std::copy_n(p, block, time.data());
+    std::copy_n(x, block, time.data() + block);
+    const size_t fdl = c * parts * bins;
+    fft->forward(time.data(), fdlRe.data() + fdl + fdlPos * bins, fdlIm.data() + fdl + fdlPos * bins);
+
+    // partition k meets the input spectrum from k blocks ago
+    std::fill(accRe.begin(), accRe.end(), 0.0f);
+    std::fill(accIm.begin(), accIm.end(), 0.0f);
+    const size_t h = (c % irChannels) * parts * bins;
+    for (size_t k = 0; k < parts; ++k) {
+      size_t slot = (fdlPos + parts - k) % parts;
+      cmac(accRe.data(), accIm.data(), fdlRe.data() + fdl + slot * bins, fdlIm.data() + fdl + slot * bins,
+           hRe.data() + h + k * bins, hIm.data() + h + k * bins, bins);
+    }
+    fft->inverse(accRe.data(), accIm.data(), time.data());
+    std::copy_n(time.data() + block, block, result.data() + c * block);
+    std::copy_n(x, block, p);
+  }
+  fdlPos = (fdlPos + 1) % parts;
+}
+
+Convolver::Convolver(const float* ir, size_t frames, unsigned irChannels)
+    : irFrames_(frames), irChannels_(std::clamp(irChannels, 1u, kMaxChannels)) {
+  // keep at most kMaxChannels of the response, interleaved at irChannels_
+  std::vector<float> h(frames * irChannels_);
+  for (size_t f = 0; f < frames; ++f)
+    for (unsigned c = 0; c < irChannels_; ++c) h[f * irChannels_ + c] = ir[f * irChannels + c];
+
+  direct_.assign(irChannels_ * kDirectTaps, 0.0f);
+  for (unsigned c = 0; c < irChannels_; ++c)
+    for (size_t k = 0; k < kDirectTaps && k < frames; ++k)
+      direct_[c * kDirectTaps + kDirectTaps - 1 - k] = h[k * irChannels_ + c];
+  hist_.assign(kMaxChannels * kHistLen, 0.0f);
+  ring_.assign(kMaxChannels * kRing, 0.0f);
+
+  size_t start = kDirectTaps;
+  for (const auto& layout : kHeadLayout) {
+    if (start >= frames) break;
+    Segment& s = head_.emplace_back();
+    s.block = layout.block;
+    s.start = start;
+    s.parts = (std::min(layout.end, frames) - start + s.block - 1) / s.block;
+    s.build(h.data(), frames, irChannels_);
+    start = layout.end;
+  }
+  if (frames > kTailStart) {
+    tail_ = std::make_unique<Segment>();
+    tail_->block = kTailBlock;
+    tail_->start = kTailStart;
+    tail_->parts = (frames - kTailStart + kTailBlock - 1) / kTailBlock;
+    tail_->build(h.data(), frames, irChannels_);
+    tailIn_.assign(kMaxChannels * kTailBlock, 0.0f);
+    tailThread_ = std::thread([this] { tail_main(); });
+  }
+}
+
+Convolver::~Convolver() {
+  if (!tailThread_.joinable()) return;
+  quit_.store(true);
+  submitted_.fetch_add(1, std::memory_order_release);
+  submitted_.notify_one();
+  tailThread_.join();
+}
+
+void Convolver::tail_main() {
+  uint32_t seen = 0;
+  for (;;) {
+    submitted_.wait(seen, std::memory_order_acquire);
+    if (quit_.load()) return;
+    seen = submitted_.load(std::memory_order_acquire);
+    auto t0 = std::chrono::steady_clock::now();
+    if (resetTail_.exchange(false)) tail_->clear();
+    tail_->run(tailChannels_, irChannels_);
+    done_.store(seen, std::memory_order_release);
+    tailNanos_.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - t0).count()),
+                         std::memory_order_relaxed);
+  }
+}
+
+void Convolver::add_to_ring(const float* block, size_t frames, uint64_t at, unsigned channels) {
+  for (unsigned c = 0; c < channels; ++c) {
+    float* ring = ring_.data() + c * kRing;
+    const float* src = block + c * frames;
+    for (size_t k = 0; k < frames; ++k) ring[(at + k) & (kRing - 1)] += src[k];
+  }
+}
+
+void Convolver::process(const float* in, float* out, size_t frames, unsigned channels) {
+  const unsigned cc = std::min(channels, kMaxChannels);
+  size_t i = 0;
+  while (i < frames) {
+    // run up to the next block boundary of any segment
+    size_t n = std::min(frames - i, kMaxChunk);
+    for (const auto& s : head_) n = std::min(n, s.block - s.fill);
+    if (tail_) n = std::min(n, kTailBlock - tailFill_);
+
+    for (unsigned c = 0; c < channels; ++c) {
+      float* o = out + i * channels + c;
+      if (c >= cc) {
+        for (size_t k = 0; k < n; ++k) o[k * channels] = 0.0f;
+        continue;
+      }
+      float* hist = hist_.data() + c * kHistLen;
+      float* x = hist + kDirectTaps - 1;
+      for (size_t k = 0; k < n; ++k) x[k] = in[(i + k) * channels + c];
+      const float* taps = direct_.data() + (c % irChannels_) * kDirectTaps;
+      float* ring = ring_.data() + c * kRing;
+      for (size_t k = 0; k < n; ++k) {
+        float& pending = ring[(now_ + k) & (kRing - 1)];
+        o[k * channels] = dot(taps, hist + k, kDirectTaps) + pending;
+        pending = 0.0f;
+      }
+      for (auto& s : head_) std::copy_n(x, n, s.cur.data() + c * s.block + s.fill);
+      if (tail_) std::copy_n(x, n, tailIn_.data() + c * kTailBlock + tailFill_);
+      std::memmove(hist, hist + n, (kDirectTaps - 1) * sizeof(float));
+    }
+    now_ += n;
+    i += n;
+
+    // finished blocks land at least one block ahead, never inside this chunk
+    for (auto& s : head_) {
+      s.fill += n;
+      if (s.fill < s.block) continue;
+      s.run(cc, irChannels_);
+      add_to_ring(s.result.data(), s.block, now_ - s.block + s.start, cc);
+      s.fill = 0;
+    }
+    if (tail_ && (tailFill_ += n) == kTailBlock) {
+      tailFill_ = 0;
+      uint32_t sub = submitted_.load(std::memory_order_relaxed);
+      if (done_.load(std::memory_order_acquire) != sub) {
+        // still busy with the previous block: lose this one's tail
+        late_.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      // the previous job covers the next kTailBlock frames
+      if (tailDue_ == now_) add_to_ring(tail_->result.data(), kTailBlock, now_, tailChannels_);
+      for (unsigned c = 0; c < cc; ++c)
+        std::copy_n(tailIn_.data() + c * kTailBlock, kTailBlock, tail_->cur.data() + c * kTailBlock);
+      tailChannels_ = cc;
+      tailDue_ = now_ + kTailBlock;
+      submitted_.store(sub + 1, std::memory_order_release);
+      submitted_.notify_one();
+    }
+  }
+}
+
+void Convolver::reset() {
+  std::fill(hist_.begin(), hist_.end(), 0.0f);
+  std::fill(ring_.begin(), ring_.end(), 0.0f);
+  for (auto& s : head_) s.clear();
+  tailFill_ = 0;
+  tailDue_ = UINT64_MAX;
+  resetTail_.store(true);
+}
+
+std::unique_ptr<Convolver> Convolver::from_wav(const WavData& wav, double sampleRate) {
+  const unsigned channels = std::min(wav.channels, kMaxChannels);
+  if (!channels || !wav.frames() || !wav.sampleRate) {
+    std::fprintf(stderr, "Convolver: empty impulse response\n");
+    return nullptr;
+  }
+  const double ratio = sampleRate / wav.sampleRate;
+  size_t frames = static_cast<size_t>(std::ceil(wav.frames() * ratio));
+  if (frames > static_cast<size_t>(kMaxSeconds * sampleRate)) {
+    std::fprintf(stderr, "Convolver: impulse response truncated to %.0f s\n", kMaxSeconds);
+    frames = static_cast<size_t>(kMaxSeconds * sampleRate);
+  }
+
+  // Windowed-sinc resampling to the stream rate (cut off at the lower
+  // Nyquist), then unit energy so responses sit at similar levels
+  std::vector<float> ir(frames * channels, 0.0f);
+  const double cutoff = std::min(1.0, ratio);
+  const double halfWidth = 16.0 / cutoff; // input frames either side
+  const double pi = 3.14159265358979323846;
+  for (size_t n = 0; n < frames; ++n) {
+    double t = n / ratio;
+    auto lo = static_cast<long long>(std::ceil(t - halfWidth));
+    auto hi = static_cast<long long>(std::floor(t + halfWidth));
+    for (long long j = std::max(0ll, lo); j <= hi && j < static_cast<long long>(wav.frames()); ++j) {
+      double d = t - static_cast<double>(j);
+      double sinc = d == 0.0 ? 1.0 : std::sin(pi * cutoff * d) / (pi * cutoff * d);
+      double window = 0.42 + 0.5 * std::cos(pi * d / halfWidth) + 0.08 * std::cos(2.0 * pi * d / halfWidth);
+      auto w = static_cast<float>(cutoff * sinc * window);
+      for (unsigned c = 0; c < channels; ++c) ir[n * channels + c] += w * wav.samples[j * wav.channels + c];
+    }
+  }
+  double energy = 0.0;
+  for (float v : ir) energy += static_cast<double>(v) * v;
+  energy /= channels;
+  if (energy <= 0.0) {
+    std::fprintf(stderr, "Convolver: impulse response is silent\n");
+    return nullptr;
+  }
+  const auto scale = static_cast<float>(1.0 / std::sqrt(energy));
+  for (float& v : ir) v *= scale;
+  return std::make_unique<Convolver>(ir.data(), frames, channels);
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Fft.h"
+
+struct WavData;
+
+// Zero-latency partitioned convolution (reverb) of up to kMaxChannels
+// interleaved channels. The impulse response is split non-uniformly:
+//   [0, 64)        direct-form FIR, so the output needs no extra buffering
+//   [64, 1024)     64-frame FFT partitions, audio thread
+//   [1024, 4096)   512-frame FFT partitions, audio thread
+//   [4096, end)    2048-frame FFT partitions, on a background thread
+// Every segment starts at least one of its blocks into the response (two for
+// the background one), so each result lands in the future: the tail thread
+// gets a whole 2048-frame block period per job. A job it misses is dropped
+// and counted in late_blocks() rather than stalling the audio thread.
+class Convolver {
+public:
+  static constexpr unsigned kMaxChannels = 2;
+  static constexpr size_t kDirectTaps = 64;
+  static constexpr size_t kTailBlock = 2048;
+
+  // Builds the partition spectra and, for responses longer than 4096
+  // frames, starts the tail thread; not real-time safe. A mono response
+  // feeds every channel, a stereo one maps channel to channel.
+  Convolver(const float* ir, size_t frames, unsigned irChannels);
+  ~Convolver();
+  // Resamples a loaded WAV response to `sampleRate` (first two channels,
+  // at most 10 s) and scales it to unit energy; nullptr if unusable
+  static std::unique_ptr<Convolver> from_wav(const WavData& wav, double sampleRate);
+  Convolver(const Convolver&) = delete;
+  Convolver& operator=(const Convolver&) = delete;
+
+  size_t ir_frames() const { return irFrames_; }
+  unsigned ir_channels() const { return irChannels_; }
+  uint64_t late_blocks() const { return late_.load(std::memory_order_relaxed); }
+  // Time the tail thread has spent on jobs so far
+  double tail_seconds() const { return tailNanos_.load(std::memory_order_relaxed) * 1e-9; }
+
+  // Audio thread: writes the wet signal (any block size, channels <= kMaxChannels)
+  void process(const float* in, float* out, size_t frames, unsigned channels);
+  // Audio thread: forgets all input so far (the tail thread catches up on its next job)
+  void reset();
+
+private:
+  // Uniformly partitioned overlap-save over IR frames [start, start + parts * block)
+  struct Segment {
+    size_t block = 0, start = 0, parts = 0;
+    std::unique_ptr<RealFft> fft;
+    std::vector<float> hRe, hIm;     // [irChannel][part][bin]
+    std::vector<float> fdlRe, fdlIm; // input spectra, [channel][part][bin], ring over parts
+    size_t fdlPos = 0;
+    std::vector<float> prev, cur;    // time-domain input blocks, [channel][block]
+    std::vector<float> time, accRe, accIm;
+    std::vector<float> result;       // [channel][block]
+    size_t fill = 0;                 // frames of `cur` filled so far (audio thread segments)
+
+    void build(const float* ir, size_t irFrames, unsigned irChannels);
+    void clear();
+    void run(unsigned channels, unsigned irChannels); // cur -> result, then cur becomes prev
+  };
+
+  void add_to_ring(const float* block, size_t frames, uint64_t at, unsigned channels);
+  void tail_main();
+
+  size_t irFrames_;
+  unsigned irChannels_;
+  std::vector<float> direct_;           // first taps reversed, [irChannel][kDirectTaps]
+  std::vector<float> hist_;             // [channel][kDirectTaps - 1 + kMaxChunk]
+  std::vector<Segment> head_;           // audio thread segments
+  std::vector<float> ring_;             // pending output, [channel][kRing]
+  uint64_t now_ = 0;                    // frames processed
+
+  // Tail: the audio thread fills tail_.cur and hands it over once the
+  // previous job is done; results are folded in when their block is due
+  std::unique_ptr<Segment> tail_;
+  std::thread tailThread_;
+  std::atomic<bool> quit_{false};
+  std::atomic<bool> resetTail_{false};
+  alignas(64) std::atomic<uint32_t> submitted_{0};
+  alignas(64) std::atomic<uint32_t> done_{0};
+  std::vector<float> tailIn_;           // block being filled, [channel][kTailBlock]
+  size_t tailFill_ = 0;
+  unsigned tailChannels_ = 0;           // channels of the job handed over
+  uint64_t tailDue_ = UINT64_MAX;       // frame the pending result starts at
+  std::atomic<uint64_t> late_{0};
+  std::atomic<uint64_t> tailNanos_{0};
+};
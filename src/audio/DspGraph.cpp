@@ -0,0 +1,126 @@
+#include "DspGraph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+
+size_t DspGraph::index_of(const DspNode* node) const {
+  for (size_t i = 0; i < nodes_.size(); ++i)
+    if (nodes_[i].node.get() == node) return i;
+  return nodes_.size();
+}
+
+bool DspGraph::connect(DspNode* from, DspNode* to, unsigned input) {
+  size_t f = index_of(from), t = index_of(to);
+  if (f == nodes_.size() || t == nodes_.size() || input >= to->inputs()) {
+    std::fprintf(stderr, "DspGraph: invalid connection\n");
+    return false;
+  }
+  // a later connect to the same input replaces the earlier one
+  edges_.erase(std::remove_if(edges_.begin(), edges_.end(), [&](const Edge& e) { return e.to == t && e.input == input; }),
+               edges_.end());
+  edges_.push_back({f, t, input});
+  compiled_ = false;
+  return true;
+}
+
+void DspGraph::expose(DspNode* node) {
+  size_t i = index_of(node);
+  if (i < nodes_.size()) nodes_[i].exposed = true;
+}
+
+bool DspGraph::compile(double sampleRate, unsigned maxFrames, unsigned maxChannels) {
+  compiled_ = false;
+  const size_t n = nodes_.size();
+
+  // Depth-first topological sort: nodes run in the order they were added
+  // unless an input has to run first, so callers control the schedule
+  // wherever the connections leave a choice
+  std::vector<size_t> order;
+  order.reserve(n);
+  std::vector<uint8_t> mark(n, 0); // 1 visiting, 2 done
+  std::vector<std::pair<size_t, size_t>> stack; // node, next edge to look at
+  for (size_t root = 0; root < n; ++root) {
+    if (mark[root]) continue;
+    stack.push_back({root, 0});
+    mark[root] = 1;
+    while (!stack.empty()) {
+      auto& [node, next] = stack.back();
+      while (next < edges_.size() && (edges_[next].to != node || mark[edges_[next].from] == 2)) ++next;
+      if (next == edges_.size()) {
+        mark[node] = 2;
+        order.push_back(node);
+        stack.pop_back();
+        continue;
+      }
+      size_t from = edges_[next].from;
+      if (mark[from] == 1) {
+        std::fprintf(stderr, "DspGraph: connections form a cycle\n");
+        return false;
+      }
+      mark[from] = 1;
+      stack.push_back({from, 0});
+    }
+  }
+
+  // Buffer slots: a node's slot is taken when it runs and returned after its
+  // last reader; exposed and unread outputs keep theirs
+  constexpr size_t kKeep = std::numeric_limits<size_t>::max();
+  std::vector<size_t> pos(n), lastUse(n, 0), slotOf(n);
+  for (size_t p = 0; p < n; ++p) pos[order[p]] = p;
+  std::vector<bool> read(n, false);
+  for (const auto& e : edges_) {
+    read[e.from] = true;
+    lastUse[e.from] = std::max(lastUse[e.from], pos[e.to]);
+  }
+  for (size_t i = 0; i < n; ++i)
+    if (nodes_[i].exposed || !read[i]) lastUse[i] = kKeep;
+  std::vector<size_t> freeSlots;
+  size_t slots = 0;
+  for (size_t p = 0; p < n; ++p) {
+    size_t node = order[p];
+    if (!freeSlots.empty()) {
+      slotOf[node] = freeSlots.back();
+      freeSlots.pop_back();
+    } else {
+      slotOf[node] = slots++;
+    }
+    // inputs are released after the output is assigned, so they never alias
+    for (const auto& e : edges_)
+      if (e.to == node && lastUse[e.from] == p &&
+          std::find(freeSlots.begin(), freeSlots.end(), slotOf[e.from]) == freeSlots.end())
+        freeSlots.push_back(slotOf[e.from]);
+  }
+
+  const size_t bufFloats = static_cast<size_t>(maxFrames) * maxChannels;
+  arena_.assign((slots + 1) * bufFloats, 0.0f);
+  const float* silence = arena_.data() + slots * bufFloats;
+  outOf_.assign(n, nullptr);
+  for (size_t i = 0; i < n; ++i) outOf_[i] = arena_.data() + slotOf[i] * bufFloats;
+
+  steps_.clear();
+  inPtrs_.clear();
+  for (size_t node : order) {
+    DspNode* dsp = nodes_[node].node.get();
+    size_t begin = inPtrs_.size();
+    inPtrs_.resize(begin + dsp->inputs(), silence);
+    for (const auto& e : edges_)
+      if (e.to == node) inPtrs_[begin + e.input] = outOf_[e.from];
+    steps_.push_back({dsp, begin, outOf_[node]});
+    dsp->prepare(sampleRate, maxFrames, maxChannels);
+  }
+  maxFrames_ = maxFrames;
+  compiled_ = true;
+  return true;
+}
+
+void DspGraph::process(const DspContext& ctx) {
+  if (!compiled_) return;
+  for (const auto& s : steps_) s.node->process(ctx, inPtrs_.data() + s.inBegin, s.out);
+}
+
+const float* DspGraph::output(const DspNode* node) const {
+  size_t i = index_of(node);
+  return compiled_ && i < outOf_.size() ? outOf_[i] : nullptr;
+}
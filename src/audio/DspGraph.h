@@ -0,0 +1,113 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// What every node sees for one block. Buffers are interleaved with
+// `channels` channels (1 or 2 for the clients' buses).
+struct DspContext {
+  unsigned nframes = 0;
+  unsigned channels = 1;
+  double sampleRate = 48000.0;
+};
+
+// A processing node with any number of inputs and one output buffer. The
+// graph calls process() once per block, so the virtual call is per block and
+// node, never per sample.
+class DspNode {
+public:
+  virtual ~DspNode() = default;
+  virtual unsigned inputs() const { return 0; }
+  // From DspGraph::compile(), off the audio thread; may allocate
+  virtual void prepare(double /*sampleRate*/, unsigned /*maxFrames*/, unsigned /*maxChannels*/) {}
+  // `in` has inputs() entries (unconnected ones read silence); every sample
+  // of `out` must be written
+  virtual void process(const DspContext& ctx, const float* const* in, float* out) = 0;
+};
+
+// Nodes plus connections, compiled into a flat schedule: nodes run in the
+// order they were added, moved later only where an input must run first,
+// and output buffers come from one preallocated arena, a buffer being
+// reused once its last reader has run. Build and compile() off the audio
+// thread; process() neither allocates nor locks.
+class DspGraph {
+public:
+  DspGraph() = default;
+  DspGraph(const DspGraph&) = delete;
+  DspGraph& operator=(const DspGraph&) = delete;
+
+  template <class T, class... Args>
+  T* add(Args&&... args) {
+    auto node = std::make_unique<T>(std::forward<Args>(args)...);
+    T* raw = node.get();
+    nodes_.push_back({std::move(node), false});
+    compiled_ = false;
+    return raw;
+  }
+  // Node whose output is written by `fn(const DspContext&, float* out)` into
+  // a zeroed buffer; how existing audio code joins a graph
+  template <class F>
+  DspNode* add_source(F fn);
+
+  // `to`'s input `input` reads `from`'s output. One source per input; use a
+  // MixerNode to sum.
+  bool connect(DspNode* from, DspNode* to, unsigned input = 0);
+  // Keeps `node`'s output valid after process() for output(). Nodes nobody
+  // reads from are kept anyway.
+  void expose(DspNode* node);
+
+  // Sorts, assigns buffers and prepares every node; false on a cycle.
+  // Call again after changing the graph or the sample rate.
+  bool compile(double sampleRate, unsigned maxFrames, unsigned maxChannels);
+  bool compiled() const { return compiled_; }
+  unsigned max_frames() const { return maxFrames_; }
+
+  // Audio thread: ctx.nframes <= max_frames(), ctx.channels <= maxChannels
+  void process(const DspContext& ctx);
+  const float* output(const DspNode* node) const;
+
+private:
+  struct Entry {
+    std::unique_ptr<DspNode> node;
+    bool exposed;
+  };
+  struct Edge {
+    size_t from, to;
+    unsigned input;
+  };
+  struct Step {
+    DspNode* node;
+    size_t inBegin;  // into inPtrs_
+    float* out;
+  };
+
+  size_t index_of(const DspNode* node) const; // nodes_.size() if unknown
+
+  std::vector<Entry> nodes_;
+  std::vector<Edge> edges_;
+  std::vector<Step> steps_;
+  std::vector<const float*> inPtrs_;
+  std::vector<float*> outOf_;   // per node index
+  std::vector<float> arena_;    // buffer slots, then one silent buffer
+  unsigned maxFrames_ = 0;
+  bool compiled_ = false;
+};
+
+template <class F>
+class DspSourceNode : public DspNode {
+public:
+  explicit DspSourceNode(F fn) : fn_(std::move(fn)) {}
+  void process(const DspContext& ctx, const float* const*, float* out) override {
+    for (size_t i = 0, n = static_cast<size_t>(ctx.nframes) * ctx.channels; i < n; ++i) out[i] = 0.0f;
+    fn_(ctx, out);
+  }
+
+private:
+  F fn_;
+};
+
+template <class F>
+DspNode* DspGraph::add_source(F fn) {
+  return add<DspSourceNode<F>>(std::move(fn));
+}
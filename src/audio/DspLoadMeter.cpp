@@ -0,0 +1,65 @@
+#include "DspLoadMeter.h"
+#include <algorithm>
+
+void DspLoadMeter::begin_block() {
+  blockStart_ = lastMark_ = clock::now();
+}
+
+void DspLoadMeter::mark(DspStage stage) {
+  auto now = clock::now();
+  stageNs_[static_cast<int>(stage)].fetch_add(ns(now - lastMark_), std::memory_order_relaxed);
+  lastMark_ = now;
+}
+
+void DspLoadMeter::end_block(unsigned nframes, double sampleRate) {
+  uint64_t busy = ns(clock::now() - blockStart_);
+  auto deadline = static_cast<uint64_t>(nframes * 1e9 / sampleRate);
+  busyNs_.fetch_add(busy, std::memory_order_relaxed);
+  deadlineNs_.fetch_add(deadline, std::memory_order_relaxed);
+  lastDeadlineNs_.store(deadline, std::memory_order_relaxed);
+  if (busy > maxNs_.load(std::memory_order_relaxed)) maxNs_.store(busy, std::memory_order_relaxed);
+  double frac = deadline ? static_cast<double>(busy) / static_cast<double>(deadline) : 0.0;
+  int bucket = std::min(static_cast<int>(frac / kBucketWidth), kBuckets - 1);
+  hist_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+DspLoadMeter::Report DspLoadMeter::report() {
+  Report r;
+  std::array<uint64_t, kBuckets> window{};
+  for (int i = 0; i < kBuckets; ++i) {
+    uint64_t v = hist_[i].load(std::memory_order_relaxed);
+    window[i] = v - prevHist_[i];
+    prevHist_[i] = v;
+    r.blocks += window[i];
+  }
+  // buckets at or past 100% missed the deadline
+  for (int i = static_cast<int>(1.0f / kBucketWidth); i < kBuckets; ++i) r.lateBlocks += window[i];
+
+  uint64_t busy = busyNs_.load(std::memory_order_relaxed);
+  uint64_t avail = deadlineNs_.load(std::memory_order_relaxed);
+  uint64_t dBusy = busy - prevBusyNs_, dAvail = avail - prevDeadlineNs_;
+  prevBusyNs_ = busy;
+  prevDeadlineNs_ = avail;
+  r.deadlineMs = static_cast<float>(lastDeadlineNs_.load(std::memory_order_relaxed) / 1e6);
+  r.maxMs = static_cast<float>(maxNs_.exchange(0, std::memory_order_relaxed) / 1e6);
+  r.xruns = xruns_.load(std::memory_order_relaxed);
+  if (!dAvail) return r;
+
+  r.loadPercent = static_cast<float>(100.0 * static_cast<double>(dBusy) / static_cast<double>(dAvail));
+  for (int s = 0; s < kStages; ++s) {
+    uint64_t v = stageNs_[s].load(std::memory_order_relaxed);
+    r.stagePercent[s] = static_cast<float>(100.0 * static_cast<double>(v - prevStageNs_[s]) / static_cast<double>(dAvail));
+    prevStageNs_[s] = v;
+  }
+  // p99: upper edge of the bucket holding the 99th percentile, in ms at the current deadline
+  uint64_t rank = r.blocks - r.blocks / 100, seen = 0;
+  for (int i = 0; i < kBuckets; ++i) {
+    seen += window[i];
+    if (seen >= rank) {
+      float edge = static_cast<float>(i + 1) * kBucketWidth * r.deadlineMs;
+      r.p99Ms = r.maxMs > 0.0f ? std::min(edge, r.maxMs) : edge;
+      break;
+    }
+  }
+  return r;
+}
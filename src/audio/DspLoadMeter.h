@@ -0,0 +1,58 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+enum class DspStage : int { Sequencer = 0, Synth, Send, RemoteMix, Effects, Count };
+
+// Times the audio callback against its deadline (nframes / rate). The audio
+// thread only does relaxed atomic adds; one reader (the GUI's network thread
+// or the headless report loop) diffs the cumulative counters per window, so
+// nothing is ever reset under the callback's feet.
+class DspLoadMeter {
+public:
+  static constexpr int kStages = static_cast<int>(DspStage::Count);
+  static constexpr int kBuckets = 128;            // histogram of callback time / deadline
+  static constexpr float kBucketWidth = 0.02f;    // 2% of the deadline each; last bucket is >= 254%
+
+  // Audio thread
+  void begin_block();
+  void mark(DspStage stage); // time since the previous mark (or block start) goes to `stage`
+  void end_block(unsigned nframes, double sampleRate);
+  void add_xrun() { xruns_.fetch_add(1, std::memory_order_relaxed); }
+
+  struct Report {
+    float loadPercent = 0.0f; // busy time / available time over the window
+    float p99Ms = 0.0f;       // 99th percentile callback duration
+    float maxMs = 0.0f;
+    float deadlineMs = 0.0f;
+    std::array<float, kStages> stagePercent{}; // share of the available time per stage
+    uint64_t blocks = 0;      // callbacks in the window
+    uint64_t lateBlocks = 0;  // callbacks that overran their deadline
+    uint64_t xruns = 0;       // total
+  };
+  // Reader thread: statistics since the previous call.
+  Report report();
+
+private:
+  using clock = std::chrono::steady_clock;
+  static uint64_t ns(clock::duration d) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+  }
+
+  // audio thread only
+  clock::time_point blockStart_{}, lastMark_{};
+  // written by the audio thread, read by the reader
+  std::array<std::atomic<uint64_t>, kBuckets> hist_{};
+  std::array<std::atomic<uint64_t>, kStages> stageNs_{};
+  std::atomic<uint64_t> busyNs_{0};
+  std::atomic<uint64_t> deadlineNs_{0};
+  std::atomic<uint64_t> maxNs_{0}; // reset by the reader
+  std::atomic<uint64_t> lastDeadlineNs_{0};
+  std::atomic<uint64_t> xruns_{0};
+  // reader only: previous cumulative values
+  std::array<uint64_t, kBuckets> prevHist_{};
+  std::array<uint64_t, kStages> prevStageNs_{};
+  uint64_t prevBusyNs_ = 0, prevDeadlineNs_ = 0;
+};
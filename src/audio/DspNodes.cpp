@@ -0,0 +1,244 @@
+#include "DspNodes.h"
+#include "Convolver.h"
+#include "SynthVoice.h"
+#include "Wavetable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+constexpr float kPi = 3.14159265358979323846f;
+}
+
+OscillatorNode::OscillatorNode(int wave) : tables_(&WavetableBank::get()) { set_wave(wave); }
+
+void OscillatorNode::set_wave(int wave) { wave_ = std::clamp(wave, 0, 2); }
+
+void OscillatorNode::set_phase(float degrees) {
+  float frac = std::fmod(degrees, 360.0f) / 360.0f;
+  phaseOffset_ = frac < 0.0f ? frac + 1.0f : frac;
+}
+
+void OscillatorNode::process(const DspContext& ctx, const float* const*, float* out) {
+  const float inc = static_cast<float>(freq_ / ctx.sampleRate) * std::pow(2.0f, semitones_ / 12.0f) *
+                    std::pow(2.0f, cents_ / 1200.0f);
+  const float* table =
+      tables_->data(wave_) + WavetableBank::level_offset(wave_, WavetableBank::level_for(inc));
+  constexpr auto kTableSize = static_cast<float>(WavetableBank::kTableSize);
+  const unsigned ch = ctx.channels;
+  for (unsigned i = 0; i < ctx.nframes; ++i) {
+    phase_ += inc;
+    if (phase_ >= 1.0f) phase_ -= std::floor(phase_);
+    float p = phase_ + phaseOffset_;
+    p -= std::floor(p);
+    float pos = p * kTableSize;
+    auto idx = static_cast<int32_t>(pos);
+    float frac = pos - static_cast<float>(idx);
+    float v = table[idx] + frac * (table[idx + 1] - table[idx]);
+    for (unsigned c = 0; c < ch; ++c) out[i * ch + c] = v;
+  }
+}
+
+void FilterNode::set_type(int type) {
+  type = std::clamp(type, 0, 2);
+  if (type != type_) { type_ = type; dirty_ = true; }
+}
+
+void FilterNode::set_cutoff(float hz) {
+  if (hz != cutoff_) { cutoff_ = hz; dirty_ = true; }
+}
+
+void FilterNode::set_resonance(float q) {
+  if (q != q_) { q_ = q; dirty_ = true; }
+}
+
+void FilterNode::set_slope(int stages) { stages_ = std::clamp(stages, 1, kMaxStages); }
+
+void FilterNode::process(const DspContext& ctx, const float* const* in, float* out) {
+  if (dirty_ || sr_ != ctx.sampleRate) {
+    SynthVoice::computeCoefficients(static_cast<SynthVoice::FilterType>(type_), cutoff_, q_, ctx.sampleRate, b0_, b1_,
+                                    b2_, a1_, a2_);
+    sr_ = ctx.sampleRate;
+    dirty_ = false;
+  }
+  // stages switched on by a steeper slope start from silence
+  for (; liveStages_ < stages_; ++liveStages_) state_[liveStages_] = {};
+  liveStages_ = stages_;
+
+  const unsigned ch = std::min(ctx.channels, kMaxChannels);
+  for (unsigned c = 0; c < ctx.channels; ++c) {
+    for (unsigned i = 0; i < ctx.nframes; ++i) {
+      if (c >= ch) { // beyond the filtered channels: pass through
+        out[i * ctx.channels + c] = in[0][i * ctx.channels + c];
+        continue;
+      }
+      float x = in[0][i * ctx.channels + c];
+      for (int s = 0; s < stages_; ++s) {
+        auto& st = state_[s][c];
+        float y = b0_ * x + b1_ * st[0] + b2_ * st[1] - a1_ * st[2] - a2_ * st[3];
+        st[1] = st[0];
+        st[0] = x;
+        st[3] = st[2];
+        st[2] = y;
+        x = y;
+      }
+      out[i * ctx.channels + c] = x;
+    }
+  }
+}
+
+void EnvelopeNode::gate(bool on, double sampleRate) {
+  const auto sr = static_cast<float>(sampleRate);
+  if (on) {
+    stage_ = Attack;
+    inc_ = 1.0f / std::max(1.0f, attack_ * sr);
+  } else {
+    stage_ = Release;
+    inc_ = -(level_ / std::max(1.0f, release_ * sr));
+  }
+}
+
+void EnvelopeNode::process(const DspContext& ctx, const float* const* in, float* out) {
+  const unsigned ch = ctx.channels;
+  const auto sr = static_cast<float>(ctx.sampleRate);
+  for (unsigned i = 0; i < ctx.nframes; ++i) {
+    switch (stage_) {
+      case Attack:
+        level_ += inc_;
+        if (level_ >= 1.0f) {
+          level_ = 1.0f;
+          stage_ = Decay;
+          inc_ = -(1.0f - sustain_) / std::max(1.0f, decay_ * sr);
+        }
+        break;
+      case Decay:
+        level_ += inc_;
+        if (level_ <= sustain_) {
+          level_ = sustain_;
+          stage_ = Sustain;
+          inc_ = 0.0f;
+        }
+        break;
+      case Release:
+        level_ += inc_;
+        if (level_ <= 0.0f) {
+          level_ = 0.0f;
+          stage_ = Idle;
+          inc_ = 0.0f;
+        }
+        break;
+      case Idle:
+      case Sustain:
+        break;
+    }
+    for (unsigned c = 0; c < ch; ++c) out[i * ch + c] = level_ * in[0][i * ch + c];
+  }
+}
+
+GainNode::GainNode(float gain, float pan) : gain_(gain) { set_pan(pan); }
+
+void GainNode::set_pan(float pan) {
+  float theta = (std::clamp(pan, -1.0f, 1.0f) + 1.0f) * 0.25f * kPi;
+  panL_ = std::cos(theta);
+  panR_ = std::sin(theta);
+}
+
+void GainNode::process(const DspContext& ctx, const float* const* in, float* out) {
+  const unsigned ch = ctx.channels;
+  const float n = static_cast<float>(std::max(1u, ctx.nframes));
+  if (ch == 1) {
+    float from = curMono_ < 0.0f ? gain_ : curMono_;
+    for (unsigned i = 0; i < ctx.nframes; ++i) out[i] = (from + (gain_ - from) * static_cast<float>(i + 1) / n) * in[0][i];
+    curMono_ = gain_;
+    return;
+  }
+  // pan places the first two channels; any others just get the level
+  float toL = gain_ * panL_, toR = gain_ * panR_;
+  float fromL = curL_ < 0.0f ? toL : curL_, fromR = curR_ < 0.0f ? toR : curR_;
+  for (unsigned i = 0; i < ctx.nframes; ++i) {
+    float t = static_cast<float>(i + 1) / n;
+    out[i * ch] = (fromL + (toL - fromL) * t) * in[0][i * ch];
+    out[i * ch + 1] = (fromR + (toR - fromR) * t) * in[0][i * ch + 1];
+    for (unsigned c = 2; c < ch; ++c) out[i * ch + c] = gain_ * in[0][i * ch + c];
+  }
+  curL_ = toL;
+  curR_ = toR;
+}
+
+void MixerNode::process(const DspContext& ctx, const float* const* in, float* out) {
+  const size_t n = static_cast<size_t>(ctx.nframes) * ctx.channels;
+  std::fill_n(out, n, 0.0f);
+  for (size_t k = 0; k < gains_.size(); ++k) {
+    const float g = gains_[k];
+    const float* x = in[k];
+    for (size_t i = 0; i < n; ++i) out[i] += g * x[i];
+  }
+}
+
+void DelayNode::prepare(double sampleRate, unsigned, unsigned maxChannels) {
+  lineChannels_ = std::max(1u, maxChannels);
+  lineFrames_ = std::max<size_t>(2, static_cast<size_t>(maxSeconds_ * sampleRate) + 1);
+  line_.assign(lineFrames_ * lineChannels_, 0.0f);
+  write_ = 0;
+}
+
+void DelayNode::process(const DspContext& ctx, const float* const* in, float* out) {
+  const unsigned ch = std::min(ctx.channels, lineChannels_);
+  auto delay = static_cast<size_t>(std::clamp(static_cast<double>(time_) * ctx.sampleRate, 1.0,
+                                              static_cast<double>(lineFrames_ - 1)));
+  for (unsigned i = 0; i < ctx.nframes; ++i) {
+    size_t read = (write_ + lineFrames_ - delay) % lineFrames_;
+    for (unsigned c = 0; c < ctx.channels; ++c) {
+      float x = in[0][i * ctx.channels + c];
+      if (c >= ch) {
+        out[i * ctx.channels + c] = x;
+        continue;
+      }
+      float wet = line_[read * lineChannels_ + c];
+      line_[write_ * lineChannels_ + c] = x + feedback_ * wet;
+      out[i * ctx.channels + c] = x + mix_ * (wet - x);
+    }
+    write_ = (write_ + 1) % lineFrames_;
+  }
+}
+
+ReverbNode::~ReverbNode() {
+  delete conv_;
+  delete pending_.load();
+  delete retired_.load();
+}
+
+void ReverbNode::set_impulse(std::unique_ptr<Convolver> conv) {
+  // a response the audio thread never picked up can go right away
+  delete pending_.exchange(conv.release(), std::memory_order_acq_rel);
+}
+
+void ReverbNode::collect() { delete retired_.exchange(nullptr, std::memory_order_acq_rel); }
+
+void ReverbNode::process(const DspContext& ctx, const float* const* in, float* out) {
+  // swap only once the previous response has been collected
+  if (pending_.load(std::memory_order_relaxed) && !retired_.load(std::memory_order_acquire)) {
+    if (Convolver* next = pending_.exchange(nullptr, std::memory_order_acq_rel)) {
+      retired_.store(conv_, std::memory_order_release);
+      conv_ = next;
+    }
+  }
+  const size_t n = static_cast<size_t>(ctx.nframes) * ctx.channels;
+  const float target = enabled_ && conv_ ? wet_ : 0.0f;
+  if (!conv_ || (target == 0.0f && cur_ == 0.0f)) {
+    std::copy_n(in[0], n, out);
+    return;
+  }
+  if (cur_ == 0.0f) conv_->reset(); // no stale tail from before it was muted
+  conv_->process(in[0], out, ctx.nframes, ctx.channels);
+  const float steps = static_cast<float>(std::max(1u, ctx.nframes));
+  for (unsigned i = 0; i < ctx.nframes; ++i) {
+    const float g = cur_ + (target - cur_) * static_cast<float>(i + 1) / steps;
+    for (unsigned c = 0; c < ctx.channels; ++c) {
+      const size_t k = static_cast<size_t>(i) * ctx.channels + c;
+      out[k] = in[0][k] + g * out[k];
+    }
+  }
+  cur_ = target;
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "DspGraph.h"
+
+class Convolver;
+class WavetableBank;
+
+// Building blocks for DspGraph patches. Setters are called on the audio
+// thread between blocks; a mono signal is written to every channel.
+
+// Band-limited wavetable oscillator (same tables and interpolation as SynthVoice)
+class OscillatorNode : public DspNode {
+public:
+  explicit OscillatorNode(int wave = 0);
+  void set_wave(int wave);
+  void set_freq(float hz) { freq_ = hz; }
+  void set_octave(int semitones) { semitones_ = semitones; }
+  void set_detune(float cents) { cents_ = cents; }
+  void set_phase(float degrees);
+  void process(const DspContext& ctx, const float* const* in, float* out) override;
+
+private:
+  const WavetableBank* tables_;
+  int wave_ = 0;
+  float freq_ = 220.0f;
+  int semitones_ = 0;
+  float cents_ = 0.0f;
+  float phase_ = 0.0f;
+  float phaseOffset_ = 0.0f; // 0..1
+};
+
+// RBJ biquad cascade (1-4 stages); coefficient changes keep the filter state
+class FilterNode : public DspNode {
+public:
+  static constexpr int kMaxStages = 4;
+  static constexpr unsigned kMaxChannels = 2;
+  unsigned inputs() const override { return 1; }
+  void set_type(int type);
+  void set_cutoff(float hz);
+  void set_resonance(float q);
+  void set_slope(int stages);
+  void process(const DspContext& ctx, const float* const* in, float* out) override;
+
+private:
+  int type_ = 0;
+  float cutoff_ = 1200.0f;
+  float q_ = 0.7f;
+  int stages_ = 1;
+  int liveStages_ = 1;
+  double sr_ = 0.0; // coefficients were built for this rate
+  bool dirty_ = true;
+  float b0_ = 1.0f, b1_ = 0.0f, b2_ = 0.0f, a1_ = 0.0f, a2_ = 0.0f;
+  std::array<std::array<std::array<float, 4>, kMaxChannels>, kMaxStages> state_{}; // x1 x2 y1 y2
+};
+
+// Linear ADSR applied to its input (a VCA)
+class EnvelopeNode : public DspNode {
+public:
+  unsigned inputs() const override { return 1; }
+  void set_attack(float s) { attack_ = s < 0.0f ? 0.0f : s; }
+  void set_decay(float s) { decay_ = s < 0.0f ? 0.0f : s; }
+  void set_sustain(float level) { sustain_ = level < 0.0f ? 0.0f : (level > 1.0f ? 1.0f : level); }
+  void set_release(float s) { release_ = s < 0.0f ? 0.0f : s; }
+  void gate(bool on, double sampleRate);
+  bool is_active() const { return stage_ != Idle || level_ > 1e-6f; }
+  void process(const DspContext& ctx, const float* const* in, float* out) override;
+
+private:
+  enum Stage { Idle, Attack, Decay, Sustain, Release };
+  float attack_ = 0.01f, decay_ = 0.1f, sustain_ = 0.8f, release_ = 0.2f;
+  Stage stage_ = Idle;
+  float level_ = 0.0f;
+  float inc_ = 0.0f;
+};
+
+// Level and constant-power pan; changes ramp across one block
+class GainNode : public DspNode {
+public:
+  explicit GainNode(float gain = 1.0f, float pan = 0.0f);
+  unsigned inputs() const override { return 1; }
+  void set_gain(float gain) { gain_ = gain; }
+  void set_pan(float pan);
+  void process(const DspContext& ctx, const float* const* in, float* out) override;
+
+private:
+  float gain_;
+  float panL_ = 0.70710678f, panR_ = 0.70710678f;
+  float curL_ = -1.0f, curR_ = -1.0f, curMono_ = -1.0f; // applied last block, < 0 = none yet
+};
+
+// Sums its inputs, each with its own gain
+class MixerNode : public DspNode {
+public:
+  explicit MixerNode(unsigned inputs, float gain = 1.0f) : gains_(inputs, gain) {}
+  unsigned inputs() const override { return static_cast<unsigned>(gains_.size()); }
+  void set_gain(unsigned input, float gain) {
+    if (input < gains_.size()) gains_[input] = gain;
+  }
+  void process(const DspContext& ctx, const float* const* in, float* out) override;
+
+private:
+  std::vector<float> gains_;
+};
+
+// Feedback delay (echo) with dry/wet mix
+class DelayNode : public DspNode {
+public:
+  explicit DelayNode(float maxSeconds = 2.0f) : maxSeconds_(maxSeconds) {}
+  unsigned inputs() const override { return 1; }
+  void set_time(float seconds) { time_ = seconds; }
+  void set_feedback(float fb) { feedback_ = fb < 0.0f ? 0.0f : (fb > 0.95f ? 0.95f : fb); }
+  void set_mix(float wet) { mix_ = wet < 0.0f ? 0.0f : (wet > 1.0f ? 1.0f : wet); }
+  void prepare(double sampleRate, unsigned maxFrames, unsigned maxChannels) override;
+  void process(const DspContext& ctx, const float* const* in, float* out) override;
+
+private:
+  float maxSeconds_;
+  float time_ = 0.25f;
+  float feedback_ = 0.35f;
+  float mix_ = 0.25f;
+  std::vector<float> line_; // interleaved, maxChannels wide
+  unsigned lineChannels_ = 1;
+  size_t lineFrames_ = 1;
+  size_t write_ = 0;
+};
+
+// Convolution reverb insert: adds the wet signal to its input. Responses are
+// built off the audio thread and swapped in without locks; the wet level
+// ramps across a block, and once faded out the convolver stops running.
+class ReverbNode : public DspNode {
+public:
+  ReverbNode() = default;
+  ~ReverbNode() override;
+  unsigned inputs() const override { return 1; }
+  void set_enabled(bool on) { enabled_ = on; }
+  void set_wet(float wet) { wet_ = wet < 0.0f ? 0.0f : (wet > 1.0f ? 1.0f : wet); }
+  // Control thread: queues a response for the audio thread
+  void set_impulse(std::unique_ptr<Convolver> conv);
+  // Control thread: frees responses the audio thread has swapped out
+  void collect();
+  void process(const DspContext& ctx, const float* const* in, float* out) override;
+
+private:
+  Convolver* conv_ = nullptr; // audio thread
+  std::atomic<Convolver*> pending_{nullptr};
+  std::atomic<Convolver*> retired_{nullptr};
+  bool enabled_ = false;
+  float wet_ = 0.3f;
+  float cur_ = 0.0f; // wet level reached by the last block
+};
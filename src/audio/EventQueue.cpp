@@ -0,0 +1,85 @@
+#include "EventQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+constexpr double kCorrection = 1.0 / 64.0; // per block, toward the callbacks' mean phase
+}
+
+AudioEvent AudioEvent::note_on(int note, float velocity) {
+  AudioEvent e;
+  e.type = NoteOn;
+  e.note = static_cast<uint8_t>(std::clamp(note, 0, 127));
+  e.value = std::clamp(velocity, 0.0f, 1.0f);
+  return e;
+}
+
+AudioEvent AudioEvent::note_off(int note) {
+  AudioEvent e;
+  e.type = NoteOff;
+  e.note = static_cast<uint8_t>(std::clamp(note, 0, 127));
+  return e;
+}
+
+AudioEvent AudioEvent::param(ParamId id, float value) {
+  AudioEvent e;
+  e.type = Param;
+  e.id = id;
+  e.value = value;
+  return e;
+}
+
+AudioEvent AudioEvent::transport(TransportOp op, float value) {
+  AudioEvent e;
+  e.type = Transport;
+  e.id = op;
+  e.value = value;
+  return e;
+}
+
+uint64_t EventQueue::now_ns() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool EventQueue::push(AudioEvent e) {
+  AudioEvent* slot = queue_.prepare();
+  if (!slot) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  e.timeNs = now_ns();
+  *slot = e;
+  queue_.commit();
+  return true;
+}
+
+void EventQueue::begin_block(uint64_t nowNs, unsigned nframes, double sampleRate) {
+  if (started_) windowNs_ += blockNs_; // the previous block's window is used up
+  blockNs_ = sampleRate > 0.0 ? static_cast<double>(nframes) * 1e9 / sampleRate : 0.0;
+  if (!started_) originNs_ = nowNs;
+  // one buffer period behind the callback
+  const double ideal = static_cast<double>(static_cast<int64_t>(nowNs - originNs_)) - blockNs_;
+  if (!started_ || sampleRate != sampleRate_ || std::fabs(ideal - windowNs_) > blockNs_)
+    windowNs_ = ideal;
+  else
+    windowNs_ += (ideal - windowNs_) * kCorrection;
+  sampleRate_ = sampleRate;
+  frames_ = nframes;
+  started_ = true;
+}
+
+bool EventQueue::pop(AudioEvent& e, unsigned& offset) {
+  if (!frames_) return false;
+  const AudioEvent* f = queue_.front();
+  if (!f) return false;
+  const double rel = static_cast<double>(static_cast<int64_t>(f->timeNs - originNs_)) - windowNs_;
+  if (rel >= blockNs_) return false;
+  // events from before the window (late callbacks, a restart) play at once
+  offset = rel <= 0.0 ? 0u : std::min(frames_ - 1, static_cast<unsigned>(rel * sampleRate_ * 1e-9));
+  e = *f;
+  queue_.pop();
+  return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "common/SpscQueue.h"
+
+// A control event for the audio thread
+struct AudioEvent {
+  enum Type : uint8_t { NoteOn = 0, NoteOff, Param, Transport };
+  enum ParamId : uint16_t { ParamPolyphony = 0 };
+  enum TransportOp : uint16_t { TransportPlay = 0, TransportPause, TransportStop, TransportRestart, TransportTempo };
+
+  Type     type = NoteOn;
+  uint8_t  note = 0;     // NoteOn/NoteOff: MIDI note number
+  uint16_t id = 0;       // Param: ParamId; Transport: TransportOp
+  float    value = 0.0f; // NoteOn: velocity 0..1; Param: the value; TransportTempo: BPM
+  uint64_t timeNs = 0;   // steady_clock time it happened, set by push()
+
+  static AudioEvent note_on(int note, float velocity);
+  static AudioEvent note_off(int note);
+  static AudioEvent param(ParamId id, float value);
+  static AudioEvent transport(TransportOp op, float value = 0.0f);
+};
+
+// Timestamped events from one producer thread (the GUI) to the audio
+// callback, lock-free and allocation-free. The callback maps each event's
+// time onto a frame of the block after the one it arrived in: a fixed
+// latency of one buffer instead of up to a buffer of jitter, so events
+// keep their spacing to the sample whatever the buffer size.
+class EventQueue {
+public:
+  static constexpr size_t kCapacity = 1024;
+
+  EventQueue() : queue_(kCapacity) {}
+
+  static uint64_t now_ns(); // steady_clock, the clock timeNs is on
+
+  // Producer: stamps e with now_ns(); false (and counted) when full
+  bool push(AudioEvent e);
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  // Consumer, once per callback before pop(): nowNs is when the callback
+  // started. The block covers the buffer period before the previous
+  // callback, tracked with a slow correction so steady callbacks map every
+  // event to the same latency; after a stall or rate change it restarts.
+  void begin_block(uint64_t nowNs, unsigned nframes, double sampleRate);
+  // Next event due in this block and its frame offset, in push order;
+  // false once the rest belong to later blocks
+  bool pop(AudioEvent& e, unsigned& offset);
+  // steady_clock time of this callback with the jitter smoothed out (the
+  // window's end), for scheduling against other clocks
+  uint64_t block_ns() const { return originNs_ + static_cast<uint64_t>(static_cast<int64_t>(windowNs_ + blockNs_)); }
+
+private:
+  SpscQueue<AudioEvent> queue_;
+  std::atomic<uint64_t> dropped_{0};
+  // consumer only; times relative to originNs_
+  uint64_t originNs_ = 0;
+  double windowNs_ = 0.0;     // time mapped to frame 0 of the current block
+  double blockNs_ = 0.0;      // current block's duration
+  double sampleRate_ = 0.0;
+  unsigned frames_ = 0;
+  bool started_ = false;
+};
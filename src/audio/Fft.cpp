@@ -0,0 +1,92 @@
+#include "Fft.h"
+
+#include <cmath>
+#include <utility>
+
+RealFft::RealFft(size_t size) : size_(size), half_(size / 2) {
+  bitrev_.resize(half_);
+  size_t bits = 0;
+  while ((size_t{1} << bits) < half_) ++bits;
+  for (size_t i = 0; i < half_; ++i) {
+    size_t r = 0;
+    for (size_t b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+    bitrev_[i] = r;
+  }
+  cosTab_.resize(half_);
+  sinTab_.resize(half_);
+  for (size_t k = 0; k < half_; ++k) {
+    double w = 2.0 * 3.14159265358979323846 * static_cast<double>(k) / static_cast<double>(size_);
+    cosTab_[k] = static_cast<float>(std::cos(w));
+    sinTab_[k] = static_cast<float>(std::sin(w));
+  }
+  zr_.resize(half_);
+  zi_.resize(half_);
+}
+
+void RealFft::transform(bool inverse) {
+  for (size_t i = 0; i < half_; ++i) {
+    size_t j = bitrev_[i];
+    if (j > i) {
+      std::swap(zr_[i], zr_[j]);
+      std::swap(zi_[i], zi_[j]);
+    }
+  }
+  // twiddles of the half-size transform are every other entry of the table
+  const float sign = inverse ? 1.0f : -1.0f;
+  for (size_t len = 2; len <= half_; len <<= 1) {
+    const size_t h = len / 2, step = 2 * (half_ / len);
+    for (size_t base = 0; base < half_; base += len) {
+      for (size_t j = 0; j < h; ++j) {
+        float wr = cosTab_[j * step], wi = sign * sinTab_[j * step];
+        size_t a = base + j, b = a + h;
+        float tr = zr_[b] * wr - zi_[b] * wi;
+        float ti = zr_[b] * wi + zi_[b] * wr;
+        zr_[b] = zr_[a] - tr;
+        zi_[b] = zi_[a] - ti;
+        zr_[a] += tr;
+        zi_[a] += ti;
+      }
+    }
+  }
+}
+
+void RealFft::forward(const float* in, float* re, float* im) {
+  // even samples as the real part, odd ones as the imaginary part
+  for (size_t n = 0; n < half_; ++n) {
+    zr_[n] = in[2 * n];
+    zi_[n] = in[2 * n + 1];
+  }
+  transform(false);
+  re[0] = zr_[0] + zi_[0];
+  im[0] = 0.0f;
+  re[half_] = zr_[0] - zi_[0];
+  im[half_] = 0.0f;
+  for (size_t k = 1; k < half_; ++k) {
+    // split into the spectra of the even (e) and odd (o) samples, then
+    // X[k] = E[k] + e^{-2 pi i k / size} O[k]
+    float ar = zr_[k], ai = zi_[k], br = zr_[half_ - k], bi = zi_[half_ - k];
+    float er = 0.5f * (ar + br), ei = 0.5f * (ai - bi);
+    float orr = 0.5f * (ai + bi), oi = -0.5f * (ar - br);
+    float c = cosTab_[k], s = sinTab_[k];
+    re[k] = er + c * orr + s * oi;
+    im[k] = ei + c * oi - s * orr;
+  }
+}
+
+void RealFft::inverse(const float* re, const float* im, float* out) {
+  for (size_t k = 0; k < half_; ++k) {
+    float xr = re[k], xi = im[k], yr = re[half_ - k], yi = im[half_ - k];
+    float er = 0.5f * (xr + yr), ei = 0.5f * (xi - yi);
+    float dr = xr - yr, di = xi + yi;
+    float c = cosTab_[k], s = sinTab_[k];
+    float orr = 0.5f * (dr * c - di * s), oi = 0.5f * (dr * s + di * c);
+    zr_[k] = er - oi;
+    zi_[k] = ei + orr;
+  }
+  transform(true);
+  const float scale = 1.0f / static_cast<float>(half_);
+  for (size_t n = 0; n < half_; ++n) {
+    out[2 * n] = zr_[n] * scale;
+    out[2 * n + 1] = zi_[n] * scale;
+  }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Real-input FFT of a power-of-two size, computed as a half-size complex
+// radix-2 FFT plus a split step. Spectra are split into real and imaginary
+// arrays of bins() = size / 2 + 1 entries, so multiply-accumulates on them
+// vectorize without shuffles. An instance keeps scratch space: use one per
+// thread.
+class RealFft {
+public:
+  explicit RealFft(size_t size); // size >= 4, power of two
+  size_t size() const { return size_; }
+  size_t bins() const { return size_ / 2 + 1; }
+
+  // Unnormalized forward transform of size() samples
+  void forward(const float* in, float* re, float* im);
+  // Inverse including the 1/size() scale, so inverse(forward(x)) == x
+  void inverse(const float* re, const float* im, float* out);
+
+private:
+  void transform(bool inverse); // in place on zr_/zi_
+
+  size_t size_;
+  size_t half_;                  // complex transform size
+  std::vector<size_t> bitrev_;
+  std::vector<float> cosTab_, sinTab_; // e^{-2 pi i k / size}, k < size / 2
+  std::vector<float> zr_, zi_;
+};
@@ -0,0 +1,88 @@
+#include "FileBackend.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+constexpr double kDefaultSeconds = 10.0; // when there is neither a duration nor an input file
+}
+
+FileBackend::FileBackend(std::string outputPath, std::string inputPath, double seconds)
+    : outputPath_(std::move(outputPath)), inputPath_(std::move(inputPath)), seconds_(seconds) {}
+
+unsigned FileBackend::input_channel_count() {
+  if (inputPath_.empty()) return 0;
+  if (!input_.channels && !read_wav(inputPath_, input_)) return 0;
+  return input_.channels;
+}
+
+bool FileBackend::open(const AudioStreamConfig& cfg, Process process) {
+  close();
+  cfg_ = cfg;
+  cfg_.outputChannels = std::max(1u, cfg.outputChannels);
+  cfg_.frames = std::max(1u, cfg.frames);
+  process_ = std::move(process);
+
+  hasInput_ = false;
+  if (cfg.inputChannel >= 0 && !inputPath_.empty()) {
+    if (static_cast<unsigned>(cfg.inputChannel) < input_channel_count()) {
+      hasInput_ = true;
+      if (input_.sampleRate != cfg.sampleRate) {
+        fprintf(stderr, "%s is %u Hz, played at %u Hz\n", inputPath_.c_str(), input_.sampleRate, cfg.sampleRate);
+      }
+    } else {
+      fprintf(stderr, "Input channel %d not in %s, running output only\n", cfg.inputChannel, inputPath_.c_str());
+    }
+  }
+  if (!outputPath_.empty() && !writer_.open(outputPath_, cfg_.sampleRate, cfg_.outputChannels)) return false;
+
+  double seconds = seconds_ > 0.0 ? seconds_ : (hasInput_ ? 0.0 : kDefaultSeconds);
+  totalFrames_ = seconds > 0.0 ? static_cast<uint64_t>(seconds * cfg_.sampleRate) : input_.frames();
+  rendered_.store(0);
+  in_.assign(cfg_.frames, 0.0f);
+  out_.assign(static_cast<size_t>(cfg_.frames) * cfg_.outputChannels, 0.0f);
+  open_ = true;
+  return start();
+}
+
+void FileBackend::close() {
+  stop();
+  writer_.close();
+  open_ = false;
+  hasInput_ = false;
+}
+
+bool FileBackend::start() {
+  if (!open_) return false;
+  if (rendered_.load() >= totalFrames_) return false;
+  if (running_.exchange(true)) return true;
+  if (thread_.joinable()) thread_.join(); // finished run
+  thread_ = std::thread([this]{ run(); });
+  return true;
+}
+
+bool FileBackend::stop() {
+  if (!open_) return false;
+  running_.store(false);
+  if (thread_.joinable()) thread_.join();
+  return true;
+}
+
+void FileBackend::run() {
+  const size_t inCh = std::max(1u, input_.channels);
+  uint64_t pos = rendered_.load(std::memory_order_relaxed);
+  while (running_.load(std::memory_order_relaxed) && pos < totalFrames_) {
+    auto n = static_cast<unsigned>(std::min<uint64_t>(cfg_.frames, totalFrames_ - pos));
+    if (hasInput_) {
+      for (unsigned i = 0; i < n; ++i) {
+        uint64_t f = pos + i;
+        in_[i] = f < input_.frames() ? input_.samples[f * inCh + static_cast<size_t>(cfg_.inputChannel)] : 0.0f;
+      }
+    }
+    std::fill(out_.begin(), out_.end(), 0.0f);
+    process_(hasInput_ ? in_.data() : nullptr, out_.data(), n, 0);
+    writer_.write(out_.data(), n);
+    pos += n;
+    rendered_.store(pos, std::memory_order_relaxed);
+  }
+  running_.store(false);
+}
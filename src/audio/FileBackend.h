@@ -0,0 +1,47 @@
+#pragma once
+#include "AudioBackend.h"
+#include "WavFile.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Offline device: calls the callback back to back, as fast as the CPU allows,
+// reading the input channel from a WAV file and/or recording the output to
+// one. Stops by itself after `seconds` (or at the end of the input file when
+// seconds is 0), which makes it a benchmark and regression-render driver.
+class FileBackend : public AudioBackend {
+public:
+  FileBackend(std::string outputPath, std::string inputPath = {}, double seconds = 0.0);
+  ~FileBackend() override { close(); }
+  const char* name() const override { return "file"; }
+  bool open(const AudioStreamConfig& cfg, Process process) override;
+  void close() override;
+  bool start() override;
+  bool stop() override;
+  bool is_running() const override { return running_.load(); }
+  bool has_input() const override { return hasInput_; }
+  unsigned channels() const override { return cfg_.outputChannels; }
+  unsigned sample_rate() const override { return cfg_.sampleRate; }
+  unsigned buffer_frames() const override { return cfg_.frames; }
+  unsigned input_channel_count() override;
+  uint64_t rendered_frames() const { return rendered_.load(std::memory_order_relaxed); }
+
+private:
+  void run();
+
+  std::string outputPath_, inputPath_;
+  double seconds_;
+  AudioStreamConfig cfg_;
+  Process process_;
+  bool open_ = false;
+  bool hasInput_ = false;
+  WavData input_;
+  WavWriter writer_;
+  uint64_t totalFrames_ = 0;
+  std::vector<float> in_, out_;
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> rendered_{0};
+  std::thread thread_;
+};
@@ -0,0 +1,25 @@
+#include "InputMonitor.h"
+
+#include <algorithm>
+
+InputMonitor::InputMonitor(size_t maxDelayFrames) : line_(maxDelayFrames + 1, 0.0f) {}
+
+void InputMonitor::set_delay_frames(size_t frames) {
+  delay_.store(std::min(frames, line_.size() - 1), std::memory_order_relaxed);
+}
+
+void InputMonitor::process(const float* in, float* out, unsigned nframes, unsigned channels, int mode, float gain) {
+  if (!in) return;
+  size_t len = line_.size();
+  size_t delay = mode == Compensated ? delay_.load(std::memory_order_relaxed) : 0;
+  for (unsigned i = 0; i < nframes; ++i) {
+    // keep the line running in every mode so switching modes does not replay stale audio
+    line_[write_] = in[i];
+    size_t read = write_ >= delay ? write_ - delay : write_ + len - delay;
+    if (mode != Off) {
+      float v = gain * line_[read];
+      for (unsigned c = 0; c < channels; ++c) out[i * channels + c] += v;
+    }
+    write_ = write_ + 1 == len ? 0 : write_ + 1;
+  }
+}
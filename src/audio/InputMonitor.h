@@ -0,0 +1,28 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Local monitor for the captured input. Direct mode plays the input straight
+// back (device latency only). Compensated mode delays it by roughly what the
+// rest of the band hears on top of that (packetization plus their jitter
+// buffering), so a player hears themselves in time with the remote mix.
+class InputMonitor {
+public:
+  enum Mode : int { Off = 0, Direct = 1, Compensated = 2 };
+
+  explicit InputMonitor(size_t maxDelayFrames = 48000);
+
+  // Any thread; clamped to the preallocated delay line.
+  void set_delay_frames(size_t frames);
+  size_t delay_frames() const { return delay_.load(std::memory_order_relaxed); }
+
+  // Audio thread: adds the (possibly delayed) mono input into every channel of
+  // the interleaved `out`.
+  void process(const float* in, float* out, unsigned nframes, unsigned channels, int mode, float gain);
+
+private:
+  std::vector<float> line_; // delay line, audio thread only
+  size_t write_ = 0;
+  std::atomic<size_t> delay_{0};
+};
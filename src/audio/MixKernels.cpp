@@ -0,0 +1,74 @@
+#include "MixKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LANJAM_MIX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+void mix_add(float* dst, const float* src, size_t n, float gain) {
+  size_t i = 0;
+#ifdef LANJAM_MIX_SSE2
+  __m128 g = _mm_set1_ps(gain);
+  for (; i + 8 <= n; i += 8) {
+    __m128 a = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(g, _mm_loadu_ps(src + i)));
+    __m128 b = _mm_add_ps(_mm_loadu_ps(dst + i + 4), _mm_mul_ps(g, _mm_loadu_ps(src + i + 4)));
+    _mm_storeu_ps(dst + i, a);
+    _mm_storeu_ps(dst + i + 4, b);
+  }
+#endif
+  for (; i < n; ++i) dst[i] += gain * src[i];
+}
+
+void mix_mono_to_stereo(float* dst, const float* src, size_t frames, float gain) {
+  size_t i = 0;
+#ifdef LANJAM_MIX_SSE2
+  __m128 g = _mm_set1_ps(gain);
+  for (; i + 4 <= frames; i += 4) {
+    __m128 s = _mm_mul_ps(g, _mm_loadu_ps(src + i)); // a b c d
+    __m128 lo = _mm_unpacklo_ps(s, s);                // a a b b
+    __m128 hi = _mm_unpackhi_ps(s, s);                // c c d d
+    _mm_storeu_ps(dst + 2 * i, _mm_add_ps(_mm_loadu_ps(dst + 2 * i), lo));
+    _mm_storeu_ps(dst + 2 * i + 4, _mm_add_ps(_mm_loadu_ps(dst + 2 * i + 4), hi));
+  }
+#endif
+  for (; i < frames; ++i) {
+    float s = gain * src[i];
+    dst[2 * i] += s;
+    dst[2 * i + 1] += s;
+  }
+}
+
+void mix_stereo_to_mono(float* dst, const float* src, size_t frames, float gain) {
+  float half = 0.5f * gain;
+  size_t i = 0;
+#ifdef LANJAM_MIX_SSE2
+  __m128 g = _mm_set1_ps(half);
+  for (; i + 4 <= frames; i += 4) {
+    __m128 v0 = _mm_loadu_ps(src + 2 * i);     // L0 R0 L1 R1
+    __m128 v1 = _mm_loadu_ps(src + 2 * i + 4); // L2 R2 L3 R3
+    __m128 l = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 r = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(g, _mm_add_ps(l, r))));
+  }
+#endif
+  for (; i < frames; ++i) dst[i] += half * (src[2 * i] + src[2 * i + 1]);
+}
+
+void mix_channels(float* dst, unsigned dstChannels, const float* src, unsigned srcChannels, size_t frames,
+                  float gain) {
+  if (dstChannels == srcChannels) {
+    mix_add(dst, src, frames * dstChannels, gain);
+  } else if (srcChannels == 1 && dstChannels == 2) {
+    mix_mono_to_stereo(dst, src, frames, gain);
+  } else if (srcChannels == 2 && dstChannels == 1) {
+    mix_stereo_to_mono(dst, src, frames, gain);
+  } else if (srcChannels == 1) {
+    for (size_t i = 0; i < frames; ++i) {
+      for (unsigned c = 0; c < dstChannels; ++c) dst[i * dstChannels + c] += gain * src[i];
+    }
+  } else {
+    for (size_t i = 0; i < frames; ++i) {
+      for (unsigned c = 0; c < srcChannels; ++c) dst[i * dstChannels + c % dstChannels] += gain * src[i * srcChannels + c];
+    }
+  }
+}
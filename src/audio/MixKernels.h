@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+
+// Vectorized mixing of interleaved float buffers (SSE2 on x86, scalar
+// elsewhere). All kernels accumulate into dst.
+
+// dst[i] += gain * src[i] for n samples
+void mix_add(float* dst, const float* src, size_t n, float gain);
+
+// Mono source into interleaved stereo (same signal on both sides)
+void mix_mono_to_stereo(float* dst, const float* src, size_t frames, float gain);
+
+// Interleaved stereo source folded down to mono (average of both sides)
+void mix_stereo_to_mono(float* dst, const float* src, size_t frames, float gain);
+
+// Any channel layout: picks one of the kernels above; other counts map
+// channel c to c % dstChannels.
+void mix_channels(float* dst, unsigned dstChannels, const float* src, unsigned srcChannels, size_t frames,
+                  float gain);
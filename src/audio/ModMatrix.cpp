@@ -0,0 +1,97 @@
+#include "ModMatrix.h"
+#include "VoiceKernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr float kMinSegment = 1e-4f; // seconds; keeps zero times finite
+
+float lfo_value(int shape, float phase) {
+  switch (shape) {
+    case ModMatrix::LfoTriangle:
+      return phase < 0.25f ? 4.0f * phase : phase < 0.75f ? 2.0f - 4.0f * phase : 4.0f * phase - 4.0f;
+    case ModMatrix::LfoSaw: return 2.0f * phase - 1.0f;
+    case ModMatrix::LfoSquare: return phase < 0.5f ? 1.0f : -1.0f;
+    case ModMatrix::LfoSine:
+    default: return ModMatrix::sin_cycle(phase);
+  }
+}
+} // namespace
+
+bool ModMatrix::active() const {
+  for (const auto& r : routes)
+    if (r.source != SrcNone && r.amount != 0.0f) return true;
+  return false;
+}
+
+bool ModMatrix::routes_to(int dest) const {
+  for (const auto& r : routes)
+    if (r.source != SrcNone && r.amount != 0.0f && r.dest == dest) return true;
+  return false;
+}
+
+int ModMatrix::period() const { return std::clamp(controlPeriod, kMinControlPeriod, kMaxControlPeriod); }
+
+void ModMatrix::note_on(Voice& v, float velocity, float freq) const {
+  v.lfoPhase.fill(0.0f);
+  v.env = 0.0f;
+  v.envStage = VoiceEnvAttack;
+  v.velocity = std::clamp(velocity, 0.0f, 1.0f);
+  v.key = std::log2(std::max(freq, 1.0f) / 261.625565f);
+}
+
+void ModMatrix::note_off(Voice& v) const {
+  if (v.envStage == VoiceEnvIdle) return;
+  v.envStage = VoiceEnvRelease;
+  v.envRelease = v.env / std::max(envRelease, kMinSegment);
+}
+
+void ModMatrix::advance(Voice& v, float dt) const {
+  for (int i = 0; i < kLfos; ++i) {
+    v.lfoPhase[i] += std::max(lfo[i].rate, 0.0f) * dt;
+    v.lfoPhase[i] -= static_cast<float>(static_cast<int>(v.lfoPhase[i]));
+  }
+  // linear segments like the amp envelope, stepped per control period
+  const float sus = std::clamp(envSustain, 0.0f, 1.0f);
+  switch (v.envStage) {
+    case VoiceEnvAttack:
+      v.env += dt / std::max(envAttack, kMinSegment);
+      if (v.env >= 1.0f) { v.env = 1.0f; v.envStage = VoiceEnvDecay; }
+      break;
+    case VoiceEnvDecay:
+      v.env -= dt * (1.0f - sus) / std::max(envDecay, kMinSegment);
+      if (v.env <= sus) { v.env = sus; v.envStage = VoiceEnvSustain; }
+      break;
+    case VoiceEnvRelease:
+      v.env -= dt * v.envRelease;
+      if (v.env <= 0.0f) { v.env = 0.0f; v.envStage = VoiceEnvIdle; }
+      break;
+    default: break;
+  }
+}
+
+ModMatrix::Targets ModMatrix::evaluate(const Voice& v) const {
+  Targets t;
+  for (const auto& r : routes) {
+    if (r.source == SrcNone || r.amount == 0.0f) continue;
+    float s = 0.0f;
+    bool unipolar = false;
+    switch (r.source) {
+      case SrcLfo1: s = lfo_value(lfo[0].shape, v.lfoPhase[0]); break;
+      case SrcLfo2: s = lfo_value(lfo[1].shape, v.lfoPhase[1]); break;
+      case SrcFilterEnv: s = v.env; unipolar = true; break;
+      case SrcVelocity: s = v.velocity; unipolar = true; break;
+      case SrcKey: s = v.key; break;
+      default: continue;
+    }
+    switch (r.dest) {
+      case DstCutoff: t.cutoff += r.amount * s; break;
+      case DstPitch: t.pitch += r.amount * s; break;
+      case DstPan: t.pan += r.amount * s; break;
+      case DstAmp: t.amp *= std::max(0.0f, 1.0f + r.amount * (unipolar ? s - 1.0f : s)); break;
+      default: break;
+    }
+  }
+  return t;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <algorithm>
+#include <array>
+
+// Modulation routing shared by SynthVoice and VoiceEngine. Sources are two
+// LFOs, a filter envelope, note velocity and key position; destinations are
+// cutoff (octaves), pitch (semitones), pan and amp. The sources advance and
+// the routes are summed once per control period; voices ramp linearly
+// between successive results, so a rich patch costs a handful of operations
+// per voice per period rather than per sample. Plain data, so it travels
+// inside a SynthPatch.
+struct ModMatrix {
+  static constexpr int kLfos = 2;
+  static constexpr int kRoutes = 8;
+  static constexpr int kMinControlPeriod = 8;
+  static constexpr int kMaxControlPeriod = 64;
+
+  enum Source { SrcNone = 0, SrcLfo1, SrcLfo2, SrcFilterEnv, SrcVelocity, SrcKey, kSources };
+  enum Dest { DstCutoff = 0, DstPitch, DstPan, DstAmp, kDests };
+  enum LfoShape { LfoSine = 0, LfoTriangle, LfoSaw, LfoSquare, kLfoShapes };
+
+  struct Lfo {
+    float rate = 2.0f; // Hz, restarted on each note
+    int   shape = LfoSine;
+    bool operator==(const Lfo&) const = default;
+  };
+  // Adds amount * source to the destination; amp routes scale the voice
+  // instead (see evaluate())
+  struct Route {
+    int   source = SrcNone;
+    int   dest = DstCutoff;
+    float amount = 0.0f;
+    bool operator==(const Route&) const = default;
+  };
+
+  std::array<Lfo, kLfos> lfo{};
+  // filter envelope (seconds for times, 0..1 for sustain)
+  float envAttack = 0.005f;
+  float envDecay = 0.3f;
+  float envSustain = 0.0f;
+  float envRelease = 0.3f;
+  std::array<Route, kRoutes> routes{};
+  int controlPeriod = 32; // frames at the output rate, kMinControlPeriod..kMaxControlPeriod
+  bool operator==(const ModMatrix&) const = default;
+
+  // Source state of one voice
+  struct Voice {
+    std::array<float, kLfos> lfoPhase{};
+    float env = 0.0f;
+    float envRelease = 0.0f; // level per second while releasing
+    int   envStage = 0;      // VoiceEnvStage values
+    float velocity = 1.0f;
+    float key = 0.0f;        // octaves from middle C
+  };
+
+  // Destination values for one voice
+  struct Targets {
+    float cutoff = 0.0f; // octaves
+    float pitch = 0.0f;  // semitones
+    float pan = 0.0f;    // added to the voice's pan
+    float amp = 1.0f;    // gain
+  };
+
+  bool active() const;            // any route that changes something
+  bool routes_to(int dest) const;
+  int period() const;             // controlPeriod, clamped
+
+  void note_on(Voice& v, float velocity, float freq) const;
+  void note_off(Voice& v) const;
+  // Moves LFOs and the envelope on by dt seconds
+  void advance(Voice& v, float dt) const;
+  // Sums the routes. Bipolar sources (LFOs, key) swing amp by +-amount;
+  // unipolar ones (envelope, velocity) leave it alone at 1 and lower it by
+  // amount at 0, so velocity -> amp at 1.0 is plain velocity scaling.
+  Targets evaluate(const Voice& v) const;
+
+  // sin(2 pi phase) for phase >= 0, to within 4e-6 from a folded odd
+  // polynomial; control rate math for the LFOs and modulated pan
+  static float sin_cycle(float phase) {
+    float q = phase - static_cast<float>(static_cast<int>(phase + 0.5f)); // -0.5 .. 0.5
+    if (q > 0.25f) q = 0.5f - q;
+    else if (q < -0.25f) q = -0.5f - q;
+    const float y = 6.28318530717958647692f * q, y2 = y * y;
+    return y * (1.0f + y2 * (-1.0f / 6 + y2 * (1.0f / 120 + y2 * (-1.0f / 5040 + y2 * (1.0f / 362880)))));
+  }
+  // Constant-power gains for pan -1..1 (as SynthVoice::set_pan)
+  static void pan_gains(float pan, float& l, float& r) {
+    const float phase = (std::clamp(pan, -1.0f, 1.0f) + 1.0f) * 0.0625f; // quarter turn across the field
+    l = sin_cycle(phase + 0.25f);
+    r = sin_cycle(phase);
+  }
+};
@@ -0,0 +1,66 @@
+#include "NullBackend.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+// sleep() is only good to a scheduler tick on some systems; the last stretch
+// before each deadline is spun (yielding) for sub-millisecond pacing.
+constexpr auto kSpinWindow = std::chrono::microseconds(1500);
+}
+
+bool NullBackend::open(const AudioStreamConfig& cfg, Process process) {
+  close();
+  cfg_ = cfg;
+  cfg_.outputChannels = std::max(1u, cfg.outputChannels);
+  cfg_.frames = std::max(1u, cfg.frames);
+  process_ = std::move(process);
+  hasInput_ = cfg.inputChannel >= 0;
+  in_.assign(cfg_.frames, 0.0f);
+  out_.assign(static_cast<size_t>(cfg_.frames) * cfg_.outputChannels, 0.0f);
+  open_ = true;
+  return start();
+}
+
+void NullBackend::close() {
+  stop();
+  open_ = false;
+  hasInput_ = false;
+}
+
+bool NullBackend::start() {
+  if (!open_) return false;
+  if (running_.exchange(true)) return true;
+  thread_ = std::thread([this]{ run(); });
+  return true;
+}
+
+bool NullBackend::stop() {
+  if (!open_) return false;
+  running_.store(false);
+  if (thread_.joinable()) thread_.join();
+  return true;
+}
+
+void NullBackend::run() {
+  using clock = std::chrono::steady_clock;
+  const auto period = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(static_cast<double>(cfg_.frames) / cfg_.sampleRate));
+  auto deadline = clock::now() + period;
+  unsigned status = 0;
+  while (running_.load(std::memory_order_relaxed)) {
+    std::fill(out_.begin(), out_.end(), 0.0f);
+    process_(hasInput_ ? in_.data() : nullptr, out_.data(), cfg_.frames, status);
+    status = 0;
+
+    auto now = clock::now();
+    if (now > deadline + period) { // missed a whole block: report it and re-anchor like a device would
+      late_.fetch_add(1, std::memory_order_relaxed);
+      status = OutputUnderflow;
+      deadline = now + period;
+      continue;
+    }
+    if (deadline - now > kSpinWindow) std::this_thread::sleep_until(deadline - kSpinWindow);
+    while (clock::now() < deadline) std::this_thread::yield();
+    deadline += period;
+  }
+}
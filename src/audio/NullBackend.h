@@ -0,0 +1,39 @@
+#pragma once
+#include "AudioBackend.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Sound-card-less device paced in real time by a timer thread. Output is
+// discarded and the input (if requested) is silence, so a headless box runs
+// the full client - synth, sender, jitter buffers, resamplers - at the real
+// block cadence.
+class NullBackend : public AudioBackend {
+public:
+  ~NullBackend() override { close(); }
+  const char* name() const override { return "null"; }
+  bool open(const AudioStreamConfig& cfg, Process process) override;
+  void close() override;
+  bool start() override;
+  bool stop() override;
+  bool is_running() const override { return running_.load(); }
+  bool has_input() const override { return hasInput_; }
+  unsigned channels() const override { return cfg_.outputChannels; }
+  unsigned sample_rate() const override { return cfg_.sampleRate; }
+  unsigned buffer_frames() const override { return cfg_.frames; }
+  unsigned input_channel_count() override { return 1; }
+  uint64_t late_blocks() const { return late_.load(std::memory_order_relaxed); }
+
+private:
+  void run();
+
+  AudioStreamConfig cfg_;
+  Process process_;
+  bool open_ = false;
+  bool hasInput_ = false;
+  std::vector<float> in_, out_;
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> late_{0}; // blocks the timer could not deliver on time
+  std::thread thread_;
+};
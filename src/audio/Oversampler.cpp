@@ -0,0 +1,125 @@
+#include "Oversampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LANJAM_OS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+constexpr size_t kStageTaps[] = {15, 19, 63}; // 8x->4x, 4x->2x, 2x->1x
+constexpr double kKaiserBeta = 7.86;          // about 80 dB stopband
+
+double bessel_i0(double x) {
+  double sum = 1.0, term = 1.0;
+  for (int k = 1; k < 32; ++k) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+  }
+  return sum;
+}
+} // namespace
+
+void Oversampler::Stage::design(size_t taps) {
+  half = (taps - 3) / 4;
+  const size_t center = 2 * half + 1;
+  const double pi = 3.14159265358979323846;
+  // windowed sinc at a quarter of the input rate; odd offsets from the
+  // center are the only nonzero side taps
+  g.assign(2 * half + 2, 0.0f);
+  double sum = 0.0;
+  for (size_t k = 0; k < g.size(); ++k) {
+    double d = (static_cast<double>(2 * k) - static_cast<double>(center)) / 2.0;
+    double r = (2.0 * static_cast<double>(2 * k) / static_cast<double>(taps - 1)) - 1.0;
+    double w = bessel_i0(kKaiserBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) / bessel_i0(kKaiserBeta);
+    double h = 0.5 * std::sin(pi * d) / (pi * d) * w;
+    g[k] = static_cast<float>(h);
+    sum += h;
+  }
+  for (float& v : g) v = static_cast<float>(v * 0.5 / sum); // unity gain at DC with the 0.5 center tap
+  for (auto& e : even) e.assign(2 * half + 1 + kChunk, 0.0f);
+  for (auto& o : odd) o.assign(half + 1 + kChunk, 0.0f);
+}
+
+void Oversampler::Stage::clear() {
+  for (auto& e : even) std::fill(e.begin(), e.end(), 0.0f);
+  for (auto& o : odd) std::fill(o.begin(), o.end(), 0.0f);
+}
+
+void Oversampler::Stage::run(const float* in, float* out, size_t frames, unsigned channels) {
+  const size_t evenHist = 2 * half + 1, oddHist = half + 1, taps = g.size();
+  for (unsigned c = 0; c < channels; ++c) {
+    float* e = even[c].data();
+    float* o = odd[c].data();
+    for (size_t i = 0; i < frames; ++i) {
+      e[evenHist + i] = in[(2 * i) * channels + c];
+      o[oddHist + i] = in[(2 * i + 1) * channels + c];
+    }
+    size_t i = 0;
+#ifdef LANJAM_OS_SSE2
+    // four output frames per pass, one broadcast tap at a time
+    const __m128 center = _mm_set1_ps(0.5f);
+    for (; i + 4 <= frames; i += 4) {
+      __m128 acc = _mm_mul_ps(center, _mm_loadu_ps(o + i));
+      for (size_t k = 0; k < taps; ++k)
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(g[k]), _mm_loadu_ps(e + evenHist + i - k)));
+      alignas(16) float y[4];
+      _mm_store_ps(y, acc);
+      for (size_t j = 0; j < 4; ++j) out[(i + j) * channels + c] = y[j];
+    }
+#endif
+    for (; i < frames; ++i) {
+      float acc = 0.5f * o[i];
+      for (size_t k = 0; k < taps; ++k) acc += g[k] * e[evenHist + i - k];
+      out[i * channels + c] = acc;
+    }
+    std::memmove(e, e + frames, evenHist * sizeof(float));
+    std::memmove(o, o + frames, oddHist * sizeof(float));
+  }
+}
+
+Oversampler::Oversampler() {
+  for (int s = 0; s < kStages; ++s) stages_[s].design(kStageTaps[s]);
+  for (auto& w : work_) w.assign(kChunk * kMaxChannels, 0.0f);
+}
+
+void Oversampler::set_factor(unsigned factor) {
+  factor_ = factor >= 8 ? 8 : factor >= 4 ? 4 : factor >= 2 ? 2 : 1;
+  active_ = factor_ == 8 ? 3 : factor_ == 4 ? 2 : factor_ == 2 ? 1 : 0;
+  reset();
+}
+
+double Oversampler::latency_frames() const {
+  // each stage delays by half its length at its own input rate
+  double frames = 0.0, rate = 2.0;
+  for (int s = kStages - 1; s >= kStages - active_; --s, rate *= 2.0)
+    frames += static_cast<double>(2 * stages_[s].half + 1) / rate;
+  return frames;
+}
+
+void Oversampler::reset() {
+  for (auto& s : stages_) s.clear();
+}
+
+void Oversampler::down(const float* in, float* out, size_t frames, unsigned channels) {
+  if (active_ == 0) {
+    std::copy_n(in, frames * channels, out);
+    return;
+  }
+  // the first active stage produces at most kChunk frames per pass
+  const size_t pass = kChunk * 2 / factor_;
+  for (size_t off = 0; off < frames; off += pass) {
+    const size_t n = std::min(pass, frames - off);
+    const float* src = in + off * factor_ * channels;
+    size_t len = n * factor_; // frames at the current rate
+    for (int s = kStages - active_; s < kStages; ++s) {
+      len /= 2;
+      float* dst = s == kStages - 1 ? out + off * channels : work_[s & 1].data();
+      stages_[s].run(src, dst, len, channels);
+      src = dst;
+    }
+  }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Brings audio rendered at 2x, 4x or 8x the output rate back down through a
+// cascade of polyphase half-band FIR decimators. Each stage halves the rate;
+// the last one (2x -> 1x) has the steepest filter (63 taps, flat to about
+// 0.42 of the output rate, 80 dB stopband), the earlier ones have wider
+// transition bands and get by with 19 and 15 taps. Half-band filters have
+// every other tap zero, so each stage costs (taps + 1) / 4 multiplies per
+// input frame, vectorized across output frames. Audio thread only, after
+// construction.
+class Oversampler {
+public:
+  static constexpr unsigned kMaxFactor = 8;
+  static constexpr unsigned kMaxChannels = 2;
+
+  Oversampler();
+
+  // 1, 2, 4 or 8 (others round down to one of these); clears the history
+  void set_factor(unsigned factor);
+  unsigned factor() const { return factor_; }
+  // Group delay in output frames
+  double latency_frames() const;
+  void reset();
+
+  // Reads frames * factor() interleaved frames from `in`, writes `frames`
+  // to `out` (channels <= kMaxChannels)
+  void down(const float* in, float* out, size_t frames, unsigned channels);
+
+private:
+  static constexpr size_t kChunk = 256; // output frames of the first stage per pass
+  static constexpr int kStages = 3;
+
+  // One 2:1 half-band stage: y[n] = sum_k g[k] e[n - k] + 0.5 o[n - half - 1]
+  // over the even (e) and odd (o) input streams
+  struct Stage {
+    std::vector<float> g;                               // nonzero side taps
+    size_t half = 0;                                    // (taps - 3) / 4
+    std::array<std::vector<float>, kMaxChannels> even;  // history + chunk
+    std::array<std::vector<float>, kMaxChannels> odd;
+
+    void design(size_t taps);
+    void clear();
+    // in: 2 * frames interleaved, out: frames interleaved
+    void run(const float* in, float* out, size_t frames, unsigned channels);
+  };
+
+  unsigned factor_ = 1;
+  int active_ = 0;                       // stages in use, steepest last
+  std::array<Stage, kStages> stages_;    // [0] 8x->4x, [1] 4x->2x, [2] 2x->1x
+  std::array<std::vector<float>, 2> work_; // between stages
+};
@@ -0,0 +1,101 @@
+#include "RemoteMixer.h"
+
+#include <algorithm>
+
+#include "MixKernels.h"
+
+RemoteMixer::RemoteMixer(size_t maxBlockFrames)
+    : scratch_(maxBlockFrames * kMaxWireChannels, 0.0f), maxBlockFrames_(maxBlockFrames) {
+  for (auto& s : streams_) s.playout.set_block_frames(blockFrames_.load(std::memory_order_relaxed));
+}
+
+void RemoteMixer::set_sample_rate(double sr) {
+  sr_.store(sr, std::memory_order_relaxed);
+}
+
+void RemoteMixer::retire_all() {
+  for (auto& s : streams_) {
+    if (s.state.load(std::memory_order_acquire) == Stream::Active) s.state.store(Stream::Retiring, std::memory_order_release);
+  }
+}
+
+void RemoteMixer::set_block_frames(size_t frames) {
+  blockFrames_.store(frames, std::memory_order_relaxed);
+  for (auto& s : streams_) s.playout.set_block_frames(frames);
+}
+
+RemoteMixer::Stream* RemoteMixer::find_or_claim(const PacketHeader& hdr) {
+  uint32_t senderId = hdr.sender_id;
+  Stream* freeSlot = nullptr;
+  for (auto& s : streams_) {
+    int st = s.state.load(std::memory_order_acquire);
+    if (st == Stream::Active && s.senderId.load(std::memory_order_relaxed) == senderId) return &s;
+    if (st == Stream::Free && !freeSlot) freeSlot = &s;
+  }
+  if (!freeSlot) return nullptr;
+
+  // Free slots are ignored by the audio thread, so they can be reset here
+  freeSlot->jitter.set_channels(hdr.channels);
+  freeSlot->playout.set_sample_rate(hdr.sample_rate);
+  freeSlot->playout.reset();
+  freeSlot->resampler.set_rates(hdr.sample_rate, sr_.load(std::memory_order_relaxed), hdr.channels);
+  freeSlot->sampleRate.store(hdr.sample_rate, std::memory_order_relaxed);
+  freeSlot->channels.store(hdr.channels, std::memory_order_relaxed);
+  freeSlot->senderId.store(senderId, std::memory_order_relaxed);
+  freeSlot->gain.store(1.0f, std::memory_order_relaxed);
+  freeSlot->state.store(Stream::Active, std::memory_order_release);
+  return freeSlot;
+}
+
+void RemoteMixer::on_packet(const PacketHeader& hdr, const float* samples, size_t count, uint64_t arrivalNs) {
+  if (hdr.sample_rate == 0) return;
+  Stream* s = find_or_claim(hdr);
+  if (!s) return; // more peers than slots
+  if (hdr.sample_rate != s->sampleRate.load(std::memory_order_relaxed) ||
+      hdr.channels != s->channels.load(std::memory_order_relaxed)) {
+    // layout changed (e.g. the peer switched to mono): retire the slot and
+    // let a later packet claim a fresh one with the new layout
+    s->state.store(Stream::Retiring, std::memory_order_release);
+    return;
+  }
+  s->lastSeen = std::chrono::steady_clock::now();
+  s->jitter.push(samples, count / hdr.channels);
+  s->playout.on_packet(s->jitter, hdr.seq, hdr.timestamp_ns, hdr.frames, arrivalNs);
+}
+
+void RemoteMixer::reap(std::chrono::steady_clock::time_point now) {
+  for (auto& s : streams_) {
+    if (s.state.load(std::memory_order_acquire) != Stream::Active) continue;
+    if (now - s.lastSeen > std::chrono::milliseconds(kStreamTimeoutMs)) {
+      // the audio thread acknowledges by moving the slot back to Free
+      s.state.store(Stream::Retiring, std::memory_order_release);
+    }
+  }
+}
+
+void RemoteMixer::mix(float* out, unsigned nframes, unsigned channels, float master) {
+  float* tmp = scratch_.data();
+  for (auto& s : streams_) {
+    int st = s.state.load(std::memory_order_acquire);
+    if (st == Stream::Free) continue;
+    if (st == Stream::Retiring) {
+      s.state.store(Stream::Free, std::memory_order_release);
+      continue;
+    }
+    float g = master * s.gain.load(std::memory_order_relaxed);
+    unsigned srcChannels = s.jitter.channels();
+    // scratch holds maxBlockFrames; larger callbacks are mixed in chunks
+    for (unsigned off = 0; off < nframes;) {
+      unsigned n = static_cast<unsigned>(std::min<size_t>(nframes - off, maxBlockFrames_));
+      s.resampler.process(s.jitter, tmp, n);
+      mix_channels(out + static_cast<size_t>(off) * channels, channels, tmp, srcChannels, n, g);
+      off += n;
+    }
+  }
+}
+
+size_t RemoteMixer::active_count() const {
+  size_t n = 0;
+  for (const auto& s : streams_) n += s.state.load(std::memory_order_relaxed) == Stream::Active;
+  return n;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "common/JitterBuffer.h"
+#include "common/Packet.h"
+#include "common/PlayoutController.h"
+#include "Resampler.h"
+
+// Per-sender receive streams mixed into the local output. The network thread
+// demultiplexes packets by sender id into fixed slots (claimed on the first
+// packet, retired after a timeout); the audio thread mixes every live slot
+// with its own gain. Each stream is resampled from the sender's rate and
+// clock to ours on the way out of its jitter buffer, then mixed into the
+// output layout (mono and stereo senders in either direction). Slots and
+// scratch memory are preallocated, so mixing never allocates or locks.
+class RemoteMixer {
+public:
+  static constexpr size_t kMaxPeers = 16;
+  static constexpr int kStreamTimeoutMs = 2000;
+
+  struct Stream {
+    enum State : int { Free = 0, Active = 1, Retiring = 2 };
+    std::atomic<int> state{Free};
+    std::atomic<uint32_t> senderId{0};
+    std::atomic<float> gain{1.0f};
+    JitterBuffer jitter;
+    PlayoutController playout;
+    DriftResampler resampler;
+    std::atomic<uint32_t> sampleRate{0}; // sender's nominal rate, set when claimed
+    std::atomic<uint8_t> channels{1};    // sender's layout, set when claimed
+    std::chrono::steady_clock::time_point lastSeen; // network thread only
+  };
+
+  explicit RemoteMixer(size_t maxBlockFrames = 4096);
+
+  // Local output rate; applies to streams claimed afterwards.
+  void set_sample_rate(double sr);
+  // Retires every stream so the next packets reclaim them (e.g. with a new
+  // output rate). The audio thread frees the slots on its next mix.
+  void retire_all();
+  // Local callback size, the playout controllers' smallest target; safe
+  // while the receive thread keeps feeding packets
+  void set_block_frames(size_t frames);
+
+  // Network thread
+  void on_packet(const PacketHeader& hdr, const float* samples, size_t count, uint64_t arrivalNs);
+  void reap(std::chrono::steady_clock::time_point now); // retire streams silent for kStreamTimeoutMs
+
+  // Audio thread: adds every active stream into the interleaved `out`
+  // (`channels` wide), scaled by its gain and `master`.
+  void mix(float* out, unsigned nframes, unsigned channels, float master);
+
+  // Control / stats (any thread)
+  void set_gain(size_t slot, float gain) { if (slot < kMaxPeers) streams_[slot].gain.store(gain); }
+  const Stream& stream(size_t slot) const { return streams_[slot]; }
+  size_t active_count() const;
+
+private:
+  Stream* find_or_claim(const PacketHeader& hdr);
+
+  std::array<Stream, kMaxPeers> streams_;
+  std::vector<float> scratch_; // audio thread only, maxBlockFrames * kMaxWireChannels
+  size_t maxBlockFrames_;
+  std::atomic<double> sr_{48000.0}; // written by the control thread, read on claim
+  std::atomic<size_t> blockFrames_{128}; // likewise; each playout controller keeps a copy
+};
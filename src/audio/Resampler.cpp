@@ -0,0 +1,182 @@
+#include "Resampler.h"
+#include "common/JitterBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LANJAM_RS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kMaxRatio = 4.0;        // supported nominal range 1/4 .. 4
+constexpr double kMaxCorrection = 1e-3;  // +-1000 ppm
+constexpr double kFillTau = 1.0;         // seconds, smoothing of the fill level
+constexpr double kSettleSec = 8.0;       // wait after (re)priming before measuring
+constexpr double kWindowSec = 4.0;       // drift measurement window
+constexpr double kDriftSmooth = 0.25;    // per-window weight of a new measurement
+constexpr double kKp = 2e-4;             // level pull, at 100% fill error
+constexpr int kHalf = DriftResampler::kTaps / 2;
+static_assert(DriftResampler::kTaps % 4 == 0, "taps are processed four at a time");
+}
+
+DriftResampler::DriftResampler(size_t maxBlockFrames, unsigned maxChannels)
+    : table_((kPhases + 1) * kTaps, 0.0f),
+      histCap_(static_cast<size_t>(maxBlockFrames * kMaxRatio) + 4 * kTaps),
+      maxChannels_(std::max(maxChannels, 1u)) {
+  hist_.assign(histCap_ * maxChannels_, 0.0f);
+  pull_.assign(histCap_ * maxChannels_, 0.0f);
+  set_rates(48000.0, 48000.0);
+}
+
+void DriftResampler::set_rates(double inRate, double outRate, unsigned channels) {
+  channels_ = std::clamp(channels, 1u, maxChannels_);
+  inRate_ = inRate;
+  outRate_ = outRate;
+  nominal_ = std::clamp(inRate / outRate, 1.0 / kMaxRatio, kMaxRatio);
+
+  // Blackman-windowed sinc; when downsampling the cutoff follows the output Nyquist
+  double fc = 0.45 * std::min(1.0, 1.0 / nominal_);
+  for (int p = 0; p <= kPhases; ++p) {
+    double frac = static_cast<double>(p) / kPhases;
+    float* row = &table_[static_cast<size_t>(p) * kTaps];
+    double sum = 0.0;
+    for (int k = 0; k < kTaps; ++k) {
+      double t = static_cast<double>(k - (kHalf - 1)) - frac; // tap offset from the output instant
+      double x = 2.0 * fc * t;
+      double sinc = std::fabs(x) < 1e-9 ? 1.0 : std::sin(kPi * x) / (kPi * x);
+      double w = (t + kHalf) / kTaps; // 0..1 across the window
+      double win = 0.42 - 0.5 * std::cos(2.0 * kPi * w) + 0.08 * std::cos(4.0 * kPi * w);
+      double h = 2.0 * fc * sinc * std::max(0.0, win);
+      row[k] = static_cast<float>(h);
+      sum += h;
+    }
+    for (int k = 0; k < kTaps; ++k) row[k] = static_cast<float>(row[k] / sum);
+  }
+  reset();
+}
+
+void DriftResampler::reset() {
+  std::fill(hist_.begin(), hist_.end(), 0.0f);
+  histLen_ = kTaps;
+  pos_ = kHalf - 1;
+  ratio_ = nominal_;
+  fill_ = -1.0;
+  drift_ = 0.0;
+  inFrames_ = outFrames_ = 0.0;
+  winIn_ = -1.0;
+  winOut_ = 0.0;
+  winUnderruns_ = 0;
+  ppm_.store(0.0f, std::memory_order_relaxed);
+}
+
+void DriftResampler::update_ratio(const JitterBuffer& jb, size_t nframes) {
+  double depth = static_cast<double>(jb.size());
+  double target = static_cast<double>(jb.target_frames());
+  double dt = static_cast<double>(nframes) / outRate_;
+  // the raw depth is a packet-sized sawtooth; only its slow trend is drift
+  fill_ = fill_ < 0.0 ? depth : fill_ + std::min(1.0, dt / kFillTau) * (depth - fill_);
+
+  // frames that arrived = frames played or skipped out of the buffer + what is
+  // still in it. An underrun re-primes the buffer, so measuring restarts once
+  // the smoothed level has settled again.
+  double arrived = inFrames_ + static_cast<double>(jb.compressed_frames()) + fill_;
+  uint64_t underruns = jb.underruns();
+  if (underruns != winUnderruns_) {
+    winUnderruns_ = underruns;
+    winIn_ = -1.0;
+    winOut_ = outFrames_;
+  }
+  if (winIn_ < 0.0 && outFrames_ - winOut_ >= kSettleSec * outRate_) {
+    winIn_ = arrived;
+    winOut_ = outFrames_;
+  } else if (winIn_ >= 0.0 && outFrames_ - winOut_ >= kWindowSec * outRate_) {
+    double measured = (arrived - winIn_) / ((outFrames_ - winOut_) * nominal_) - 1.0;
+    measured = std::clamp(measured, -kMaxCorrection, kMaxCorrection);
+    drift_ += kDriftSmooth * (measured - drift_);
+    winIn_ = arrived;
+    winOut_ = outFrames_;
+  }
+
+  // Measured before the pull, so the level sits half a pull above the priming target
+  double setpoint = target + 0.5 * static_cast<double>(nframes) * nominal_;
+  double err = (fill_ - setpoint) / std::max(setpoint, 64.0);
+  double corr = std::clamp(drift_ + kKp * err, -kMaxCorrection, kMaxCorrection);
+  ratio_ = nominal_ * (1.0 + corr);
+  ppm_.store(static_cast<float>(corr * 1e6), std::memory_order_relaxed);
+}
+
+void DriftResampler::process(JitterBuffer& jb, float* out, size_t nframes) {
+  update_ratio(jb, nframes);
+  const size_t ch = channels_;
+
+  // Pull exactly the input needed to reach the last output instant
+  double endPos = pos_ + static_cast<double>(nframes) * ratio_;
+  size_t needLen = std::min(static_cast<size_t>(endPos) + kHalf + 1, histCap_);
+  if (needLen > histLen_) {
+    const size_t n = needLen - histLen_;
+    inFrames_ += static_cast<double>(jb.pop(pull_.data(), n));
+    for (size_t c = 0; c < ch; ++c) {
+      float* h = hist_.data() + c * histCap_ + histLen_;
+      for (size_t i = 0; i < n; ++i) h[i] = pull_[i * ch + c];
+    }
+    histLen_ = needLen;
+  }
+  outFrames_ += static_cast<double>(nframes);
+
+  for (size_t i = 0; i < nframes; ++i) {
+    auto i0 = static_cast<size_t>(pos_);
+    float* o = out + i * ch;
+    if (i0 + kHalf >= histLen_) { // out of history (clamped pull): hold silence
+      for (size_t c = 0; c < ch; ++c) o[c] = 0.0f;
+      pos_ += ratio_;
+      continue;
+    }
+    double ph = (pos_ - static_cast<double>(i0)) * kPhases;
+    auto p0 = static_cast<size_t>(ph);
+    auto pf = static_cast<float>(ph - static_cast<double>(p0));
+    const float* h0 = &table_[p0 * kTaps];
+    const float* h1 = h0 + kTaps;
+    const float* x = &hist_[i0 + 1 - kHalf];
+#ifdef LANJAM_RS_SSE2
+    // interpolated kernel in four registers, then four-wide multiply-adds
+    // per channel with a single horizontal sum at the end
+    const __m128 f = _mm_set1_ps(pf);
+    __m128 kern[kTaps / 4];
+    for (int j = 0; j < kTaps / 4; ++j) {
+      __m128 a = _mm_loadu_ps(h0 + 4 * j);
+      kern[j] = _mm_add_ps(a, _mm_mul_ps(f, _mm_sub_ps(_mm_loadu_ps(h1 + 4 * j), a)));
+    }
+    for (size_t c = 0; c < ch; ++c, x += histCap_) {
+      __m128 acc = _mm_mul_ps(kern[0], _mm_loadu_ps(x));
+      for (int j = 1; j < kTaps / 4; ++j) acc = _mm_add_ps(acc, _mm_mul_ps(kern[j], _mm_loadu_ps(x + 4 * j)));
+      acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+      acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(1, 1, 1, 1)));
+      o[c] = _mm_cvtss_f32(acc);
+    }
+#else
+    float kernel[kTaps];
+    for (int k = 0; k < kTaps; ++k) kernel[k] = h0[k] + pf * (h1[k] - h0[k]);
+    for (size_t c = 0; c < ch; ++c, x += histCap_) {
+      float acc = 0.0f;
+      for (int k = 0; k < kTaps; ++k) acc += kernel[k] * x[k];
+      o[c] = acc;
+    }
+#endif
+    pos_ += ratio_;
+  }
+
+  // Drop history no longer reachable by the filter
+  size_t keepFrom = std::min(static_cast<size_t>(pos_) + 1 - kHalf, histLen_);
+  if (keepFrom > 0) {
+    for (size_t c = 0; c < ch; ++c) {
+      float* h = hist_.data() + c * histCap_;
+      std::memmove(h, h + keepFrom, (histLen_ - keepFrom) * sizeof(float));
+    }
+    histLen_ -= keepFrom;
+    pos_ -= static_cast<double>(keepFrom);
+  }
+}
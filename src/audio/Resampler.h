@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JitterBuffer;
+
+// Variable-ratio windowed-sinc resampler that sits between a remote stream's
+// JitterBuffer and the mix. The nominal ratio covers peers running at another
+// rate (e.g. 44.1 kHz into 48 kHz). On top of that the sender's clock drift is
+// estimated from how fast frames actually arrive versus how fast we play them,
+// plus a gentle proportional pull of the buffer level towards its target, so
+// crystal drift between sound cards never accumulates into under/overflows.
+class DriftResampler {
+public:
+  static constexpr int kTaps = 16;     // filter length (8 zero crossings per side)
+  static constexpr int kPhases = 256;  // polyphase table resolution, linearly interpolated
+
+  explicit DriftResampler(size_t maxBlockFrames = 4096, unsigned maxChannels = 2);
+
+  // Rebuilds the filter table; not real-time safe (call while the stream is idle).
+  void set_rates(double inRate, double outRate, unsigned channels = 1);
+  void reset();
+
+  // Audio thread: writes `nframes` interleaved output frames (same channel
+  // count as the buffer), pulling input from `jb`.
+  void process(JitterBuffer& jb, float* out, size_t nframes);
+
+  double nominal_ratio() const { return nominal_; }
+  float drift_ppm() const { return ppm_.load(std::memory_order_relaxed); }
+
+private:
+  void update_ratio(const JitterBuffer& jb, size_t nframes);
+
+  std::vector<float> table_;   // (kPhases + 1) rows of kTaps
+  std::vector<float> hist_;    // [channel][histCap_] input history, planar for the dot products
+  std::vector<float> pull_;    // interleaved frames popped from the buffer, before deinterleaving
+  size_t histCap_ = 0;         // frames
+  size_t histLen_ = 0;         // frames
+  unsigned maxChannels_;
+  unsigned channels_ = 1;
+  double pos_ = 0.0;           // read position in hist_ (input frames)
+  double inRate_ = 48000.0;
+  double outRate_ = 48000.0;
+  double nominal_ = 1.0;       // input frames per output frame
+  double ratio_ = 1.0;
+  double fill_ = -1.0;         // smoothed buffer depth
+  double drift_ = 0.0;         // estimated sender/receiver clock mismatch
+  double inFrames_ = 0.0;      // real frames taken from the buffer
+  double outFrames_ = 0.0;     // frames produced
+  double winIn_ = -1.0;        // arrived-frame count at the start of the window
+  double winOut_ = 0.0;
+  uint64_t winUnderruns_ = 0;
+  std::atomic<float> ppm_{0.0f};
+};
@@ -0,0 +1,125 @@
+#include "RtAudioBackend.h"
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+
+int RtAudioBackend::rt_cb(void* out, void* in, unsigned nFrames, double, RtAudioStreamStatus status, void* user) {
+  auto* self = static_cast<RtAudioBackend*>(user);
+  unsigned flags = ((status & RTAUDIO_OUTPUT_UNDERFLOW) ? OutputUnderflow : 0u) |
+                   ((status & RTAUDIO_INPUT_OVERFLOW) ? InputOverflow : 0u);
+  self->process_(self->hasInput_ ? static_cast<const float*>(in) : nullptr, static_cast<float*>(out), nFrames, flags);
+  return 0;
+}
+
+bool RtAudioBackend::open(const AudioStreamConfig& cfg, Process process) {
+  if (audio_.getDeviceCount() < 1) return false;
+  process_ = std::move(process);
+  inputDevice_ = cfg.inputDevice;
+  RtAudio::StreamParameters oparams;
+  oparams.deviceId = cfg.outputDevice ? cfg.outputDevice : audio_.getDefaultOutputDevice();
+  unsigned deviceChannels = audio_.getDeviceInfo(oparams.deviceId).outputChannels;
+  if (deviceChannels == 0) {
+    fprintf(stderr, "Device %u has no outputs\n", oparams.deviceId);
+    return false;
+  }
+  outChannels_ = std::max(1u, std::min(cfg.outputChannels, deviceChannels));
+  oparams.nChannels = outChannels_;
+  RtAudio::StreamParameters iparams;
+  hasInput_ = false;
+  if (cfg.inputChannel >= 0) {
+    if (static_cast<unsigned>(cfg.inputChannel) < input_channel_count()) {
+      iparams.deviceId = cfg.inputDevice ? cfg.inputDevice : audio_.getDefaultInputDevice();
+      iparams.nChannels = 1;
+      iparams.firstChannel = static_cast<unsigned>(cfg.inputChannel);
+      hasInput_ = true;
+    } else {
+      fprintf(stderr, "Input channel %d not available, opening output only\n", cfg.inputChannel);
+    }
+  }
+  // Minimal buffering matters more here than for playback alone: the input is
+  // both monitored locally and sent to peers.
+  RtAudio::StreamOptions options;
+  options.flags = RTAUDIO_MINIMIZE_LATENCY | RTAUDIO_SCHEDULE_REALTIME;
+  try {
+    unsigned frames = cfg.frames;
+    if (audio_.openStream(&oparams, hasInput_ ? &iparams : nullptr, RTAUDIO_FLOAT32, cfg.sampleRate, &frames,
+                          &RtAudioBackend::rt_cb, this, &options) != RTAUDIO_NO_ERROR && hasInput_) {
+      fprintf(stderr, "Duplex stream failed, opening output only\n");
+      hasInput_ = false;
+      frames = cfg.frames;
+      if (audio_.openStream(&oparams, nullptr, RTAUDIO_FLOAT32, cfg.sampleRate, &frames, &RtAudioBackend::rt_cb,
+                            this, &options) != RTAUDIO_NO_ERROR) {
+        return false;
+      }
+    }
+    if (!audio_.isStreamOpen()) return false;
+    sampleRate_ = audio_.getStreamSampleRate();
+    frames_ = frames;
+    audio_.startStream();
+    return true;
+  } catch (const std::exception& e) {
+    fprintf(stderr, "RtAudio error: %s\n", e.what());
+    hasInput_ = false;
+    return false;
+  }
+}
+
+unsigned RtAudioBackend::latency_frames() {
+  if (!audio_.isStreamOpen()) return 0;
+  long frames = audio_.getStreamLatency();
+  return frames > 0 ? static_cast<unsigned>(frames) : 0;
+}
+
+unsigned RtAudioBackend::input_channel_count() {
+  unsigned id = inputDevice_ ? inputDevice_ : audio_.getDefaultInputDevice();
+  if (id == 0) return 0;
+  return audio_.getDeviceInfo(id).inputChannels;
+}
+
+std::vector<AudioDeviceInfo> RtAudioBackend::devices() {
+  std::vector<AudioDeviceInfo> list;
+  for (unsigned id : audio_.getDeviceIds()) {
+    RtAudio::DeviceInfo rt = audio_.getDeviceInfo(id);
+    AudioDeviceInfo info;
+    info.id = rt.ID;
+    info.name = rt.name;
+    info.outputChannels = rt.outputChannels;
+    info.inputChannels = rt.inputChannels;
+    info.sampleRates = rt.sampleRates;
+    info.preferredRate = rt.preferredSampleRate;
+    info.isDefaultOutput = rt.isDefaultOutput;
+    info.isDefaultInput = rt.isDefaultInput;
+    list.push_back(std::move(info));
+  }
+  return list;
+}
+
+void RtAudioBackend::close() {
+  if (audio_.isStreamOpen()) {
+    try {
+      if (audio_.isStreamRunning()) audio_.stopStream();
+      audio_.closeStream();
+    } catch (...) {}
+  }
+  hasInput_ = false;
+}
+bool RtAudioBackend::start() {
+  if (!audio_.isStreamOpen()) return false;
+  try {
+    if (!audio_.isStreamRunning()) audio_.startStream();
+    return true;
+  } catch (const std::exception& e) {
+    fprintf(stderr, "RtAudio start error: %s\n", e.what());
+    return false;
+  }
+}
+bool RtAudioBackend::stop() {
+  if (!audio_.isStreamOpen()) return false;
+  try {
+    if (audio_.isStreamRunning()) audio_.stopStream();
+    return true;
+  } catch (const std::exception& e) {
+    fprintf(stderr, "RtAudio stop error: %s\n", e.what());
+    return false;
+  }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "AudioBackend.h"
+#include <rtaudio/RtAudio.h>
+
+// Default sound card through RtAudio (WASAPI/ASIO/CoreAudio/ALSA/JACK...)
+class RtAudioBackend : public AudioBackend {
+public:
+  const char* name() const override { return "rtaudio"; }
+  bool open(const AudioStreamConfig& cfg, Process process) override;
+  void close() override;
+  bool start() override;
+  bool stop() override;
+  bool is_running() const override { return audio_.isStreamOpen() && audio_.isStreamRunning(); }
+  bool has_input() const override { return hasInput_; }
+  unsigned channels() const override { return outChannels_; }
+  unsigned sample_rate() const override { return sampleRate_; }
+  unsigned buffer_frames() const override { return frames_; }
+  unsigned latency_frames() override; // device input + output latency reported by the driver
+  unsigned input_channel_count() override;
+  std::vector<AudioDeviceInfo> devices() override;
+
+private:
+  static int rt_cb(void* out, void* in, unsigned nFrames, double streamTime,
+                   RtAudioStreamStatus status, void* userData);
+  RtAudio audio_;
+  Process process_;
+  bool hasInput_ = false;
+  unsigned outChannels_ = 1;
+  unsigned sampleRate_ = 48000;
+  unsigned frames_ = 128;
+  unsigned inputDevice_ = 0; // last requested, 0 = default
+};
@@ -0,0 +1,106 @@
+#include "RtWorkerPool.h"
+#include "common/RtCheck.h"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define LANJAM_CPU_RELAX() _mm_pause()
+#else
+#define LANJAM_CPU_RELAX() std::this_thread::yield()
+#endif
+
+namespace {
+// Best effort: pin to one core and raise priority; failures (no privileges,
+// fewer cores) just leave the thread as it is
+void make_realtime(unsigned core) {
+  unsigned cores = std::thread::hardware_concurrency();
+#if defined(_WIN32)
+  if (cores > 1 && core < 64) SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << (core % cores));
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#elif defined(__linux__)
+  if (cores > 1) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % cores, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  }
+  sched_param sp{};
+  sp.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+  pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+#else
+  (void)core;
+  (void)cores;
+#endif
+}
+}
+
+RtWorkerPool::RtWorkerPool(unsigned workers) {
+  threads_.reserve(workers);
+  for (unsigned i = 0; i < workers; ++i) threads_.emplace_back([this, i] { worker_main(i); });
+}
+
+RtWorkerPool::~RtWorkerPool() {
+  quit_.store(true);
+  generation_.fetch_add(1, std::memory_order_release);
+  generation_.notify_all();
+  for (auto& t : threads_) t.join();
+}
+
+void RtWorkerPool::run(unsigned tasks, TaskFn fn, void* ctx) {
+  if (tasks == 0) return;
+  tasks = std::min(tasks, 0xffffu);
+  fn_ = fn;
+  ctx_ = ctx;
+  remaining_.store(tasks, std::memory_order_relaxed);
+  uint32_t job = generation_.load(std::memory_order_relaxed) + 1;
+  next_.store(static_cast<uint64_t>(job) << 32 | static_cast<uint64_t>(tasks) << 16, std::memory_order_release);
+  generation_.store(job, std::memory_order_release);
+  if (tasks > 1 && !threads_.empty()) generation_.notify_all();
+  drain(job);
+  // the rest is already running; wait for it without yielding the core
+  while (remaining_.load(std::memory_order_acquire) != 0) LANJAM_CPU_RELAX();
+}
+
+void RtWorkerPool::drain(uint32_t job) {
+  uint64_t v = next_.load(std::memory_order_acquire);
+  for (;;) {
+    if (static_cast<uint32_t>(v >> 32) != job || (v & 0xffff) >= ((v >> 16) & 0xffff)) return;
+    if (!next_.compare_exchange_weak(v, v + 1, std::memory_order_acq_rel, std::memory_order_acquire)) continue;
+    fn_(ctx_, static_cast<unsigned>(v & 0xffff));
+    remaining_.fetch_sub(1, std::memory_order_acq_rel);
+    v = next_.load(std::memory_order_acquire);
+  }
+}
+
+void RtWorkerPool::worker_main(unsigned index) {
+  make_realtime(index + 1); // core 0 is left to the OS and the device thread
+  uint32_t seen = generation_.load(std::memory_order_acquire);
+  while (!quit_.load(std::memory_order_relaxed)) {
+    auto spinUntil = std::chrono::steady_clock::now() + std::chrono::microseconds(kSpinMicros);
+    uint32_t gen = generation_.load(std::memory_order_acquire);
+    while (gen == seen && std::chrono::steady_clock::now() < spinUntil) {
+      LANJAM_CPU_RELAX();
+      gen = generation_.load(std::memory_order_acquire);
+    }
+    if (gen == seen) {
+      generation_.wait(seen, std::memory_order_acquire);
+      continue;
+    }
+    seen = gen;
+    if (quit_.load(std::memory_order_relaxed)) break;
+    RtScope rt;
+    drain(gen);
+  }
+}
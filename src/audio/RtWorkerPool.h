@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Helper threads for the audio callback. run() hands out `tasks` task
+// indices to the calling thread and the workers and returns once all are
+// done; it never allocates or locks. Between jobs a worker spins for
+// kSpinMicros (so back-to-back callbacks wake it within a few hundred ns)
+// and then sleeps on an atomic wait, so an idle stream costs no CPU.
+// Workers are pinned to cores 1..n and asked for real-time priority where
+// the OS allows. Which thread runs a task is not fixed, so results must
+// only depend on the task index.
+class RtWorkerPool {
+public:
+  using TaskFn = void (*)(void* ctx, unsigned task);
+  static constexpr int kSpinMicros = 500;
+
+  explicit RtWorkerPool(unsigned workers);
+  ~RtWorkerPool();
+  RtWorkerPool(const RtWorkerPool&) = delete;
+  RtWorkerPool& operator=(const RtWorkerPool&) = delete;
+
+  unsigned workers() const { return static_cast<unsigned>(threads_.size()); }
+
+  // Audio thread; one job at a time
+  void run(unsigned tasks, TaskFn fn, void* ctx);
+
+private:
+  void worker_main(unsigned index);
+  void drain(uint32_t job); // takes tasks of `job` until none are left
+
+  std::vector<std::thread> threads_;
+  std::atomic<bool> quit_{false};
+  alignas(64) std::atomic<uint32_t> generation_{0}; // job id, bumped per run()
+  TaskFn fn_ = nullptr;
+  void* ctx_ = nullptr;
+  // job id << 32 | task count << 16 | next task index, so a worker still
+  // finishing one job can never claim a task of the next
+  alignas(64) std::atomic<uint64_t> next_{0};
+  alignas(64) std::atomic<unsigned> remaining_{0}; // tasks not yet finished
+};
@@ -2,9 +2,17 @@
 
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
 
 namespace {
 constexpr float kPi = 3.14159265358979323846f;
+
+// constant power: equal loudness anywhere in the field, -3 dB per side at center
+void pan_gains(float pan, float& l, float& r) {
+  float theta = (std::clamp(pan, -1.0f, 1.0f) + 1.0f) * 0.25f * kPi;
+  l = std::cos(theta);
+  r = std::sin(theta);
+}
 }
 
 void SynthVoice::set_osc_wave(int index, int w) {
@@ -35,9 +43,12 @@ void SynthVoice::computeCoefficients(FilterType type, float cutoff, float q, dou
   cutoff = std::clamp(cutoff, 20.0f, sr_f * 0.45f);
   q = std::clamp(q, 0.1f, 10.0f);
 
-  float w0 = 2.0f * kPi * cutoff / sr_f;
-  float cosw = std::cos(w0);
-  float sinw = std::sin(w0);
+  // cos and sin from the half-angle tangent, cheap enough to run per voice
+  // at control rate
+  float t = fastTan(kPi * cutoff / sr_f);
+  float inv = 1.0f / (1.0f + t * t);
+  float cosw = (1.0f - t * t) * inv;
+  float sinw = 2.0f * t * inv;
   float alpha = sinw / (2.0f * q);
 
   float a0 = 1.0f + alpha;
@@ -74,15 +85,63 @@ void SynthVoice::computeCoefficients(FilterType type, float cutoff, float q, dou
   a2 = a2_tmp * invA0;
 }
 
+void SynthVoice::computeSvfCoefficients(FilterType type, float cutoff, float q, double sr,
+                                        float& g, float& k, float& in, float& band, float& low) {
+  float sr_f = static_cast<float>(sr);
+  cutoff = std::clamp(cutoff, 20.0f, sr_f * 0.45f);
+  q = std::clamp(q, 0.1f, 10.0f);
+  g = fastTan(kPi * cutoff / sr_f);
+  k = 1.0f / q;
+  switch (type) {
+    case FilterType::Low: in = 0.0f; band = 0.0f; low = 1.0f; break;
+    case FilterType::Band: in = 0.0f; band = 1.0f; low = 0.0f; break;
+    case FilterType::High:
+    default: in = 1.0f; band = -1.0f; low = -1.0f; break; // x - k bp - lp
+  }
+}
+
+void SynthVoice::set_filter_mode(int mode) {
+  auto m = static_cast<FilterMode>(std::clamp(mode, 0, 1));
+  if (m == filterMode_) return;
+  filterMode_ = m;
+  liveStages_ = 0; // the other structure's state means nothing here
+  svfG_ = -1.0f;
+  coeffDirty_ = true;
+}
+
 void SynthVoice::updateCoefficients() {
-  computeCoefficients(filterType_, cutoff_, resonance_, sr_, b0_, b1_, b2_, a1_, a2_);
-  for (auto& stage : stages_) {
-    stage = StageState{};
+  // filter state is kept, so parameter changes don't click
+  if (filterMode_ == FilterMode::Svf) {
+    computeSvfCoefficients(filterType_, cutoff_, resonance_, sr_, svfGTarget_, svfKTarget_, svfIn_, svfBand_, svfLow_);
+    if (svfG_ < 0.0f) { svfG_ = svfGTarget_; svfK_ = svfKTarget_; }
+  } else {
+    computeCoefficients(filterType_, cutoff_, resonance_, sr_, b0_, b1_, b2_, a1_, a2_);
   }
+  kernel_ = specialized_ ? selectKernel(filterMode_, filterType_, filterStages_)
+                         : &SynthVoice::renderSpan<kAnyFilter, kAnyFilter, kAnyFilter>;
   coeffDirty_ = false;
 }
 
-void SynthVoice::note_on() {
+SynthVoice::RenderFn SynthVoice::selectKernel(FilterMode mode, FilterType type, int stages) {
+  // the biquad's structure is the same for every type
+  static constexpr RenderFn biquad[4] = {
+      &SynthVoice::renderSpan<Biquad, kAnyFilter, 1>, &SynthVoice::renderSpan<Biquad, kAnyFilter, 2>,
+      &SynthVoice::renderSpan<Biquad, kAnyFilter, 3>, &SynthVoice::renderSpan<Biquad, kAnyFilter, 4>};
+  static constexpr RenderFn svf[3][4] = {
+      {&SynthVoice::renderSpan<Svf, Low, 1>, &SynthVoice::renderSpan<Svf, Low, 2>,
+       &SynthVoice::renderSpan<Svf, Low, 3>, &SynthVoice::renderSpan<Svf, Low, 4>},
+      {&SynthVoice::renderSpan<Svf, Band, 1>, &SynthVoice::renderSpan<Svf, Band, 2>,
+       &SynthVoice::renderSpan<Svf, Band, 3>, &SynthVoice::renderSpan<Svf, Band, 4>},
+      {&SynthVoice::renderSpan<Svf, High, 1>, &SynthVoice::renderSpan<Svf, High, 2>,
+       &SynthVoice::renderSpan<Svf, High, 3>, &SynthVoice::renderSpan<Svf, High, 4>},
+  };
+  const int st = std::clamp(stages, 1, 4) - 1;
+  return mode == Svf ? svf[type][st] : biquad[st];
+}
+
+void SynthVoice::note_on(float velocity) {
+  mod_.note_on(modVoice_, velocity, freq_);
+  modFresh_ = true;
   envStage_ = EnvAttack;
   // calculate per-sample increment for attack
   float attackSamples = std::max(1.0f, envAttack_ * static_cast<float>(sr_));
@@ -90,6 +149,7 @@ void SynthVoice::note_on() {
 }
 
 void SynthVoice::note_off() {
+  mod_.note_off(modVoice_);
   // transition to release
   envStage_ = EnvRelease;
   float releaseSamples = std::max(1.0f, envRelease_ * static_cast<float>(sr_));
@@ -97,79 +157,207 @@ void SynthVoice::note_off() {
   envInc_ = - (envLevel_ / releaseSamples);
 }
 
-void SynthVoice::render(float* out, unsigned nframes) {
-  if (coeffDirty_) updateCoefficients();
+void SynthVoice::set_pan(float pan) {
+  pan_ = pan;
+  pan_gains(pan, panL_, panR_);
+}
 
-  const float baseInc = static_cast<float>(freq_ / sr_);
+template <int Mode, int Type, int Stages>
+void SynthVoice::renderSpan(Span& sp, float* out, unsigned begin, unsigned end, unsigned channels) {
+  const bool svf = Mode == kAnyFilter ? filterMode_ == FilterMode::Svf : Mode == FilterMode::Svf;
+  const int stages = Stages == kAnyFilter ? filterStages_ : Stages;
+  constexpr auto kTableSize = static_cast<float>(WavetableBank::kTableSize);
+  // state in locals: stores to `out` can't alias them, so with the stage
+  // count fixed they stay in registers for the whole span
+  auto inc = sp.inc;
+  const auto incStep = sp.incStep;
+  float gainL = sp.gainL, gainR = sp.gainR, g = sp.g, k = sp.k;
+  auto phases = oscPhase_;
+  const auto phaseOffsets = oscPhaseOffset_;
+  auto filt = stages_;
+  float envLevel = envLevel_, envInc = envInc_;
+  EnvStage envStage = envStage_;
 
-  for (unsigned i = 0; i < nframes; ++i) {
+  for (unsigned i = begin; i < end; ++i) {
     float oscSum = 0.0f;
     for (int osc = 0; osc < kNumOsc; ++osc) {
-      float inc = baseInc * std::pow(2.0f, oscOctave_[osc] / 12.0f) * std::pow(2.0f, oscDetune_[osc] / 1200.0f);
-      oscPhase_[osc] += inc;
-      if (oscPhase_[osc] >= 1.0f) oscPhase_[osc] -= std::floor(oscPhase_[osc]);
-      float phase = oscPhase_[osc] + oscPhaseOffset_[osc];
-      phase -= std::floor(phase);
-
-      float oscValue = 0.0f;
-      switch (oscWave_[osc]) {
-        case Square: oscValue = (phase < 0.5f) ? 1.0f : -1.0f; break;
-        case Sine:   oscValue = std::sinf(2.0f * kPi * phase); break;
-        case Saw:
-        default:     oscValue = 2.0f * phase - 1.0f; break;
-      }
-      oscSum += oscValue;
+      inc[osc] += incStep[osc];
+      // phases are never negative, so truncation is floor, without a branch or libm call
+      phases[osc] += inc[osc];
+      phases[osc] -= static_cast<float>(static_cast<int32_t>(phases[osc]));
+      float phase = phases[osc] + phaseOffsets[osc];
+      phase -= static_cast<float>(static_cast<int32_t>(phase));
+
+      // linear interpolation between table samples (the guard sample covers idx + 1)
+      float pos = phase * kTableSize;
+      auto idx = static_cast<int32_t>(pos);
+      float frac = pos - static_cast<float>(idx);
+      const float* t = sp.table[osc] + idx;
+      oscSum += t[0] + frac * (t[1] - t[0]);
     }
     float sample = oscSum / static_cast<float>(kNumOsc);
 
     float stageInput = sample;
-    for (int s = 0; s < filterStages_; ++s) {
-      auto& st = stages_[s];
-      float y = b0_ * stageInput + b1_ * st.x1 + b2_ * st.x2 - a1_ * st.y1 - a2_ * st.y2;
-      st.x2 = st.x1;
-      st.x1 = stageInput;
-      st.y2 = st.y1;
-      st.y1 = y;
-      stageInput = y;
+    if (svf) {
+      g += sp.dg;
+      k += sp.dk;
+      const float sa1 = 1.0f / (1.0f + g * (g + k)), sa2 = g * sa1;
+      for (int s = 0; s < stages; ++s) {
+        auto& st = filt[s];
+        float v1 = sa1 * st.ic1 + sa2 * (stageInput - st.ic2); // band-pass
+        float v2 = st.ic2 + g * v1;                            // low-pass
+        st.ic1 = 2.0f * v1 - st.ic1;
+        st.ic2 = 2.0f * v2 - st.ic2;
+        if constexpr (Type == FilterType::Low) stageInput = v2;
+        else if constexpr (Type == FilterType::Band) stageInput = k * v1;
+        else if constexpr (Type == FilterType::High) stageInput = stageInput - k * v1 - v2;
+        else stageInput = svfIn_ * stageInput + svfBand_ * k * v1 + svfLow_ * v2;
+      }
+    } else {
+      for (int s = 0; s < stages; ++s) {
+        auto& st = filt[s];
+        float y = sp.b0 * stageInput + sp.b1 * st.x1 + sp.b2 * st.x2 - sp.a1 * st.y1 - sp.a2 * st.y2;
+        st.x2 = st.x1;
+        st.x1 = stageInput;
+        st.y2 = st.y1;
+        st.y1 = y;
+        stageInput = y;
+      }
     }
 
     // Envelope processing (per-sample linear ramps)
-    switch (envStage_) {
+    switch (envStage) {
       case EnvIdle:
-        // keep envLevel_ at 0
+        // keep envLevel at 0
         break;
       case EnvAttack: {
-        envLevel_ += envInc_;
-        if (envLevel_ >= 1.0f) {
-          envLevel_ = 1.0f;
-          envStage_ = EnvDecay;
+        envLevel += envInc;
+        if (envLevel >= 1.0f) {
+          envLevel = 1.0f;
+          envStage = EnvDecay;
           float decaySamples = std::max(1.0f, envDecay_ * static_cast<float>(sr_));
           // amount to go from 1.0 -> sustain
-          envInc_ = -(1.0f - envSustain_) / decaySamples;
+          envInc = -(1.0f - envSustain_) / decaySamples;
         }
       } break;
       case EnvDecay: {
-        envLevel_ += envInc_;
-        if (envLevel_ <= envSustain_) {
-          envLevel_ = envSustain_;
-          envStage_ = EnvSustain;
-          envInc_ = 0.0f;
+        envLevel += envInc;
+        if (envLevel <= envSustain_) {
+          envLevel = envSustain_;
+          envStage = EnvSustain;
+          envInc = 0.0f;
         }
       } break;
       case EnvSustain:
         // hold at sustain
         break;
       case EnvRelease: {
-        envLevel_ += envInc_;
-        if (envLevel_ <= 0.0f) {
-          envLevel_ = 0.0f;
-          envStage_ = EnvIdle;
-          envInc_ = 0.0f;
+        envLevel += envInc;
+        if (envLevel <= 0.0f) {
+          envLevel = 0.0f;
+          envStage = EnvIdle;
+          envInc = 0.0f;
         }
       } break;
     }
 
-    out[i] += 0.15f * envLevel_ * stageInput;
+    gainL += sp.dgL;
+    gainR += sp.dgR;
+    float v = 0.15f * envLevel * stageInput;
+    if (channels == 1) {
+      out[i] += gainL * v;
+    } else {
+      out[i * channels] += gainL * v;
+      out[i * channels + 1] += gainR * v;
+    }
+  }
+  oscPhase_ = phases;
+  stages_ = filt;
+  envLevel_ = envLevel;
+  envInc_ = envInc;
+  envStage_ = envStage;
+  sp.inc = inc;
+  sp.gainL = gainL;
+  sp.gainR = gainR;
+  sp.g = g;
+  sp.k = k;
+}
+
+void SynthVoice::render(float* out, unsigned nframes, unsigned channels) {
+  if (coeffDirty_) updateCoefficients();
+  // stages switched on by a steeper slope start from silence, not stale state
+  for (; liveStages_ < filterStages_; ++liveStages_) stages_[liveStages_] = StageState{};
+  liveStages_ = filterStages_;
+  const bool svf = filterMode_ == FilterMode::Svf;
+  const bool mod = mod_.active();
+  const bool modCutoff = mod && mod_.routes_to(ModMatrix::DstCutoff);
+  const bool modPan = mod && mod_.routes_to(ModMatrix::DstPan);
+
+  // increments once per block; modulation scales them per control period
+  const float baseInc = static_cast<float>(freq_ / sr_);
+  std::array<float, kNumOsc> base;
+  for (int osc = 0; osc < kNumOsc; ++osc)
+    base[osc] = baseInc * std::pow(2.0f, oscOctave_[osc] / 12.0f) * std::pow(2.0f, oscDetune_[osc] / 1200.0f);
+  // without routes the whole block is one period
+  const unsigned period = mod ? static_cast<unsigned>(mod_.period()) : std::max(nframes, 1u);
+
+  for (unsigned off = 0; off < nframes; off += period) {
+    const unsigned n = std::min(period, nframes - off);
+    const float step = 1.0f / static_cast<float>(n);
+
+    // modulation targets for the end of this period
+    ModMatrix::Targets mt;
+    if (mod) {
+      mod_.advance(modVoice_, static_cast<float>(n / sr_));
+      mt = mod_.evaluate(modVoice_);
+    }
+    const float ratio = mt.pitch != 0.0f ? std::exp2(mt.pitch / 12.0f) : 1.0f;
+    float gL = panL_, gR = panR_;
+    if (modPan) ModMatrix::pan_gains(pan_ + mt.pan, gL, gR);
+    if (channels == 1) { gL = 1.0f; gR = 0.0f; }
+    gL *= mt.amp;
+    gR *= mt.amp;
+    float gTarget = svfGTarget_, kTarget = svfKTarget_;
+    float b0 = b0_, b1 = b1_, b2 = b2_, a1 = a1_, a2 = a2_;
+    if (modCutoff) {
+      const float fc = cutoff_ * std::exp2(mt.cutoff);
+      float in, band, low;
+      if (svf) computeSvfCoefficients(filterType_, fc, resonance_, sr_, gTarget, kTarget, in, band, low);
+      else computeCoefficients(filterType_, fc, resonance_, sr_, b0, b1, b2, a1, a2);
+    }
+    if (modFresh_) {
+      modRatio_ = ratio;
+      modGainL_ = gL;
+      modGainR_ = gR;
+      if (svf) { svfG_ = gTarget; svfK_ = kTarget; }
+      modFresh_ = false;
+    }
+
+    // everything ramps linearly from the last period's values
+    Span sp;
+    for (int osc = 0; osc < kNumOsc; ++osc) {
+      sp.inc[osc] = base[osc] * modRatio_;
+      sp.incStep[osc] = base[osc] * (ratio - modRatio_) * step;
+      sp.table[osc] = tables_->data(oscWave_[osc]) +
+                      WavetableBank::level_offset(oscWave_[osc],
+                                                  WavetableBank::level_for(base[osc] * std::max(ratio, modRatio_)));
+    }
+    sp.gainL = modGainL_;
+    sp.gainR = modGainR_;
+    sp.dgL = (gL - modGainL_) * step;
+    sp.dgR = (gR - modGainR_) * step;
+    // SVF coefficients move to their targets across the period too
+    sp.g = svfG_;
+    sp.k = svfK_;
+    sp.dg = (gTarget - svfG_) * step;
+    sp.dk = (kTarget - svfK_) * step;
+    sp.b0 = b0; sp.b1 = b1; sp.b2 = b2; sp.a1 = a1; sp.a2 = a2;
+    (this->*kernel_)(sp, out, off, off + n, channels);
+
+    modRatio_ = ratio;
+    modGainL_ = gL;
+    modGainR_ = gR;
+    if (svf) { svfG_ = gTarget; svfK_ = kTarget; }
   }
 }
 
@@ -4,14 +4,25 @@
 #include <cmath>
 #include <algorithm>
 
+#include "ModMatrix.h"
+#include "Wavetable.h"
+
 class SynthVoice {
 public:
-    void set_sample_rate(double sr) { sr_ = sr; coeffDirty_ = true; }
+    void set_sample_rate(double sr) { sr_ = sr; coeffDirty_ = true; svfG_ = -1.0f; }
     void set_freq(float hz) { freq_ = hz; }
-    void render(float* out, unsigned nframes);
+    // Adds into interleaved `out`; with 2+ channels the voice is panned onto the first two.
+    void render(float* out, unsigned nframes, unsigned channels = 1);
+    // -1 (left) .. +1 (right), constant power
+    void set_pan(float pan);
     
     enum Wave { Saw=0, Square=1, Sine=2 };
     enum FilterType { Low=0, Band=1, High=2 };
+    // Biquad: RBJ cookbook sections, coefficients rebuilt when cutoff or Q
+    // change. Svf: zero-delay-feedback (TPT) state-variable sections with the
+    // same responses, whose coefficients ramp per sample, so cutoff and Q can
+    // move every sample without trig or zipper noise.
+    enum FilterMode { Biquad=0, Svf=1 };
 
     void set_osc_wave(int index, int w);
     void set_osc_octave(int index, int semitones);
@@ -22,9 +33,26 @@ public:
     void set_resonance(float r) { resonance_ = r; coeffDirty_ = true; }
     void set_filter_type(int type) { filterType_ = static_cast<FilterType>(std::clamp(type, 0, 2)); coeffDirty_ = true; }
     void set_filter_slope(int stages) { filterStages_ = std::clamp(stages, 1, 4); coeffDirty_ = true; }
+    void set_filter_mode(int mode);
+    // Modulation routes, evaluated every mod.period() frames
+    void set_mod_matrix(const ModMatrix& mod) { mod_ = mod; }
+    // On (default): a sample loop compiled for the current filter mode, type
+    // and slope, picked when they change. Off: the generic loop.
+    void set_specialized_kernels(bool on) { specialized_ = on; coeffDirty_ = true; }
 
     static void computeCoefficients(FilterType type, float cutoff, float q, double sr,
                                     float& b0, float& b1, float& b2, float& a1, float& a2);
+    // SVF section for the same cutoff/Q: g = tan(pi fc / sr), k = 1 / Q. The
+    // output is in * x + band * k * bp + low * lp, which gives the low, band
+    // (0 dB peak) and high responses of computeCoefficients().
+    static void computeSvfCoefficients(FilterType type, float cutoff, float q, double sr,
+                                       float& g, float& k, float& in, float& band, float& low);
+    // tan(x) for 0 <= x < pi/2 from a [5/4] Pade approximant; within
+    // 3e-5 relative up to 0.45 of the sample rate, one division
+    static float fastTan(float x) {
+        float x2 = x * x;
+        return x * (945.0f + x2 * (-105.0f + x2)) / (945.0f + x2 * (-420.0f + 15.0f * x2));
+    }
 
 private:
     struct StageState {
@@ -32,11 +60,29 @@ private:
         float x2 = 0.0f;
         float y1 = 0.0f;
         float y2 = 0.0f;
+        float ic1 = 0.0f; // SVF integrator states
+        float ic2 = 0.0f;
     };
 
     void updateCoefficients();
 
     static constexpr int kNumOsc = 3;
+    static constexpr int kAnyFilter = -1;
+
+    // One control period's ramps, advanced by the sample loop
+    struct Span {
+        std::array<float, kNumOsc> inc, incStep;
+        std::array<const float*, kNumOsc> table;
+        float gainL, gainR, dgL, dgR;
+        float g, k, dg, dk;       // SVF
+        float b0, b1, b2, a1, a2; // biquad
+    };
+    // The sample loop for frames [begin, end). Mode, Type (SVF output) and
+    // Stages fix the filter at compile time; kAnyFilter reads the member.
+    template <int Mode, int Type, int Stages>
+    void renderSpan(Span& sp, float* out, unsigned begin, unsigned end, unsigned channels);
+    using RenderFn = void (SynthVoice::*)(Span&, float*, unsigned, unsigned, unsigned);
+    static RenderFn selectKernel(FilterMode mode, FilterType type, int stages);
 
     double sr_ = 48000.0;
     float freq_ = 220.0f;
@@ -46,11 +92,33 @@ private:
     std::array<int,   kNumOsc> oscOctave_{{0,0,0}}; // semitone offsets
     std::array<float, kNumOsc> oscDetune_{{0.0f,0.0f,0.0f}}; // cents
     std::array<float, kNumOsc> oscPhaseOffset_{{0.0f,0.0f,0.0f}}; // 0..1
+    const WavetableBank* tables_ = &WavetableBank::get(); // built with the first voice
+
+    float pan_ = 0.0f;
+    float panL_ = 0.70710678f;
+    float panR_ = 0.70710678f;
 
     float cutoff_ = 1200.0f;
     float resonance_ = 0.7f;
     FilterType filterType_ = FilterType::Low;
     int filterStages_ = 1;
+    int liveStages_ = 1; // stages whose state is current
+    FilterMode filterMode_ = FilterMode::Biquad;
+    // SVF: current g/k (ramped to the targets over the next block), < 0 = jump
+    float svfG_ = -1.0f, svfK_ = 1.0f;
+    float svfGTarget_ = 0.0f, svfKTarget_ = 1.0f;
+    float svfIn_ = 0.0f, svfBand_ = 0.0f, svfLow_ = 1.0f;
+
+    bool specialized_ = true;
+    RenderFn kernel_ = nullptr; // set by updateCoefficients()
+
+    ModMatrix mod_;
+    ModMatrix::Voice modVoice_;
+    // pitch ratio and output gains at the end of the last control period;
+    // the next period ramps from them (fresh: jump, after a note-on)
+    bool modFresh_ = true;
+    float modRatio_ = 1.0f;
+    float modGainL_ = 0.0f, modGainR_ = 0.0f;
 
     // ADSR envelope
     float envAttack_ = 0.01f;   // seconds
@@ -69,7 +137,7 @@ public:
     void set_env_decay(float s) { envDecay_ = std::max(0.0f, s); }
     void set_env_sustain(float s) { envSustain_ = std::clamp(s, 0.0f, 1.0f); }
     void set_env_release(float s) { envRelease_ = std::max(0.0f, s); }
-    void note_on();
+    void note_on(float velocity = 1.0f); // velocity 0..1, a modulation source
     void note_off();
     // Returns true if the voice is currently producing sound (envelope not idle)
     bool is_active() const;
@@ -0,0 +1,64 @@
+#include "VoiceAllocator.h"
+
+#include <algorithm>
+
+VoiceAllocator::VoiceAllocator(size_t limit) : limit_(std::clamp<size_t>(limit, 1, kMaxVoices)) {
+  prev_.fill(kNone);
+  next_.fill(kNone);
+  notePrev_.fill(kNone);
+  noteNext_.fill(kNone);
+  noteHead_.fill(kNone);
+  note_.fill(-1);
+  held_.fill(0);
+  // lowest index on top, so voices are handed out from 0 up
+  for (size_t i = 0; i < kMaxVoices; ++i) free_[i] = static_cast<uint16_t>(kMaxVoices - 1 - i);
+  freeCount_ = kMaxVoices;
+}
+
+void VoiceAllocator::set_limit(size_t n) { limit_ = std::clamp<size_t>(n, 1, kMaxVoices); }
+
+size_t VoiceAllocator::note_on(int note) {
+  note = std::clamp(note, 0, kNotes - 1);
+  uint16_t v;
+  if (activeCount_ < limit_ && freeCount_ > 0) {
+    v = free_[--freeCount_];
+  } else {
+    v = head_; // steal the oldest; it restarts as the newest
+    if (held_[v]) unlink_note(v);
+    unlink_active(v);
+  }
+  push_active(v);
+  note_[v] = static_cast<int16_t>(note);
+  held_[v] = 1;
+  notePrev_[v] = kNone;
+  noteNext_[v] = noteHead_[note];
+  if (noteHead_[note] != kNone) notePrev_[noteHead_[note]] = v;
+  noteHead_[note] = v;
+  return v;
+}
+
+void VoiceAllocator::unlink_active(uint16_t v) {
+  if (prev_[v] != kNone) next_[prev_[v]] = next_[v];
+  else head_ = next_[v];
+  if (next_[v] != kNone) prev_[next_[v]] = prev_[v];
+  else tail_ = prev_[v];
+  prev_[v] = next_[v] = kNone;
+  --activeCount_;
+}
+
+void VoiceAllocator::push_active(uint16_t v) {
+  prev_[v] = tail_;
+  next_[v] = kNone;
+  if (tail_ != kNone) next_[tail_] = v;
+  else head_ = v;
+  tail_ = v;
+  ++activeCount_;
+}
+
+void VoiceAllocator::unlink_note(uint16_t v) {
+  if (notePrev_[v] != kNone) noteNext_[notePrev_[v]] = noteNext_[v];
+  else noteHead_[note_[v]] = noteNext_[v];
+  if (noteNext_[v] != kNone) notePrev_[noteNext_[v]] = notePrev_[v];
+  notePrev_[v] = noteNext_[v] = kNone;
+  held_[v] = 0;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Voice bookkeeping for a fixed pool of kMaxVoices slots, all O(1) per
+// note and allocation-free: a stack of free voices, a list of sounding
+// voices in start order (the head is the steal candidate) and, per note,
+// a list of the voices still held on it. The limit only caps how many
+// voices may sound at once, so lowering it lets the extra voices finish.
+// Audio thread only.
+class VoiceAllocator {
+public:
+  static constexpr size_t kMaxVoices = 256;
+  static constexpr int kNotes = 128;
+
+  explicit VoiceAllocator(size_t limit = kMaxVoices);
+
+  void set_limit(size_t n); // clamped to 1..kMaxVoices
+  size_t limit() const { return limit_; }
+  size_t active() const { return activeCount_; }
+  int note_of(size_t voice) const { return note_[voice]; } // -1 = free
+
+  // Voice to start `note` on: a free one while fewer than limit() are
+  // sounding, otherwise the one started longest ago (stolen)
+  size_t note_on(int note);
+
+  // Releases every voice held on `note`, calling fn(voice) for each
+  template <class F>
+  void note_off(int note, F&& fn) {
+    if (note < 0 || note >= kNotes) return;
+    while (noteHead_[note] != kNone) {
+      uint16_t v = noteHead_[note];
+      unlink_note(v);
+      fn(static_cast<size_t>(v));
+    }
+  }
+
+  // Returns released voices for which idle(voice) holds to the free list;
+  // O(sounding voices), once per block after rendering
+  template <class F>
+  void reap(F&& idle) {
+    for (uint16_t v = head_; v != kNone;) {
+      uint16_t next = next_[v];
+      if (!held_[v] && idle(static_cast<size_t>(v))) {
+        unlink_active(v);
+        note_[v] = -1;
+        free_[freeCount_++] = v;
+      }
+      v = next;
+    }
+  }
+
+private:
+  static constexpr uint16_t kNone = 0xFFFF;
+
+  void unlink_active(uint16_t v);
+  void push_active(uint16_t v);
+  void unlink_note(uint16_t v);
+
+  std::array<uint16_t, kMaxVoices> prev_, next_;         // sounding, oldest first
+  std::array<uint16_t, kMaxVoices> notePrev_, noteNext_; // held voices per note
+  std::array<uint16_t, kNotes> noteHead_;
+  std::array<int16_t, kMaxVoices> note_;
+  std::array<uint8_t, kMaxVoices> held_;                 // on a note list (no note-off yet)
+  std::array<uint16_t, kMaxVoices> free_;
+  size_t freeCount_ = 0;
+  uint16_t head_ = kNone, tail_ = kNone;
+  size_t activeCount_ = 0;
+  size_t limit_;
+};
@@ -0,0 +1,509 @@
+#include "VoiceEngine.h"
+#include "MixKernels.h"
+#include "RtWorkerPool.h"
+#include "SynthVoice.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LANJAM_VOICE_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+constexpr float kPi = 3.14159265358979323846f;
+
+// constant power, as SynthVoice::set_pan
+void pan_gains(float pan, float& l, float& r) {
+  float theta = (std::clamp(pan, -1.0f, 1.0f) + 1.0f) * 0.25f * kPi;
+  l = std::cos(theta);
+  r = std::sin(theta);
+}
+
+// One lane; also what the compiler autovectorizes where it can
+struct VecScalar {
+  static constexpr int W = 1;
+  float v;
+  struct Mask {
+    bool m;
+    Mask operator&(Mask o) const { return {m && o.m}; }
+  };
+  static VecScalar load(const float* p) { return {*p}; }
+  static void store(float* p, VecScalar x) { *p = x.v; }
+  static VecScalar set1(float f) { return {f}; }
+  static VecScalar floor_pos(VecScalar x) { return {static_cast<float>(static_cast<int32_t>(x.v))}; }
+  static VecScalar select(Mask m, VecScalar a, VecScalar b) { return m.m ? a : b; }
+  using Idx = int32_t;
+  static Idx load_idx(const int32_t* p) { return *p; }
+  static Idx trunc(VecScalar x) { return static_cast<int32_t>(x.v); }
+  static VecScalar gather(const float* base, Idx i) { return {base[i]}; }
+  friend VecScalar operator+(VecScalar a, VecScalar b) { return {a.v + b.v}; }
+  friend VecScalar operator-(VecScalar a, VecScalar b) { return {a.v - b.v}; }
+  friend VecScalar operator*(VecScalar a, VecScalar b) { return {a.v * b.v}; }
+  friend VecScalar operator/(VecScalar a, VecScalar b) { return {a.v / b.v}; }
+  friend Mask operator>(VecScalar a, VecScalar b) { return {a.v > b.v}; }
+  friend Mask operator<(VecScalar a, VecScalar b) { return {a.v < b.v}; }
+  friend Mask operator>=(VecScalar a, VecScalar b) { return {a.v >= b.v}; }
+  friend Mask operator<=(VecScalar a, VecScalar b) { return {a.v <= b.v}; }
+  friend Mask operator==(VecScalar a, VecScalar b) { return {a.v == b.v}; }
+};
+
+#ifdef LANJAM_VOICE_X86
+struct CpuFeatures {
+  bool avx2 = false;
+  bool avx512 = false;
+};
+
+CpuFeatures detect_cpu() {
+  CpuFeatures f;
+#if defined(_MSC_VER)
+  int r[4];
+  __cpuid(r, 0);
+  int maxLeaf = r[0];
+  __cpuid(r, 1);
+  bool osxsave = (r[2] & (1 << 27)) != 0;
+  bool fma = (r[2] & (1 << 12)) != 0;
+  if (!osxsave || maxLeaf < 7) return f;
+  unsigned long long xcr0 = _xgetbv(0);
+  __cpuidex(r, 7, 0);
+  bool ymm = (xcr0 & 0x6) == 0x6;
+  bool zmm = (xcr0 & 0xE6) == 0xE6;
+  f.avx2 = ymm && fma && (r[1] & (1 << 5));
+  f.avx512 = zmm && (r[1] & (1 << 16));
+#else
+  __builtin_cpu_init();
+  f.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  f.avx512 = __builtin_cpu_supports("avx512f");
+#endif
+  return f;
+}
+#endif
+}
+
+VoiceEngine::VoiceEngine() : tables_(&WavetableBank::get()), state_(std::make_unique<VoiceState>()) {
+  std::memset(state_.get(), 0, sizeof(VoiceState));
+  panL_.fill(0.70710678f);
+  panR_.fill(0.70710678f);
+  osBuf_.assign(kChunkFrames * 2, 0.0f);
+  set_isa(best_isa());
+  set_render_threads(1);
+}
+
+VoiceEngine::~VoiceEngine() = default;
+
+unsigned VoiceEngine::default_render_threads() {
+  unsigned cores = std::thread::hardware_concurrency();
+  return std::clamp(cores / 2, 1u, 4u);
+}
+
+void VoiceEngine::set_render_threads(unsigned threads) {
+  threads = std::clamp(threads, 1u, kMaxRenderThreads);
+  pool_.reset();
+  pool_ = threads > 1 ? std::make_unique<RtWorkerPool>(threads - 1) : nullptr;
+  threads_ = threads;
+  scratch_.assign(threads * kTaskFloats + 16, 0.0f); // + room to align to 64 bytes
+}
+
+float* VoiceEngine::task_scratch(unsigned task) {
+  auto addr = reinterpret_cast<uintptr_t>(scratch_.data());
+  return scratch_.data() + ((64 - (addr & 63)) & 63) / sizeof(float) + task * kTaskFloats; // the kernels use aligned loads
+}
+
+VoiceEngine::Isa VoiceEngine::best_isa() {
+#ifdef LANJAM_VOICE_X86
+  static const CpuFeatures cpu = detect_cpu();
+  if (cpu.avx512) return Isa::Avx512;
+  if (cpu.avx2) return Isa::Avx2;
+  return Isa::Sse2;
+#else
+  return Isa::Scalar;
+#endif
+}
+
+const char* VoiceEngine::isa_name(Isa isa) {
+  switch (isa) {
+    case Isa::Sse2: return "SSE2";
+    case Isa::Avx2: return "AVX2";
+    case Isa::Avx512: return "AVX-512";
+    case Isa::Scalar:
+    default: return "scalar";
+  }
+}
+
+void VoiceEngine::set_isa(Isa isa) { isa_ = std::min(isa, best_isa()); }
+
+unsigned VoiceEngine::lanes() const {
+  switch (isa_) {
+    case Isa::Sse2: return 4;
+    case Isa::Avx2: return 8;
+    case Isa::Avx512: return 16;
+    case Isa::Scalar:
+    default: return 1;
+  }
+}
+
+void VoiceEngine::set_sample_rate(double sr) {
+  if (sr == outRate_) return;
+  outRate_ = sr;
+  sr_ = sr * os_.factor();
+  glideCutoff_ = -1.0f; // no glide across a device change
+  coeffDirty_ = true;
+  fresh_.fill(1);
+}
+
+void VoiceEngine::set_oversampling(unsigned factor) {
+  const unsigned old = os_.factor();
+  os_.set_factor(factor);
+  if (os_.factor() == old) return;
+  // envelope ramps are per sample: keep running notes at the same speed
+  const float scale = static_cast<float>(old) / static_cast<float>(os_.factor());
+  for (size_t v = 0; v < kMaxVoices; ++v) state_->envInc[v] *= scale;
+  sr_ = outRate_ * os_.factor();
+  glideCutoff_ = -1.0f;
+  coeffDirty_ = true;
+  fresh_.fill(1);
+}
+
+void VoiceEngine::set_osc_wave(int index, int w) {
+  if (index < 0 || index >= kVoiceOscs) return;
+  oscWave_[index] = std::clamp(w, 0, 2);
+}
+
+void VoiceEngine::set_osc_octave(int index, int semitones) {
+  if (index < 0 || index >= kVoiceOscs) return;
+  oscOctave_[index] = std::clamp(semitones, -24, 24);
+}
+
+void VoiceEngine::set_osc_detune(int index, float cents) {
+  if (index < 0 || index >= kVoiceOscs) return;
+  oscDetune_[index] = std::clamp(cents, -200.0f, 200.0f);
+}
+
+void VoiceEngine::set_osc_phase(int index, float degrees) {
+  if (index < 0 || index >= kVoiceOscs) return;
+  float frac = std::fmod(degrees, 360.0f) / 360.0f;
+  if (frac < 0.0f) frac += 1.0f;
+  oscPhaseOffset_[index] = frac;
+}
+
+// Filter settings only invalidate the coefficients when they actually change
+void VoiceEngine::set_cutoff(float hz) {
+  if (hz != cutoff_) { cutoff_ = hz; coeffDirty_ = true; }
+}
+
+void VoiceEngine::set_resonance(float r) {
+  if (r != resonance_) { resonance_ = r; coeffDirty_ = true; }
+}
+
+void VoiceEngine::set_filter_type(int type) {
+  type = std::clamp(type, 0, 2);
+  if (type != filterType_) { filterType_ = type; coeffDirty_ = true; }
+}
+
+void VoiceEngine::set_filter_slope(int stages) { filterStages_ = std::clamp(stages, 1, kVoiceFilterStages); }
+
+void VoiceEngine::set_filter_mode(int mode) {
+  mode = std::clamp(mode, 0, 1);
+  if (mode == filterMode_) return;
+  filterMode_ = mode;
+  liveStages_ = 0; // biquad and SVF states do not carry over
+  glideCutoff_ = -1.0f;
+  coeffDirty_ = true;
+  fresh_.fill(1);
+}
+
+void VoiceEngine::set_mod_matrix(const ModMatrix& mod) {
+  mod_ = mod;
+  modActive_ = mod_.active();
+}
+
+void VoiceEngine::set_env_attack(float s) { envAttack_ = std::max(0.0f, s); }
+void VoiceEngine::set_env_decay(float s) { envDecay_ = std::max(0.0f, s); }
+void VoiceEngine::set_env_sustain(float s) { envSustain_ = std::clamp(s, 0.0f, 1.0f); }
+void VoiceEngine::set_env_release(float s) { envRelease_ = std::max(0.0f, s); }
+
+// Moves cutoff (in octaves) and resonance one control period towards their
+// targets and rebuilds the shared coefficients; the per-voice filter state
+// is kept.
+void VoiceEngine::update_coefficients(unsigned nframes) {
+  float target = std::clamp(cutoff_, 20.0f, static_cast<float>(sr_) * 0.45f);
+  if (glideCutoff_ < 0.0f) {
+    glideCutoff_ = target;
+    glideResonance_ = resonance_;
+  } else {
+    float k = 1.0f - std::exp(-static_cast<float>(nframes) / (kFilterGlideSec * static_cast<float>(sr_)));
+    glideCutoff_ *= std::pow(target / glideCutoff_, k);
+    glideResonance_ += k * (resonance_ - glideResonance_);
+    if (std::fabs(std::log2(target / glideCutoff_)) < 1e-3f && std::fabs(resonance_ - glideResonance_) < 1e-3f) {
+      glideCutoff_ = target;
+      glideResonance_ = resonance_;
+    }
+  }
+  const auto type = static_cast<SynthVoice::FilterType>(filterType_);
+  if (filterMode_ == SynthVoice::Svf)
+    SynthVoice::computeSvfCoefficients(type, glideCutoff_, glideResonance_, sr_, svfG_, svfK_, svfIn_, svfBand_,
+                                       svfLow_);
+  else
+    SynthVoice::computeCoefficients(type, glideCutoff_, glideResonance_, sr_, b0_, b1_, b2_, a1_, a2_);
+  coeffDirty_ = glideCutoff_ != target || glideResonance_ != resonance_;
+}
+
+// Splits the next `nframes` into control periods (one when nothing is
+// routed) and fixes the shared filter values at the end of each
+void VoiceEngine::plan_segments(unsigned nframes) {
+  const unsigned period =
+      modActive_ ? std::min(static_cast<unsigned>(mod_.period()) * os_.factor(), kChunkFrames) : kChunkFrames;
+  segCount_ = 0;
+  for (unsigned off = 0; off < nframes; off += period) {
+    Segment& seg = segs_[segCount_++];
+    seg.frames = std::min(period, nframes - off);
+    if (coeffDirty_) update_coefficients(seg.frames);
+    seg.cutoff = glideCutoff_;
+    seg.resonance = glideResonance_;
+    if (filterMode_ == SynthVoice::Svf) {
+      seg.coef = {svfG_, svfK_, 0.0f, 0.0f, 0.0f};
+    } else {
+      seg.coef = {b0_, b1_, b2_, a1_, a2_};
+    }
+  }
+}
+
+// Modulation targets at the end of `seg` for the active voices of groups
+// g0..g1, written as per-frame ramps from the end of the last period.
+// Touches only those voices, so tasks can run it on their own ranges.
+void VoiceEngine::prepare_voices(size_t g0, size_t g1, const Segment& seg, unsigned channels) {
+  VoiceState& s = *state_;
+  const unsigned w = lanes();
+  const float step = 1.0f / static_cast<float>(seg.frames);
+  const auto dt = static_cast<float>(seg.frames / sr_);
+  const bool svf = filterMode_ == SynthVoice::Svf;
+  const bool modCutoff = modActive_ && mod_.routes_to(ModMatrix::DstCutoff);
+  const bool modPan = modActive_ && mod_.routes_to(ModMatrix::DstPan);
+  const bool modPitch = modActive_ && mod_.routes_to(ModMatrix::DstPitch);
+  const auto type = static_cast<SynthVoice::FilterType>(filterType_);
+  for (size_t gi = g0; gi < g1; ++gi) {
+    for (size_t v = groups_[gi] * w; v < (groups_[gi] + 1) * w; ++v) {
+      if (s.active[v] == 0.0f) continue;
+      ModMatrix::Targets t;
+      if (modActive_) {
+        mod_.advance(modVoices_[v], dt);
+        t = mod_.evaluate(modVoices_[v]);
+      }
+      const float ratio = t.pitch != 0.0f ? std::exp2(t.pitch / 12.0f) : 1.0f;
+      float gL = panL_[v], gR = panR_[v];
+      if (modPan) ModMatrix::pan_gains(pan_[v] + t.pan, gL, gR);
+      if (channels == 1) { gL = 1.0f; gR = 0.0f; }
+      gL *= t.amp;
+      gR *= t.amp;
+      std::array<float, 5> coef = seg.coef;
+      if (modCutoff) {
+        const float fc = seg.cutoff * std::exp2(t.cutoff);
+        float in, band, low;
+        if (svf) SynthVoice::computeSvfCoefficients(type, fc, seg.resonance, sr_, coef[0], coef[1], in, band, low);
+        else SynthVoice::computeCoefficients(type, fc, seg.resonance, sr_, coef[0], coef[1], coef[2], coef[3], coef[4]);
+      }
+      if (fresh_[v]) {
+        lastRatio_[v] = ratio;
+        lastGainL_[v] = gL;
+        lastGainR_[v] = gR;
+        lastG_[v] = coef[0];
+        lastK_[v] = coef[1];
+        fresh_[v] = 0;
+      }
+      for (int o = 0; o < kVoiceOscs; ++o) {
+        const float base = baseInc_[o][v];
+        s.inc[o][v] = base * lastRatio_[v];
+        s.incStep[o][v] = base * (ratio - lastRatio_[v]) * step;
+        if (modPitch || lastRatio_[v] != 1.0f)
+          s.tableOff[o][v] = WavetableBank::level_offset(
+              oscWave_[o], WavetableBank::level_for(base * std::max(ratio, lastRatio_[v])));
+      }
+      s.gainL[v] = lastGainL_[v];
+      s.gainR[v] = lastGainR_[v];
+      s.gainStepL[v] = (gL - lastGainL_[v]) * step;
+      s.gainStepR[v] = (gR - lastGainR_[v]) * step;
+      if (svf) {
+        // g and k ramp per frame; the kernel derives the rest
+        s.coef[0][v] = lastG_[v];
+        s.coef[1][v] = lastK_[v];
+        s.coef[2][v] = (coef[0] - lastG_[v]) * step;
+        s.coef[3][v] = (coef[1] - lastK_[v]) * step;
+        lastG_[v] = coef[0];
+        lastK_[v] = coef[1];
+      } else {
+        for (int c = 0; c < 5; ++c) s.coef[c][v] = coef[c];
+      }
+      lastRatio_[v] = ratio;
+      lastGainL_[v] = gL;
+      lastGainR_[v] = gR;
+    }
+  }
+}
+
+void VoiceEngine::note_on(size_t voice, float freq, float pan, float velocity) {
+  if (voice >= kMaxVoices) return;
+  freq_[voice] = freq;
+  pan_[voice] = pan;
+  pan_gains(pan, panL_[voice], panR_[voice]);
+  mod_.note_on(modVoices_[voice], velocity, freq);
+  fresh_[voice] = 1;
+  state_->envStage[voice] = static_cast<float>(VoiceEnvAttack);
+  state_->envInc[voice] = 1.0f / std::max(1.0f, envAttack_ * static_cast<float>(sr_));
+}
+
+void VoiceEngine::note_off(size_t voice) {
+  if (voice >= kMaxVoices) return;
+  mod_.note_off(modVoices_[voice]);
+  state_->envStage[voice] = static_cast<float>(VoiceEnvRelease);
+  float releaseSamples = std::max(1.0f, envRelease_ * static_cast<float>(sr_));
+  state_->envInc[voice] = -(state_->envLevel[voice] / releaseSamples);
+}
+
+bool VoiceEngine::is_active(size_t voice) const {
+  return voice < kMaxVoices &&
+         (state_->envStage[voice] != static_cast<float>(VoiceEnvIdle) || state_->envLevel[voice] > 1e-6f);
+}
+
+void VoiceEngine::render(float* out, unsigned nframes, unsigned channels) {
+  const unsigned factor = os_.factor();
+  if (factor == 1) {
+    render_voices(out, nframes, channels);
+    return;
+  }
+  // voices into the oversampled scratch, a chunk at a time, then decimated
+  // into `out` (voices only ever reach the first two channels)
+  const unsigned osCh = std::min(channels, 2u);
+  const unsigned chunk = kChunkFrames / factor;
+  float dec[kChunkFrames * 2];
+  for (unsigned off = 0; off < nframes; off += chunk) {
+    const unsigned n = std::min(nframes - off, chunk);
+    std::fill_n(osBuf_.data(), static_cast<size_t>(n) * factor * osCh, 0.0f);
+    render_voices(osBuf_.data(), n * factor, osCh);
+    os_.down(osBuf_.data(), dec, n, osCh);
+    mix_channels(out + static_cast<size_t>(off) * channels, channels, dec, osCh, n, 1.0f);
+  }
+}
+
+void VoiceEngine::render_voices(float* out, unsigned nframes, unsigned channels) {
+  VoiceState& s = *state_;
+  // stages switched on by a steeper slope start from silence, not stale state
+  for (; liveStages_ < filterStages_; ++liveStages_) std::memset(s.filt[liveStages_], 0, sizeof(s.filt[liveStages_]));
+  liveStages_ = filterStages_;
+
+  // oscillator ratios once per block instead of per sample
+  std::array<float, kVoiceOscs> octRatio, detRatio;
+  for (int o = 0; o < kVoiceOscs; ++o) {
+    octRatio[o] = std::pow(2.0f, oscOctave_[o] / 12.0f);
+    detRatio[o] = std::pow(2.0f, oscDetune_[o] / 1200.0f);
+  }
+  const unsigned w = lanes();
+  size_t groupCount = 0, activeVoices = 0;
+  for (size_t g = 0; g < kMaxVoices / w; ++g) {
+    bool any = false;
+    for (size_t v = g * w; v < (g + 1) * w; ++v) {
+      bool live = is_active(v);
+      s.active[v] = live ? 1.0f : 0.0f;
+      if (!live) continue;
+      any = true;
+      ++activeVoices;
+      auto baseInc = static_cast<float>(freq_[v] / sr_);
+      for (int o = 0; o < kVoiceOscs; ++o) {
+        baseInc_[o][v] = baseInc * octRatio[o] * detRatio[o];
+        s.tableOff[o][v] = WavetableBank::level_offset(oscWave_[o], WavetableBank::level_for(baseInc_[o][v]));
+      }
+    }
+    if (any) groups_[groupCount++] = static_cast<uint16_t>(g);
+  }
+  if (!groupCount) {
+    if (coeffDirty_) update_coefficients(nframes); // the glide runs on while nothing plays
+    return;
+  }
+
+  VoiceKernelArgs args;
+  args.state = state_.get();
+  for (int o = 0; o < kVoiceOscs; ++o) {
+    args.table[o] = tables_->data(oscWave_[o]);
+    args.phaseOffset[o] = oscPhaseOffset_[o];
+  }
+  args.filterStages = filterStages_;
+  args.filterType = filterType_;
+  args.svf = filterMode_ == SynthVoice::Svf;
+  args.svfIn = svfIn_;
+  args.svfBand = svfBand_;
+  args.svfLow = svfLow_;
+  args.sustain = envSustain_;
+  args.decayInc = -(1.0f - envSustain_) / std::max(1.0f, envDecay_ * static_cast<float>(sr_));
+  args.channels = channels;
+  job_ = args;
+  kernel_ = select_kernel(args);
+
+  // Few voices: everything on this thread, straight into `out`
+  size_t tasks = std::min({static_cast<size_t>(threads_), activeVoices / kMinVoicesPerTask, groupCount});
+  if (tasks <= 1 || !pool_) {
+    for (unsigned off = 0; off < nframes; off += kChunkFrames) {
+      plan_segments(std::min(nframes - off, kChunkFrames));
+      render_range(0, groupCount, out + static_cast<size_t>(off) * channels, task_scratch(0));
+    }
+    return;
+  }
+
+  // Otherwise contiguous group ranges, one per task, each into its own
+  // buffer; the sum below always runs in task order
+  for (size_t t = 0; t <= tasks; ++t) taskBegin_[t] = t * groupCount / tasks;
+  const unsigned outCh = std::min(channels, 2u);
+  job_.channels = outCh;
+  for (unsigned off = 0; off < nframes; off += kChunkFrames) {
+    const unsigned n = std::min(nframes - off, kChunkFrames);
+    plan_segments(n);
+    pool_->run(static_cast<unsigned>(tasks), &VoiceEngine::render_task, this);
+    float* o = out + static_cast<size_t>(off) * channels;
+    for (unsigned t = 0; t < tasks; ++t) {
+      const float* part = task_scratch(t) + kTaskAccFloats;
+      for (unsigned i = 0; i < n; ++i)
+        for (unsigned c = 0; c < outCh; ++c) o[static_cast<size_t>(i) * channels + c] += part[i * outCh + c];
+    }
+  }
+}
+
+// Groups g0..g1 through the planned segments, adding into `out`
+void VoiceEngine::render_range(size_t g0, size_t g1, float* out, float* acc) {
+  VoiceKernelArgs args = job_;
+  args.groups = groups_.data() + g0;
+  args.groupCount = g1 - g0;
+  args.acc = acc;
+  unsigned pos = 0;
+  for (unsigned i = 0; i < segCount_; ++i) {
+    prepare_voices(g0, g1, segs_[i], args.channels);
+    args.out = out + static_cast<size_t>(pos) * args.channels;
+    args.nframes = segs_[i].frames;
+    kernel_(args);
+    pos += segs_[i].frames;
+  }
+}
+
+void VoiceEngine::render_task(void* self, unsigned task) {
+  auto* e = static_cast<VoiceEngine*>(self);
+  float* acc = e->task_scratch(task);
+  float* out = acc + kTaskAccFloats;
+  unsigned frames = 0;
+  for (unsigned i = 0; i < e->segCount_; ++i) frames += e->segs_[i].frames;
+  std::fill_n(out, static_cast<size_t>(frames) * e->job_.channels, 0.0f);
+  e->render_range(e->taskBegin_[task], e->taskBegin_[task + 1], out, acc);
+}
+
+VoiceKernelFn VoiceEngine::select_kernel(const VoiceKernelArgs& args) const {
+  switch (isa_) {
+#ifdef LANJAM_VOICE_X86
+    case Isa::Avx512: return voice_kernel_avx512(args, specialized_);
+    case Isa::Avx2: return voice_kernel_avx2(args, specialized_);
+    case Isa::Sse2: return voice_kernel_sse2(args, specialized_);
+#endif
+    default: return select_voice_kernel<VecScalar>(args, specialized_);
+  }
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ModMatrix.h"
+#include "Oversampler.h"
+#include "VoiceKernel.h"
+
+class RtWorkerPool;
+
+// Polyphonic synth engine: the same voice as SynthVoice (three wavetable
+// oscillators, biquad or SVF cascade, linear ADSR, constant-power pan), but with all
+// voices' state in structure-of-arrays form so 4 (SSE2), 8 (AVX2) or 16
+// (AVX-512) voices render per instruction. Oscillator, filter and envelope settings
+// are shared by all voices; frequency, pan and envelope progress are per
+// voice. Filter changes glide per block (coefficients shared by all voices)
+// instead of resetting filter state, so sweeps do not click; in SVF mode the
+// glide is also interpolated per sample. Modulation (ModMatrix) is evaluated
+// per voice once per control period and ramped per sample inside the
+// kernel, which then takes per-voice pitch, gain and filter values. With render
+// threads, blocks with many active voices are split into contiguous voice
+// ranges rendered in parallel and summed in range order, so the output does
+// not depend on thread timing. With oversampling, voices run at 2x, 4x or
+// 8x the output rate and the summed bus is decimated once, so the filter
+// cost is shared by all voices. SynthVoice stays the scalar reference.
+// Audio thread only, except set_isa() and set_render_threads() which must
+// not race render().
+class VoiceEngine {
+public:
+  static constexpr size_t kMaxVoices = kVoiceSlots;
+  enum class Isa { Scalar = 0, Sse2, Avx2, Avx512 };
+
+  VoiceEngine(); // picks best_isa(), renders on the calling thread only
+  ~VoiceEngine();
+
+  static Isa best_isa(); // widest the CPU and this build support
+  static const char* isa_name(Isa isa);
+  void set_isa(Isa isa); // clamped to best_isa()
+  Isa isa() const { return isa_; }
+  unsigned lanes() const;
+  // On (default): kernels specialized for the filter mode, type and slope,
+  // picked per block. Off: the generic kernel, for comparison.
+  void set_specialized_kernels(bool on) { specialized_ = on; }
+  bool specialized_kernels() const { return specialized_; }
+
+  // Total threads render() may use, including the caller (1 = no workers).
+  // Starts or stops worker threads; not real-time safe.
+  void set_render_threads(unsigned threads);
+  unsigned render_threads() const { return threads_; }
+  static unsigned default_render_threads(); // a few cores, leaving the rest to the OS
+
+  void set_sample_rate(double sr);
+  // 1 (off), 2, 4 or 8. Brighter, alias-free oscillators up to the output
+  // Nyquist and a less warped resonant filter, for about that factor more
+  // voice cost; real-time safe.
+  void set_oversampling(unsigned factor);
+  unsigned oversampling() const { return os_.factor(); }
+
+  // Shared voice parameters (same ranges as SynthVoice's setters)
+  void set_osc_wave(int index, int w);
+  void set_osc_octave(int index, int semitones);
+  void set_osc_detune(int index, float cents);
+  void set_osc_phase(int index, float degrees);
+  void set_cutoff(float hz);
+  void set_resonance(float r);
+  void set_filter_type(int type);
+  void set_filter_slope(int stages);
+  void set_filter_mode(int mode); // SynthVoice::FilterMode
+  void set_mod_matrix(const ModMatrix& mod);
+  void set_env_attack(float s);
+  void set_env_decay(float s);
+  void set_env_sustain(float s);
+  void set_env_release(float s);
+
+  // Per voice
+  void note_on(size_t voice, float freq, float pan, float velocity = 1.0f);
+  void note_off(size_t voice);
+  bool is_active(size_t voice) const;
+
+  // Adds every active voice into interleaved `out`
+  void render(float* out, unsigned nframes, unsigned channels);
+
+private:
+  static constexpr unsigned kChunkFrames = 256; // bounds the accumulation scratch
+  static constexpr float kFilterGlideSec = 0.015f; // cutoff/resonance smoothing time constant
+  static constexpr size_t kMinVoicesPerTask = 32;  // below this a thread hand-off costs more than it saves
+  static constexpr unsigned kMaxRenderThreads = 16;
+  static constexpr size_t kTaskAccFloats = 2 * kChunkFrames * 16; // widest ISA
+  static constexpr size_t kTaskFloats = kTaskAccFloats + 2 * kChunkFrames; // + private stereo out
+
+  void render_voices(float* out, unsigned nframes, unsigned channels); // at sr_
+  // One control period of a chunk and the shared filter values at its end
+  struct Segment {
+    unsigned frames = 0;
+    float cutoff = 0.0f, resonance = 0.0f;
+    std::array<float, 5> coef{}; // biquad b0, b1, b2, a1, a2 or SVF g, k
+  };
+
+  void update_coefficients(unsigned nframes);
+  void plan_segments(unsigned nframes);
+  void prepare_voices(size_t g0, size_t g1, const Segment& seg, unsigned channels);
+  void render_range(size_t g0, size_t g1, float* out, float* acc);
+  VoiceKernelFn select_kernel(const VoiceKernelArgs& args) const;
+  static void render_task(void* self, unsigned task);
+  float* task_scratch(unsigned task);
+
+  Isa isa_ = Isa::Scalar;
+  bool specialized_ = true;
+  VoiceKernelFn kernel_ = nullptr; // for job_
+  const WavetableBank* tables_;
+  std::unique_ptr<VoiceState> state_;
+  std::vector<float> scratch_;  // kTaskFloats per task, 64-byte aligned via task_scratch()
+  unsigned threads_ = 1;
+  std::unique_ptr<RtWorkerPool> pool_;
+  VoiceKernelArgs job_;         // current block's settings, read by render_range()
+  size_t taskBegin_[kMaxRenderThreads + 1] = {};
+  std::array<uint16_t, kMaxVoices> groups_{};
+  std::array<float, kMaxVoices> freq_{};
+  std::array<float, kMaxVoices> panL_{};
+  std::array<float, kMaxVoices> panR_{};
+  std::array<float, kMaxVoices> pan_{};
+  std::array<std::array<float, kMaxVoices>, kVoiceOscs> baseInc_{}; // per block, before pitch modulation
+  ModMatrix mod_;
+  bool modActive_ = false;
+  std::array<ModMatrix::Voice, kMaxVoices> modVoices_{};
+  // per voice, at the end of the last control period: where the next one
+  // ramps from (fresh: jump to the targets, after a note-on)
+  std::array<float, kMaxVoices> lastRatio_{}, lastGainL_{}, lastGainR_{}, lastG_{}, lastK_{};
+  std::array<uint8_t, kMaxVoices> fresh_{};
+  std::array<Segment, kChunkFrames / ModMatrix::kMinControlPeriod> segs_{};
+  unsigned segCount_ = 0;
+  Oversampler os_;
+  std::vector<float> osBuf_;    // voices at the oversampled rate, stereo
+
+  double outRate_ = 48000.0;    // the stream's rate
+  double sr_ = 48000.0;         // the voices' rate, outRate_ * oversampling()
+  std::array<int, kVoiceOscs> oscWave_{{0, 0, 0}};
+  std::array<int, kVoiceOscs> oscOctave_{{0, 0, 0}};
+  std::array<float, kVoiceOscs> oscDetune_{{0.0f, 0.0f, 0.0f}};
+  std::array<float, kVoiceOscs> oscPhaseOffset_{{0.0f, 0.0f, 0.0f}};
+  float cutoff_ = 1200.0f;      // targets; the filter glides towards them
+  float resonance_ = 0.7f;
+  float glideCutoff_ = -1.0f;   // what the coefficients were built from, < 0 = jump to target
+  float glideResonance_ = 0.7f;
+  int filterType_ = 0;
+  int filterStages_ = 1;
+  int liveStages_ = 1;          // stages whose state is current
+  bool coeffDirty_ = true;      // coefficients differ from the targets
+  float b0_ = 1.0f, b1_ = 0.0f, b2_ = 0.0f, a1_ = 0.0f, a2_ = 0.0f;
+  int filterMode_ = 0;
+  float svfG_ = 0.0f, svfK_ = 1.0f;
+  float svfIn_ = 0.0f, svfBand_ = 0.0f, svfLow_ = 1.0f;
+  float envAttack_ = 0.01f;
+  float envDecay_ = 0.1f;
+  float envSustain_ = 0.8f;
+  float envRelease_ = 0.2f;
+};
@@ -0,0 +1,43 @@
+// AVX2/FMA instantiation of the voice kernel (8 voices per instruction).
+// Compiled with AVX2 flags; only called after a CPUID check.
+#include "VoiceKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+
+namespace {
+struct Vec {
+  static constexpr int W = 8;
+  __m256 v;
+  struct Mask {
+    __m256 m;
+    Mask operator&(Mask o) const { return {_mm256_and_ps(m, o.m)}; }
+  };
+  static Vec load(const float* p) { return {_mm256_load_ps(p)}; }
+  static void store(float* p, Vec x) { _mm256_store_ps(p, x.v); }
+  static Vec set1(float f) { return {_mm256_set1_ps(f)}; }
+  static Vec floor_pos(Vec x) { return {_mm256_round_ps(x.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)}; }
+  static Vec select(Mask m, Vec a, Vec b) { return {_mm256_blendv_ps(b.v, a.v, m.m)}; }
+  struct Idx {
+    __m256i i;
+    friend Idx operator+(Idx a, Idx b) { return {_mm256_add_epi32(a.i, b.i)}; }
+  };
+  static Idx load_idx(const int32_t* p) { return {_mm256_load_si256(reinterpret_cast<const __m256i*>(p))}; }
+  static Idx trunc(Vec x) { return {_mm256_cvttps_epi32(x.v)}; }
+  static Vec gather(const float* base, Idx idx) { return {_mm256_i32gather_ps(base, idx.i, 4)}; }
+  friend Vec operator+(Vec a, Vec b) { return {_mm256_add_ps(a.v, b.v)}; }
+  friend Vec operator-(Vec a, Vec b) { return {_mm256_sub_ps(a.v, b.v)}; }
+  friend Vec operator*(Vec a, Vec b) { return {_mm256_mul_ps(a.v, b.v)}; }
+  friend Vec operator/(Vec a, Vec b) { return {_mm256_div_ps(a.v, b.v)}; }
+  friend Mask operator>(Vec a, Vec b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+  friend Mask operator<(Vec a, Vec b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+  friend Mask operator>=(Vec a, Vec b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)}; }
+  friend Mask operator<=(Vec a, Vec b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)}; }
+  friend Mask operator==(Vec a, Vec b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)}; }
+};
+}
+
+VoiceKernelFn voice_kernel_avx2(const VoiceKernelArgs& args, bool specialized) {
+  return select_voice_kernel<Vec>(args, specialized);
+}
+#endif
@@ -0,0 +1,47 @@
+// AVX-512F instantiation of the voice kernel (16 voices per instruction).
+// Compiled with AVX-512 flags; only called after a CPUID check.
+#include "VoiceKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized" // GCC 12 false positive on _mm512_undefined_*()
+#endif
+
+namespace {
+struct Vec {
+  static constexpr int W = 16;
+  __m512 v;
+  struct Mask {
+    __mmask16 m;
+    Mask operator&(Mask o) const { return {static_cast<__mmask16>(m & o.m)}; }
+  };
+  static Vec load(const float* p) { return {_mm512_load_ps(p)}; }
+  static void store(float* p, Vec x) { _mm512_store_ps(p, x.v); }
+  static Vec set1(float f) { return {_mm512_set1_ps(f)}; }
+  static Vec floor_pos(Vec x) { return {_mm512_cvtepi32_ps(_mm512_cvttps_epi32(x.v))}; }
+  static Vec select(Mask m, Vec a, Vec b) { return {_mm512_mask_blend_ps(m.m, b.v, a.v)}; }
+  struct Idx {
+    __m512i i;
+    friend Idx operator+(Idx a, Idx b) { return {_mm512_add_epi32(a.i, b.i)}; }
+  };
+  static Idx load_idx(const int32_t* p) { return {_mm512_load_si512(p)}; }
+  static Idx trunc(Vec x) { return {_mm512_cvttps_epi32(x.v)}; }
+  static Vec gather(const float* base, Idx idx) { return {_mm512_i32gather_ps(idx.i, base, 4)}; }
+  friend Vec operator+(Vec a, Vec b) { return {_mm512_add_ps(a.v, b.v)}; }
+  friend Vec operator-(Vec a, Vec b) { return {_mm512_sub_ps(a.v, b.v)}; }
+  friend Vec operator*(Vec a, Vec b) { return {_mm512_mul_ps(a.v, b.v)}; }
+  friend Vec operator/(Vec a, Vec b) { return {_mm512_div_ps(a.v, b.v)}; }
+  friend Mask operator>(Vec a, Vec b) { return {_mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ)}; }
+  friend Mask operator<(Vec a, Vec b) { return {_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ)}; }
+  friend Mask operator>=(Vec a, Vec b) { return {_mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ)}; }
+  friend Mask operator<=(Vec a, Vec b) { return {_mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ)}; }
+  friend Mask operator==(Vec a, Vec b) { return {_mm512_cmp_ps_mask(a.v, b.v, _CMP_EQ_OQ)}; }
+};
+}
+
+VoiceKernelFn voice_kernel_avx512(const VoiceKernelArgs& args, bool specialized) {
+  return select_voice_kernel<Vec>(args, specialized);
+}
+#endif
@@ -0,0 +1,47 @@
+// SSE2 instantiation of the voice kernel (4 voices per instruction)
+#include "VoiceKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <emmintrin.h>
+
+namespace {
+struct Vec {
+  static constexpr int W = 4;
+  __m128 v;
+  struct Mask {
+    __m128 m;
+    Mask operator&(Mask o) const { return {_mm_and_ps(m, o.m)}; }
+  };
+  static Vec load(const float* p) { return {_mm_load_ps(p)}; }
+  static void store(float* p, Vec x) { _mm_store_ps(p, x.v); }
+  static Vec set1(float f) { return {_mm_set1_ps(f)}; }
+  static Vec floor_pos(Vec x) { return {_mm_cvtepi32_ps(_mm_cvttps_epi32(x.v))}; }
+  static Vec select(Mask m, Vec a, Vec b) { return {_mm_or_ps(_mm_and_ps(m.m, a.v), _mm_andnot_ps(m.m, b.v))}; }
+  struct Idx {
+    __m128i i;
+    friend Idx operator+(Idx a, Idx b) { return {_mm_add_epi32(a.i, b.i)}; }
+  };
+  static Idx load_idx(const int32_t* p) { return {_mm_load_si128(reinterpret_cast<const __m128i*>(p))}; }
+  static Idx trunc(Vec x) { return {_mm_cvttps_epi32(x.v)}; }
+  // no gather before AVX2: four scalar loads
+  static Vec gather(const float* base, Idx idx) {
+    alignas(16) int32_t i[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(i), idx.i);
+    return {_mm_setr_ps(base[i[0]], base[i[1]], base[i[2]], base[i[3]])};
+  }
+  friend Vec operator+(Vec a, Vec b) { return {_mm_add_ps(a.v, b.v)}; }
+  friend Vec operator-(Vec a, Vec b) { return {_mm_sub_ps(a.v, b.v)}; }
+  friend Vec operator*(Vec a, Vec b) { return {_mm_mul_ps(a.v, b.v)}; }
+  friend Vec operator/(Vec a, Vec b) { return {_mm_div_ps(a.v, b.v)}; }
+  friend Mask operator>(Vec a, Vec b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+  friend Mask operator<(Vec a, Vec b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+  friend Mask operator>=(Vec a, Vec b) { return {_mm_cmpge_ps(a.v, b.v)}; }
+  friend Mask operator<=(Vec a, Vec b) { return {_mm_cmple_ps(a.v, b.v)}; }
+  friend Mask operator==(Vec a, Vec b) { return {_mm_cmpeq_ps(a.v, b.v)}; }
+};
+}
+
+VoiceKernelFn voice_kernel_sse2(const VoiceKernelArgs& args, bool specialized) {
+  return select_voice_kernel<Vec>(args, specialized);
+}
+#endif
@@ -0,0 +1,237 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Wavetable.h"
+
+// Structure-of-arrays state for every voice of a VoiceEngine, plus the
+// kernel that renders it. The kernel is a template over a SIMD vector type
+// V; each ISA translation unit (VoiceEngine*.cpp) defines its own V in an
+// anonymous namespace, so every instantiation has internal linkage and code
+// built with wider instructions can never be picked up by the scalar path.
+//
+// V provides: W (lanes), load/store (aligned), set1, +, -, *, /, floor_pos
+// (floor for x >= 0), comparisons returning V::Mask, mask &, select(m, a, b),
+// and for the table reads an int vector V::Idx with load_idx, trunc (x >= 0),
+// Idx + Idx and gather(base, idx).
+//
+// The filter configuration can also be fixed at compile time: each ISA
+// instantiates one kernel per filter mode, SVF output type and stage count,
+// so the stage loops unroll, filter state stays in registers and the SVF
+// output mix reduces to the terms its type uses. select_voice_kernel() picks
+// one per block; kVoiceAny leaves a setting to VoiceKernelArgs (the generic
+// kernel, kept for comparison).
+
+constexpr size_t kVoiceSlots = 256;
+constexpr int kVoiceOscs = 3;
+constexpr int kVoiceFilterStages = 4;
+
+enum VoiceEnvStage : int { VoiceEnvIdle = 0, VoiceEnvAttack, VoiceEnvDecay, VoiceEnvSustain, VoiceEnvRelease };
+
+struct alignas(64) VoiceState {
+  alignas(64) float phase[kVoiceOscs][kVoiceSlots];
+  alignas(64) float inc[kVoiceOscs][kVoiceSlots];   // per period: freq / sr * osc ratio * pitch modulation
+  alignas(64) float incStep[kVoiceOscs][kVoiceSlots]; // per period: added to inc every frame
+  alignas(64) int32_t tableOff[kVoiceOscs][kVoiceSlots]; // per period: mip level offset into the wave's tables
+  alignas(64) float envLevel[kVoiceSlots];
+  alignas(64) float envInc[kVoiceSlots];
+  alignas(64) float envStage[kVoiceSlots];          // VoiceEnvStage as float, so it masks like the rest
+  alignas(64) float gainL[kVoiceSlots];             // pan and amp modulation, or amp/0 for mono output
+  alignas(64) float gainR[kVoiceSlots];
+  alignas(64) float gainStepL[kVoiceSlots];         // per frame
+  alignas(64) float gainStepR[kVoiceSlots];
+  alignas(64) float coef[5][kVoiceSlots];           // per period: b0, b1, b2, a1, a2; SVF: g, k, g step, k step
+  alignas(64) float active[kVoiceSlots];            // 1 if the voice renders this block
+  alignas(64) float filt[kVoiceFilterStages][4][kVoiceSlots]; // x1, x2, y1, y2 per stage (SVF: ic1, ic2)
+};
+
+struct VoiceKernelArgs {
+  VoiceState* state = nullptr;
+  const uint16_t* groups = nullptr; // groups with at least one active lane; voices g*W .. g*W+W-1
+  size_t groupCount = 0;
+  const float* table[kVoiceOscs] = {nullptr, nullptr, nullptr}; // WavetableBank::data(wave)
+  float phaseOffset[kVoiceOscs] = {0.0f, 0.0f, 0.0f};
+  int filterStages = 1;
+  int filterType = 0;                // SynthVoice::FilterType
+  bool svf = false;                  // SVF sections instead of biquads
+  float svfIn = 0.0f, svfBand = 0.0f, svfLow = 1.0f; // SVF output mix (see SynthVoice::computeSvfCoefficients)
+  float sustain = 0.8f;
+  float decayInc = 0.0f;             // envelope slope from 1 down to sustain
+  float* acc = nullptr;              // scratch: 2 * nframes * W floats
+  float* out = nullptr;              // interleaved, added into
+  unsigned nframes = 0;
+  unsigned channels = 1;
+};
+
+using VoiceKernelFn = void (*)(const VoiceKernelArgs&);
+constexpr int kVoiceAny = -1;
+
+// Per-ISA kernel lookups, each in its own translation unit built with that
+// ISA's compiler flags (see CMakeLists.txt). x86 only.
+VoiceKernelFn voice_kernel_sse2(const VoiceKernelArgs& args, bool specialized);
+VoiceKernelFn voice_kernel_avx2(const VoiceKernelArgs& args, bool specialized);
+VoiceKernelFn voice_kernel_avx512(const VoiceKernelArgs& args, bool specialized);
+
+template <class V, int Svf = kVoiceAny, int Type = kVoiceAny, int Stages = kVoiceAny>
+void render_voice_groups(const VoiceKernelArgs& a) {
+  constexpr int W = V::W;
+  const bool svf = Svf == kVoiceAny ? a.svf : Svf != 0;
+  const int stages = Stages == kVoiceAny ? a.filterStages : Stages;
+  VoiceState& s = *a.state;
+  const unsigned nframes = a.nframes;
+  float* accL = a.acc;
+  float* accR = a.acc + static_cast<size_t>(nframes) * W;
+  for (size_t i = 0; i < 2 * static_cast<size_t>(nframes) * W; ++i) a.acc[i] = 0.0f;
+
+  const V one = V::set1(1.0f), zero = V::set1(0.0f), third = V::set1(1.0f / 3.0f), level = V::set1(0.15f);
+  const V svfIn = V::set1(a.svfIn), svfBand = V::set1(a.svfBand), svfLow = V::set1(a.svfLow);
+  const V sus = V::set1(a.sustain), decayInc = V::set1(a.decayInc);
+  const V stAttack = V::set1(VoiceEnvAttack), stDecay = V::set1(VoiceEnvDecay);
+  const V stSustain = V::set1(VoiceEnvSustain), stRelease = V::set1(VoiceEnvRelease), stIdle = zero;
+  const V tableSize = V::set1(static_cast<float>(WavetableBank::kTableSize));
+  V off[kVoiceOscs];
+  for (int o = 0; o < kVoiceOscs; ++o) off[o] = V::set1(a.phaseOffset[o]);
+
+  for (size_t gi = 0; gi < a.groupCount; ++gi) {
+    const size_t v0 = static_cast<size_t>(a.groups[gi]) * W;
+    const typename V::Mask live = V::load(&s.active[v0]) > V::set1(0.5f);
+    V ph[kVoiceOscs], inc[kVoiceOscs], incStep[kVoiceOscs];
+    typename V::Idx tab[kVoiceOscs];
+    for (int o = 0; o < kVoiceOscs; ++o) {
+      ph[o] = V::load(&s.phase[o][v0]);
+      inc[o] = V::load(&s.inc[o][v0]);
+      incStep[o] = V::load(&s.incStep[o][v0]);
+      tab[o] = V::load_idx(&s.tableOff[o][v0]);
+    }
+    // biquad: b0, b1, b2, a1, a2; SVF: g, k and their per-frame steps
+    V c0 = V::load(&s.coef[0][v0]), c1 = V::load(&s.coef[1][v0]);
+    const V c2 = V::load(&s.coef[2][v0]), c3 = V::load(&s.coef[3][v0]), c4 = V::load(&s.coef[4][v0]);
+    V x1[kVoiceFilterStages], x2[kVoiceFilterStages], y1[kVoiceFilterStages], y2[kVoiceFilterStages];
+    for (int st = 0; st < stages; ++st) {
+      x1[st] = V::load(&s.filt[st][0][v0]);
+      x2[st] = V::load(&s.filt[st][1][v0]);
+      y1[st] = V::load(&s.filt[st][2][v0]);
+      y2[st] = V::load(&s.filt[st][3][v0]);
+    }
+    V env = V::load(&s.envLevel[v0]);
+    V envInc = V::load(&s.envInc[v0]);
+    V stage = V::load(&s.envStage[v0]);
+    V gL = V::load(&s.gainL[v0]), gR = V::load(&s.gainR[v0]);
+    const V gStepL = V::load(&s.gainStepL[v0]), gStepR = V::load(&s.gainStepR[v0]);
+
+    for (unsigned i = 0; i < nframes; ++i) {
+      V sum = zero;
+      for (int o = 0; o < kVoiceOscs; ++o) {
+        inc[o] = inc[o] + incStep[o];
+        ph[o] = ph[o] + inc[o];
+        ph[o] = ph[o] - V::floor_pos(ph[o]);
+        V p = ph[o] + off[o];
+        p = p - V::floor_pos(p);
+        // each lane reads its own mip level; linear interpolation as in SynthVoice
+        V pos = p * tableSize;
+        typename V::Idx idx = V::trunc(pos) + tab[o];
+        V frac = pos - V::floor_pos(pos);
+        V t0 = V::gather(a.table[o], idx), t1 = V::gather(a.table[o] + 1, idx);
+        sum = sum + (t0 + frac * (t1 - t0));
+      }
+      V x = sum * third;
+      if (svf) {
+        // g (c0) and k (c1) ramp per frame; x1/x2 hold ic1/ic2
+        c0 = c0 + c2;
+        c1 = c1 + c3;
+        const V g = c0, sa1 = one / (one + g * (g + c1)), sa2 = g * sa1, band = svfBand * c1;
+        for (int st = 0; st < stages; ++st) {
+          V bp = sa1 * x1[st] + sa2 * (x - x2[st]);
+          V lp = x2[st] + g * bp;
+          x1[st] = bp + bp - x1[st];
+          x2[st] = lp + lp - x2[st];
+          if constexpr (Type == 0) x = lp;           // low
+          else if constexpr (Type == 1) x = c1 * bp; // band
+          else if constexpr (Type == 2) x = x - c1 * bp - lp; // high
+          else x = svfIn * x + band * bp + svfLow * lp;
+        }
+      } else {
+        for (int st = 0; st < stages; ++st) {
+          V y = c0 * x + c1 * x1[st] + c2 * x2[st] - c3 * y1[st] - c4 * y2[st];
+          x2[st] = x1[st];
+          x1[st] = x;
+          y2[st] = y1[st];
+          y1[st] = y;
+          x = y;
+        }
+      }
+
+      // linear ADSR ramps; transitions are decided on the stage at the start of the sample
+      env = env + envInc;
+      typename V::Mask attackDone = (stage == stAttack) & (env >= one);
+      typename V::Mask decayDone = (stage == stDecay) & (env <= sus);
+      typename V::Mask releaseDone = (stage == stRelease) & (env <= zero);
+      env = V::select(attackDone, one, env);
+      envInc = V::select(attackDone, decayInc, envInc);
+      stage = V::select(attackDone, stDecay, stage);
+      env = V::select(decayDone, sus, env);
+      envInc = V::select(decayDone, zero, envInc);
+      stage = V::select(decayDone, stSustain, stage);
+      env = V::select(releaseDone, zero, env);
+      envInc = V::select(releaseDone, zero, envInc);
+      stage = V::select(releaseDone, stIdle, stage);
+
+      gL = gL + gStepL;
+      gR = gR + gStepR;
+      V v = level * env * x;
+      V::store(accL + static_cast<size_t>(i) * W, V::load(accL + static_cast<size_t>(i) * W) + V::select(live, gL * v, zero));
+      V::store(accR + static_cast<size_t>(i) * W, V::load(accR + static_cast<size_t>(i) * W) + V::select(live, gR * v, zero));
+    }
+
+    // lanes that were idle this block keep their state untouched
+    for (int o = 0; o < kVoiceOscs; ++o) V::store(&s.phase[o][v0], V::select(live, ph[o], V::load(&s.phase[o][v0])));
+    for (int st = 0; st < stages; ++st) {
+      V::store(&s.filt[st][0][v0], V::select(live, x1[st], V::load(&s.filt[st][0][v0])));
+      V::store(&s.filt[st][1][v0], V::select(live, x2[st], V::load(&s.filt[st][1][v0])));
+      V::store(&s.filt[st][2][v0], V::select(live, y1[st], V::load(&s.filt[st][2][v0])));
+      V::store(&s.filt[st][3][v0], V::select(live, y2[st], V::load(&s.filt[st][3][v0])));
+    }
+    V::store(&s.envLevel[v0], V::select(live, env, V::load(&s.envLevel[v0])));
+    V::store(&s.envInc[v0], V::select(live, envInc, V::load(&s.envInc[v0])));
+    V::store(&s.envStage[v0], V::select(live, stage, V::load(&s.envStage[v0])));
+  }
+
+  // one horizontal sum per frame for all groups together
+  float* out = a.out;
+  for (unsigned i = 0; i < nframes; ++i) {
+    float l = 0.0f, r = 0.0f;
+    for (int k = 0; k < W; ++k) {
+      l += accL[static_cast<size_t>(i) * W + k];
+      r += accR[static_cast<size_t>(i) * W + k];
+    }
+    if (a.channels == 1) {
+      out[i] += l;
+    } else {
+      out[static_cast<size_t>(i) * a.channels] += l;
+      out[static_cast<size_t>(i) * a.channels + 1] += r;
+    }
+  }
+}
+
+// The kernel for a's filter settings: specialized, or the generic one
+template <class V>
+VoiceKernelFn select_voice_kernel(const VoiceKernelArgs& a, bool specialized) {
+  if (!specialized) return &render_voice_groups<V>;
+  // the biquad's structure is the same for every type
+  static constexpr std::array<VoiceKernelFn, kVoiceFilterStages> biquad{
+      &render_voice_groups<V, 0, kVoiceAny, 1>, &render_voice_groups<V, 0, kVoiceAny, 2>,
+      &render_voice_groups<V, 0, kVoiceAny, 3>, &render_voice_groups<V, 0, kVoiceAny, 4>};
+  static constexpr std::array<std::array<VoiceKernelFn, kVoiceFilterStages>, 3> svf{{
+      {&render_voice_groups<V, 1, 0, 1>, &render_voice_groups<V, 1, 0, 2>,
+       &render_voice_groups<V, 1, 0, 3>, &render_voice_groups<V, 1, 0, 4>},
+      {&render_voice_groups<V, 1, 1, 1>, &render_voice_groups<V, 1, 1, 2>,
+       &render_voice_groups<V, 1, 1, 3>, &render_voice_groups<V, 1, 1, 4>},
+      {&render_voice_groups<V, 1, 2, 1>, &render_voice_groups<V, 1, 2, 2>,
+       &render_voice_groups<V, 1, 2, 3>, &render_voice_groups<V, 1, 2, 4>},
+  }};
+  const int st = a.filterStages < 1 ? 0 : a.filterStages > kVoiceFilterStages ? kVoiceFilterStages - 1 : a.filterStages - 1;
+  if (!a.svf) return biquad[st];
+  const int type = a.filterType < 0 ? 0 : a.filterType > 2 ? 2 : a.filterType;
+  return svf[type][st];
+}
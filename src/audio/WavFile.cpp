@@ -0,0 +1,144 @@
+#include "WavFile.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr uint16_t kFormatPcm = 1;
+constexpr uint16_t kFormatFloat = 3;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+uint16_t rd16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+uint32_t rd32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+void wr16(std::FILE* f, uint16_t v) {
+  uint8_t b[2] = {static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8)};
+  std::fwrite(b, 1, 2, f);
+}
+void wr32(std::FILE* f, uint32_t v) {
+  uint8_t b[4] = {static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v >> 16),
+                  static_cast<uint8_t>(v >> 24)};
+  std::fwrite(b, 1, 4, f);
+}
+}
+
+bool read_wav(const std::string& path, WavData& out) {
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) {
+    std::fprintf(stderr, "Cannot open %s\n", path.c_str());
+    return false;
+  }
+  std::vector<uint8_t> bytes;
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) bytes.insert(bytes.end(), buf, buf + n);
+  std::fclose(f);
+
+  if (bytes.size() < 12 || std::memcmp(bytes.data(), "RIFF", 4) || std::memcmp(bytes.data() + 8, "WAVE", 4)) {
+    std::fprintf(stderr, "%s is not a WAV file\n", path.c_str());
+    return false;
+  }
+  uint16_t format = 0, channels = 0, bits = 0;
+  uint32_t rate = 0;
+  const uint8_t* data = nullptr;
+  size_t dataLen = 0;
+  for (size_t pos = 12; pos + 8 <= bytes.size();) {
+    const uint8_t* chunk = bytes.data() + pos;
+    size_t len = std::min<size_t>(rd32(chunk + 4), bytes.size() - pos - 8);
+    if (!std::memcmp(chunk, "fmt ", 4) && len >= 16) {
+      format = rd16(chunk + 8);
+      channels = rd16(chunk + 10);
+      rate = rd32(chunk + 12);
+      bits = rd16(chunk + 22);
+      if (format == kFormatExtensible && len >= 26) format = rd16(chunk + 32); // sub-format GUID prefix
+    } else if (!std::memcmp(chunk, "data", 4)) {
+      data = chunk + 8;
+      dataLen = len;
+    }
+    pos += 8 + len + (len & 1); // chunks are word aligned
+  }
+  bool supported = (format == kFormatPcm && (bits == 16 || bits == 24 || bits == 32)) ||
+                   (format == kFormatFloat && bits == 32);
+  if (!data || !channels || !rate || !supported) {
+    std::fprintf(stderr, "%s: unsupported WAV format (%u, %u bit)\n", path.c_str(), format, bits);
+    return false;
+  }
+
+  size_t width = bits / 8;
+  size_t count = dataLen / width / channels * channels;
+  out.sampleRate = rate;
+  out.channels = channels;
+  out.samples.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    const uint8_t* p = data + i * width;
+    float v;
+    if (format == kFormatFloat) {
+      uint32_t u = rd32(p);
+      std::memcpy(&v, &u, sizeof(v));
+    } else if (bits == 16) {
+      v = static_cast<int16_t>(rd16(p)) / 32768.0f;
+    } else if (bits == 24) {
+      auto s = static_cast<int32_t>((static_cast<uint32_t>(p[0]) << 8) | (static_cast<uint32_t>(p[1]) << 16) |
+                               (static_cast<uint32_t>(p[2]) << 24));
+      v = static_cast<float>(s >> 8) / 8388608.0f;
+    } else {
+      v = static_cast<float>(static_cast<int32_t>(rd32(p))) / 2147483648.0f;
+    }
+    out.samples[i] = v;
+  }
+  return true;
+}
+
+bool WavWriter::open(const std::string& path, unsigned sampleRate, unsigned channels) {
+  close();
+  f_ = std::fopen(path.c_str(), "wb");
+  if (!f_) {
+    std::fprintf(stderr, "Cannot create %s\n", path.c_str());
+    return false;
+  }
+  channels_ = channels;
+  dataBytes_ = 0;
+  std::fwrite("RIFF", 1, 4, f_);
+  wr32(f_, 0); // patched in close()
+  std::fwrite("WAVEfmt ", 1, 8, f_);
+  wr32(f_, 16);
+  wr16(f_, kFormatFloat);
+  wr16(f_, static_cast<uint16_t>(channels));
+  wr32(f_, sampleRate);
+  wr32(f_, sampleRate * channels * 4);
+  wr16(f_, static_cast<uint16_t>(channels * 4));
+  wr16(f_, 32);
+  std::fwrite("data", 1, 4, f_);
+  wr32(f_, 0);
+  return true;
+}
+
+void WavWriter::write(const float* interleaved, size_t frames) {
+  if (!f_) return;
+  // little-endian bytes in chunks, so long offline renders stay I/O bound
+  uint8_t buf[4096];
+  size_t count = frames * channels_;
+  for (size_t i = 0; i < count;) {
+    size_t n = std::min(count - i, sizeof(buf) / 4);
+    for (size_t k = 0; k < n; ++k, ++i) {
+      uint32_t u;
+      std::memcpy(&u, &interleaved[i], sizeof(u));
+      for (int b = 0; b < 4; ++b) buf[k * 4 + b] = static_cast<uint8_t>(u >> (8 * b));
+    }
+    std::fwrite(buf, 1, n * 4, f_);
+  }
+  dataBytes_ += count * 4;
+}
+
+void WavWriter::close() {
+  if (!f_) return;
+  // RIFF sizes are 32 bit; longer renders are truncated in the header only
+  auto data = static_cast<uint32_t>(std::min<uint64_t>(dataBytes_, 0xFFFFFFFFu - 36));
+  std::fseek(f_, 4, SEEK_SET);
+  wr32(f_, 36 + data);
+  std::fseek(f_, 40, SEEK_SET);
+  wr32(f_, data);
+  std::fclose(f_);
+  f_ = nullptr;
+}
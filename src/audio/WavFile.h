@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Minimal RIFF/WAVE support for offline runs: reads 16/24/32-bit PCM and
+// 32-bit float (plain or WAVE_FORMAT_EXTENSIBLE), writes 32-bit float.
+struct WavData {
+  unsigned sampleRate = 0;
+  unsigned channels = 0;
+  std::vector<float> samples; // interleaved
+  size_t frames() const { return channels ? samples.size() / channels : 0; }
+};
+
+bool read_wav(const std::string& path, WavData& out);
+
+class WavWriter {
+public:
+  ~WavWriter() { close(); }
+  bool open(const std::string& path, unsigned sampleRate, unsigned channels);
+  void write(const float* interleaved, size_t frames);
+  void close(); // patches the chunk sizes
+  bool is_open() const { return f_ != nullptr; }
+
+private:
+  std::FILE* f_ = nullptr;
+  unsigned channels_ = 0;
+  uint64_t dataBytes_ = 0;
+};
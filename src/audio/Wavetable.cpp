@@ -0,0 +1,47 @@
+#include "Wavetable.h"
+
+#include <cmath>
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+}
+
+const WavetableBank& WavetableBank::get() {
+  static const WavetableBank bank;
+  return bank;
+}
+
+WavetableBank::WavetableBank() {
+  constexpr size_t kN = kTableSize;
+  base_[Saw] = 0;
+  base_[Square] = static_cast<size_t>(kMipLevels) * kStride;
+  base_[Sine] = 2 * static_cast<size_t>(kMipLevels) * kStride;
+  data_.assign(base_[Sine] + kStride, 0.0f);
+
+  // sin(2*pi*k*n/N) is sinTab[k*n mod N], so the sums below are exact table reads
+  std::vector<double> sinTab(kN);
+  for (size_t n = 0; n < kN; ++n) sinTab[n] = std::sin(2.0 * kPi * static_cast<double>(n) / kN);
+
+  // Fourier series of the naive shapes: saw 2p-1 = -(2/pi) sum sin(2 pi k p)/k,
+  // square (+1 then -1) = (4/pi) sum over odd k. Levels are built from the top
+  // (fewest harmonics) down, each adding its extra harmonics to the last.
+  for (int wave : {Saw, Square}) {
+    std::vector<double> acc(kN, 0.0);
+    int done = 0;
+    for (int level = kMipLevels - 1; level >= 0; --level) {
+      int harmonics = kMaxHarmonics >> level;
+      for (int k = done + 1; k <= harmonics; ++k) {
+        if (wave == Square && k % 2 == 0) continue;
+        double amp = wave == Saw ? -2.0 / (kPi * k) : 4.0 / (kPi * k);
+        for (size_t n = 0; n < kN; ++n) acc[n] += amp * sinTab[(static_cast<size_t>(k) * n) % kN];
+      }
+      done = harmonics;
+      float* t = data_.data() + base_[wave] + static_cast<size_t>(level) * kStride;
+      for (size_t n = 0; n < kN; ++n) t[n] = static_cast<float>(acc[n]);
+      t[kN] = t[0];
+    }
+  }
+  float* sine = data_.data() + base_[Sine];
+  for (size_t n = 0; n < kN; ++n) sine[n] = static_cast<float>(sinTab[n]);
+  sine[kN] = sine[0];
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Band-limited single-cycle tables for the synth oscillators, built once at
+// startup and shared by every voice. Saw and square have one mip level per
+// octave: level L holds kMaxHarmonics >> L harmonics, and a voice reads the
+// lowest level whose top harmonic still lies below Nyquist, so high notes
+// no longer alias. Sine is a single table. Each table has one guard sample
+// past the end for linear interpolation.
+class WavetableBank {
+public:
+  static constexpr int kTableSize = 4096;
+  static constexpr int kStride = kTableSize + 1;
+  static constexpr int kMipLevels = 11;
+  static constexpr int kMaxHarmonics = 1 << (kMipLevels - 1); // level 0
+  enum Wave { Saw = 0, Square = 1, Sine = 2 };
+
+  // Built on first call; call from a non-real-time thread before audio starts.
+  static const WavetableBank& get();
+
+  // All levels of `wave`, kStride floats apart
+  const float* data(int wave) const { return data_.data() + base_[wave]; }
+  // Offset of `level` from data(wave); sine ignores the level
+  static int level_offset(int wave, int level) { return wave == Sine ? 0 : level * kStride; }
+  // Lowest level whose harmonics stay below Nyquist at `inc` cycles per sample
+  static int level_for(float inc) {
+    int level = 0;
+    while (level < kMipLevels - 1 && static_cast<float>(kMaxHarmonics >> level) * inc >= 0.5f) ++level;
+    return level;
+  }
+
+private:
+  WavetableBank();
+
+  std::vector<float> data_;
+  size_t base_[3] = {0, 0, 0};
+};
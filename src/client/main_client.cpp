@@ -2,25 +2,512 @@
 #include <thread>
 #include <atomic>
 #include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "common/UdpSocket.h"
 #include "common/JitterBuffer.h"
+#include "common/Packet.h"
+#include "common/Session.h"
 #include "audio/AudioIO.h"
+#include "audio/AudioSender.h"
+#include "audio/Convolver.h"
+#include "audio/FileBackend.h"
+#include "audio/InputMonitor.h"
+#include "audio/MixKernels.h"
+#include "audio/ModMatrix.h"
+#include "audio/RemoteMixer.h"
+#include "audio/DspGraph.h"
+#include "audio/DspNodes.h"
 #include "audio/SynthVoice.h"
+#include "audio/VoiceEngine.h"
 
 struct ClientCtx {
   std::atomic<bool> running{true};
-  JitterBuffer jitter;
-  std::mutex tx_m;
-  std::vector<float> lastBlock; // for TX
+  RemoteMixer remote; // one jitter buffer + playout controller per sending peer
+  ClientSession session;
 };
 
+// --bench: single-core throughput of the scalar reference voice against the
+// SIMD engine at each ISA the CPU supports, plus how far the engine's output
+// strays from the reference.
+static void run_voice_bench() {
+  constexpr double kRate = 48000.0;
+  constexpr unsigned kFrames = 128, kChannels = 2;
+  constexpr double kSeconds = 2.0;
+  const unsigned blocks = static_cast<unsigned>(kSeconds * kRate / kFrames);
+  auto setup = [](auto& v) {
+    for (int osc = 0; osc < 3; ++osc) {
+      v.set_osc_wave(osc, osc);
+      v.set_osc_octave(osc, osc == 1 ? -12 : 0);
+      v.set_osc_detune(osc, osc * 6.0f);
+      v.set_osc_phase(osc, osc * 120.0f);
+    }
+    v.set_cutoff(2400.0f);
+    v.set_resonance(1.1f);
+    v.set_filter_slope(2);
+  };
+  auto freq = [](size_t i) { return 110.0f * std::pow(2.0f, static_cast<float>(i % 36) / 12.0f); };
+  auto pan = [](size_t i) { return static_cast<float>(i % 9) / 4.0f - 1.0f; };
+  std::vector<float> ref(kFrames * kChannels), out(kFrames * kChannels);
+
+  std::vector<VoiceEngine::Isa> isas;
+  for (int i = 0; i <= static_cast<int>(VoiceEngine::best_isa()); ++i) isas.push_back(static_cast<VoiceEngine::Isa>(i));
+
+  // deviation: 32 voices, one second, staggered note-ons and releases
+  for (auto isa : isas) {
+    std::vector<SynthVoice> voices(32);
+    VoiceEngine engine;
+    engine.set_isa(isa);
+    engine.set_sample_rate(kRate);
+    setup(engine);
+    for (auto& v : voices) { v.set_sample_rate(kRate); setup(v); }
+    float maxDiff = 0.0f;
+    for (unsigned b = 0; b < blocks / 2; ++b) {
+      for (size_t i = 0; i < voices.size(); ++i) {
+        if (b == i * 4) {
+          voices[i].set_freq(freq(i));
+          voices[i].set_pan(pan(i));
+          voices[i].note_on();
+          engine.note_on(i, freq(i), pan(i));
+        } else if (b == i * 4 + 150) {
+          voices[i].note_off();
+          engine.note_off(i);
+        }
+      }
+      std::fill(ref.begin(), ref.end(), 0.0f);
+      std::fill(out.begin(), out.end(), 0.0f);
+      for (auto& v : voices) if (v.is_active()) v.render(ref.data(), kFrames, kChannels);
+      engine.render(out.data(), kFrames, kChannels);
+      for (size_t i = 0; i < ref.size(); ++i) maxDiff = std::max(maxDiff, std::fabs(ref[i] - out[i]));
+    }
+    printf("%-8s max deviation from the reference: %.2e\n", VoiceEngine::isa_name(isa), maxDiff);
+  }
+
+  printf("\n%8s %-10s %12s %16s\n", "voices", "engine", "ns/voice/smp", "voices per core");
+  for (size_t n : {16u, 64u, 256u}) {
+    auto report = [&](const char* name, double wall) {
+      double nsPerVoiceSample = wall * 1e9 / (static_cast<double>(n) * blocks * kFrames);
+      printf("%8zu %-10s %12.2f %16.0f\n", n, name, nsPerVoiceSample, static_cast<double>(n) * kSeconds / wall);
+    };
+    {
+      std::vector<SynthVoice> voices(n);
+      for (size_t i = 0; i < n; ++i) {
+        voices[i].set_sample_rate(kRate);
+        setup(voices[i]);
+        voices[i].set_freq(freq(i));
+        voices[i].note_on();
+      }
+      auto t0 = std::chrono::steady_clock::now();
+      for (unsigned b = 0; b < blocks; ++b) {
+        std::fill(out.begin(), out.end(), 0.0f);
+        for (auto& v : voices) v.render(out.data(), kFrames, kChannels);
+      }
+      report("reference", std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    }
+    for (auto isa : isas) {
+      VoiceEngine engine;
+      engine.set_isa(isa);
+      engine.set_sample_rate(kRate);
+      setup(engine);
+      for (size_t i = 0; i < n; ++i) engine.note_on(i, freq(i), pan(i));
+      auto t0 = std::chrono::steady_clock::now();
+      for (unsigned b = 0; b < blocks; ++b) {
+        std::fill(out.begin(), out.end(), 0.0f);
+        engine.render(out.data(), kFrames, kChannels);
+      }
+      report(VoiceEngine::isa_name(isa), std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    }
+  }
+
+  // filter models at 64 voices: biquad against SVF, with the cutoff held
+  // and swept every block, for the reference voice and the widest ISA
+  printf("\n%8s %-10s %-7s %6s %-6s %12s %10s\n", "voices", "engine", "filter", "stages", "cutoff", "ns/voice/smp",
+         "deviation");
+  for (int stages : {2, 4}) {
+    for (bool sweep : {false, true}) {
+      for (int mode : {0, 1}) {
+        constexpr size_t n = 64;
+        auto cutoffAt = [&](unsigned b) {
+          return sweep ? 400.0f * std::pow(2.0f, 2.0f + 2.0f * std::sin(static_cast<float>(b) * 0.05f)) : 2400.0f;
+        };
+        std::vector<SynthVoice> voices(n);
+        VoiceEngine engine;
+        engine.set_sample_rate(kRate);
+        setup(engine);
+        engine.set_filter_slope(stages);
+        engine.set_filter_mode(mode);
+        for (size_t i = 0; i < n; ++i) {
+          voices[i].set_sample_rate(kRate);
+          setup(voices[i]);
+          voices[i].set_filter_slope(stages);
+          voices[i].set_filter_mode(mode);
+          voices[i].set_freq(freq(i));
+          voices[i].set_pan(pan(i));
+          voices[i].note_on();
+          engine.note_on(i, freq(i), pan(i));
+        }
+        double refWall = 0.0, engineWall = 0.0;
+        float maxDiff = 0.0f;
+        for (unsigned b = 0; b < blocks; ++b) {
+          for (auto& v : voices) v.set_cutoff(cutoffAt(b));
+          engine.set_cutoff(cutoffAt(b));
+          std::fill(ref.begin(), ref.end(), 0.0f);
+          std::fill(out.begin(), out.end(), 0.0f);
+          auto t0 = std::chrono::steady_clock::now();
+          for (auto& v : voices) v.render(ref.data(), kFrames, kChannels);
+          auto t1 = std::chrono::steady_clock::now();
+          engine.render(out.data(), kFrames, kChannels);
+          auto t2 = std::chrono::steady_clock::now();
+          refWall += std::chrono::duration<double>(t1 - t0).count();
+          engineWall += std::chrono::duration<double>(t2 - t1).count();
+          // the engine glides the cutoff, so only a held one compares
+          if (!sweep)
+            for (size_t i = 0; i < ref.size(); ++i) maxDiff = std::max(maxDiff, std::fabs(ref[i] - out[i]));
+        }
+        const double samples = static_cast<double>(n) * blocks * kFrames;
+        const char* filter = mode ? "SVF" : "biquad";
+        const char* cutoff = sweep ? "swept" : "held";
+        char dev[16] = "-";
+        if (!sweep) std::snprintf(dev, sizeof(dev), "%.2e", maxDiff);
+        printf("%8zu %-10s %-7s %6d %-6s %12.2f %10s\n", n, "reference", filter, stages, cutoff,
+               refWall * 1e9 / samples, dev);
+        printf("%8zu %-10s %-7s %6d %-6s %12.2f %10s\n", n, VoiceEngine::isa_name(engine.isa()), filter, stages,
+               cutoff, engineWall * 1e9 / samples, "");
+      }
+    }
+  }
+
+  // modulation at 64 voices: vibrato, auto-pan, filter envelope, key
+  // tracking and velocity, against no routes, per control period
+  printf("\n%8s %-10s %-9s %12s %10s\n", "voices", "engine", "mod", "ns/voice/smp", "deviation");
+  for (int period : {0, 8, 16, 32, 64}) {
+    constexpr size_t n = 64;
+    ModMatrix mod;
+    if (period) {
+      mod.lfo[0] = {5.5f, ModMatrix::LfoSine};
+      mod.lfo[1] = {0.7f, ModMatrix::LfoTriangle};
+      mod.routes[0] = {ModMatrix::SrcLfo1, ModMatrix::DstPitch, 0.3f};
+      mod.routes[1] = {ModMatrix::SrcLfo2, ModMatrix::DstPan, 0.6f};
+      mod.routes[2] = {ModMatrix::SrcFilterEnv, ModMatrix::DstCutoff, 3.0f};
+      mod.routes[3] = {ModMatrix::SrcKey, ModMatrix::DstCutoff, 0.5f};
+      mod.routes[4] = {ModMatrix::SrcVelocity, ModMatrix::DstAmp, 1.0f};
+      mod.controlPeriod = period;
+    }
+    auto velocity = [](size_t i) { return 0.4f + 0.6f * static_cast<float>(i % 5) / 4.0f; };
+    std::vector<SynthVoice> voices(n);
+    VoiceEngine engine;
+    engine.set_sample_rate(kRate);
+    setup(engine);
+    engine.set_mod_matrix(mod);
+    for (size_t i = 0; i < n; ++i) {
+      voices[i].set_sample_rate(kRate);
+      setup(voices[i]);
+      voices[i].set_mod_matrix(mod);
+      voices[i].set_freq(freq(i));
+      voices[i].set_pan(pan(i));
+      voices[i].note_on(velocity(i));
+      engine.note_on(i, freq(i), pan(i), velocity(i));
+    }
+    double refWall = 0.0, engineWall = 0.0;
+    float maxDiff = 0.0f;
+    for (unsigned b = 0; b < blocks; ++b) {
+      std::fill(ref.begin(), ref.end(), 0.0f);
+      std::fill(out.begin(), out.end(), 0.0f);
+      auto t0 = std::chrono::steady_clock::now();
+      for (auto& v : voices) v.render(ref.data(), kFrames, kChannels);
+      auto t1 = std::chrono::steady_clock::now();
+      engine.render(out.data(), kFrames, kChannels);
+      auto t2 = std::chrono::steady_clock::now();
+      refWall += std::chrono::duration<double>(t1 - t0).count();
+      engineWall += std::chrono::duration<double>(t2 - t1).count();
+      for (size_t i = 0; i < ref.size(); ++i) maxDiff = std::max(maxDiff, std::fabs(ref[i] - out[i]));
+    }
+    const double samples = static_cast<double>(n) * blocks * kFrames;
+    char label[16] = "none";
+    if (period) std::snprintf(label, sizeof(label), "every %d", period);
+    char dev[16];
+    std::snprintf(dev, sizeof(dev), "%.2e", maxDiff);
+    printf("%8zu %-10s %-9s %12.2f %10s\n", n, "reference", label, refWall * 1e9 / samples, dev);
+    printf("%8zu %-10s %-9s %12.2f %10s\n", n, VoiceEngine::isa_name(engine.isa()), label,
+           engineWall * 1e9 / samples, "");
+  }
+
+  // specialized kernels at 64 voices against the generic loop (filter
+  // settings read at run time), per filter configuration
+  printf("\n%8s %-10s %-12s %6s %10s %12s %8s\n", "voices", "engine", "filter", "stages", "generic ns",
+         "specialized", "speedup");
+  struct FilterConfig {
+    const char* name;
+    int mode, type, stages;
+  };
+  for (const FilterConfig& fc : {FilterConfig{"biquad low", 0, 0, 1}, FilterConfig{"biquad low", 0, 0, 4},
+                                 FilterConfig{"SVF low", 1, 0, 2}, FilterConfig{"SVF high", 1, 2, 4}}) {
+    constexpr size_t n = 64;
+    auto configure = [&](auto& v) {
+      setup(v);
+      v.set_filter_mode(fc.mode);
+      v.set_filter_type(fc.type);
+      v.set_filter_slope(fc.stages);
+    };
+    // both variants side by side, alternating per block, so clock drift
+    // hits them alike
+    std::vector<SynthVoice> voices[2] = {std::vector<SynthVoice>(n), std::vector<SynthVoice>(n)};
+    VoiceEngine engines[2];
+    for (int specialized : {0, 1}) {
+      VoiceEngine& engine = engines[specialized];
+      engine.set_sample_rate(kRate);
+      configure(engine);
+      engine.set_specialized_kernels(specialized != 0);
+      for (size_t i = 0; i < n; ++i) {
+        SynthVoice& v = voices[specialized][i];
+        v.set_sample_rate(kRate);
+        configure(v);
+        v.set_specialized_kernels(specialized != 0);
+        v.set_freq(freq(i));
+        v.set_pan(pan(i));
+        v.note_on();
+        engine.note_on(i, freq(i), pan(i));
+      }
+    }
+    double refWall[2] = {}, engineWall[2] = {};
+    for (unsigned b = 0; b < blocks; ++b) {
+      for (int specialized : {0, 1}) {
+        std::fill(out.begin(), out.end(), 0.0f);
+        auto t0 = std::chrono::steady_clock::now();
+        for (auto& v : voices[specialized]) v.render(out.data(), kFrames, kChannels);
+        auto t1 = std::chrono::steady_clock::now();
+        engines[specialized].render(out.data(), kFrames, kChannels);
+        auto t2 = std::chrono::steady_clock::now();
+        refWall[specialized] += std::chrono::duration<double>(t1 - t0).count();
+        engineWall[specialized] += std::chrono::duration<double>(t2 - t1).count();
+      }
+    }
+    const double samples = static_cast<double>(n) * blocks * kFrames;
+    printf("%8zu %-10s %-12s %6d %10.2f %12.2f %7.2fx\n", n, "reference", fc.name, fc.stages,
+           refWall[0] * 1e9 / samples, refWall[1] * 1e9 / samples, refWall[0] / refWall[1]);
+    printf("%8zu %-10s %-12s %6d %10.2f %12.2f %7.2fx\n", n, VoiceEngine::isa_name(VoiceEngine::best_isa()), fc.name,
+           fc.stages, engineWall[0] * 1e9 / samples, engineWall[1] * 1e9 / samples, engineWall[0] / engineWall[1]);
+  }
+
+  // oversampling cost at 64 voices with the widest ISA, one thread
+  printf("\n%8s %-10s %12s %16s\n", "voices", "quality", "ns/voice/smp", "voices per core");
+  for (unsigned factor : {1u, 2u, 4u, 8u}) {
+    constexpr size_t n = 64;
+    VoiceEngine engine;
+    engine.set_oversampling(factor);
+    engine.set_sample_rate(kRate);
+    setup(engine);
+    for (size_t i = 0; i < n; ++i) engine.note_on(i, freq(i), pan(i));
+    auto t0 = std::chrono::steady_clock::now();
+    for (unsigned b = 0; b < blocks; ++b) {
+      std::fill(out.begin(), out.end(), 0.0f);
+      engine.render(out.data(), kFrames, kChannels);
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    char label[16];
+    std::snprintf(label, sizeof(label), "%ux", factor);
+    printf("%8zu %-10s %12.2f %16.0f\n", n, label, wall * 1e9 / (static_cast<double>(n) * blocks * kFrames),
+           static_cast<double>(n) * kSeconds / wall);
+  }
+
+  // worker pool scaling at full polyphony with the widest ISA
+  printf("\n%8s %-10s %12s %16s\n", "voices", "threads", "ms/block", "realtime x");
+  const unsigned maxThreads = std::max(2u, VoiceEngine::default_render_threads());
+  for (unsigned threads = 1; threads <= maxThreads; ++threads) {
+    VoiceEngine engine;
+    engine.set_render_threads(threads);
+    engine.set_sample_rate(kRate);
+    setup(engine);
+    for (size_t i = 0; i < VoiceEngine::kMaxVoices; ++i) engine.note_on(i, freq(i), pan(i));
+    auto t0 = std::chrono::steady_clock::now();
+    for (unsigned b = 0; b < blocks; ++b) {
+      std::fill(out.begin(), out.end(), 0.0f);
+      engine.render(out.data(), kFrames, kChannels);
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    printf("%8zu %-10u %12.3f %16.1f\n", VoiceEngine::kMaxVoices, threads, wall * 1e3 / blocks, kSeconds / wall);
+  }
+}
+
+// --bench, continued: cost of the convolution reverb with a 2 s stereo
+// response at 128-frame blocks. Blocks are paced in real time so the tail
+// thread works to the same deadlines as in a live stream.
+static void run_reverb_bench() {
+  constexpr double kRate = 48000.0;
+  constexpr unsigned kFrames = 128, kChannels = 2;
+  constexpr double kSeconds = 3.0, kIrSeconds = 2.0;
+  // exponentially decaying noise stands in for a room
+  const auto irFrames = static_cast<size_t>(kIrSeconds * kRate);
+  std::vector<float> ir(irFrames * kChannels);
+  uint32_t seed = 1;
+  for (size_t i = 0; i < ir.size(); ++i) {
+    seed = seed * 1664525u + 1013904223u;
+    float noise = static_cast<float>(seed >> 8) / 8388608.0f - 1.0f;
+    ir[i] = noise * std::exp(-6.9f * static_cast<float>(i / kChannels) / static_cast<float>(irFrames));
+  }
+  Convolver conv(ir.data(), irFrames, kChannels);
+
+  std::vector<float> in(kFrames * kChannels), out(kFrames * kChannels);
+  const unsigned blocks = static_cast<unsigned>(kSeconds * kRate / kFrames);
+  const auto period = std::chrono::duration<double>(kFrames / kRate);
+  double busy = 0.0;
+  auto deadline = std::chrono::steady_clock::now();
+  for (unsigned b = 0; b < blocks; ++b) {
+    for (size_t i = 0; i < in.size(); ++i) in[i] = std::sin(0.01f * static_cast<float>(b * in.size() + i));
+    auto t0 = std::chrono::steady_clock::now();
+    conv.process(in.data(), out.data(), kFrames, kChannels);
+    busy += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    deadline += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+    std::this_thread::sleep_until(deadline);
+  }
+  printf("\nreverb, %.0f s stereo response, %u-frame blocks: audio thread %.2f%%, tail thread %.2f%% of one core, "
+         "%llu late tail blocks\n",
+         kIrSeconds, kFrames, 100.0 * busy / kSeconds, 100.0 * conv.tail_seconds() / kSeconds,
+         static_cast<unsigned long long>(conv.late_blocks()));
+}
+
+// --bench, continued: the lock-free jitter ring against the mutex/deque
+// buffer it replaced, with a network thread pushing as fast as it can so
+// the callback side is under constant contention. The mutex version is the
+// old code kept here only for comparison.
+namespace {
+class MutexJitterBuffer {
+public:
+  void push(const std::vector<float>& block) {
+    std::scoped_lock<std::mutex> lk(m_);
+    q_.push_back(block);
+    if (q_.size() > 64) q_.pop_front();
+  }
+  size_t pop(float* out, size_t nframes) {
+    std::scoped_lock<std::mutex> lk(m_);
+    if (q_.size() <= target_) return 0;
+    auto blk = q_.front();
+    q_.pop_front();
+    size_t n = std::min(nframes, blk.size());
+    std::copy_n(blk.data(), n, out);
+    return n;
+  }
+  size_t size() const {
+    std::scoped_lock<std::mutex> lk(m_);
+    return q_.size();
+  }
+
+private:
+  std::deque<std::vector<float>> q_;
+  mutable std::mutex m_;
+  size_t target_ = 2;
+};
+
+struct PopTimes {
+  double meanUs = 0.0, p99Us = 0.0, maxUs = 0.0;
+};
+
+// Times `pops` calls of pop() while push() runs flat out on another thread
+template <class Push, class Pop>
+PopTimes time_contended_pops(size_t pops, Push&& push, Pop&& pop) {
+  std::atomic<bool> stop{false};
+  std::thread producer([&] {
+    while (!stop.load(std::memory_order_relaxed)) push();
+  });
+  std::vector<double> us(pops);
+  for (size_t i = 0; i < pops; ++i) {
+    auto t0 = std::chrono::steady_clock::now();
+    pop();
+    us[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+  }
+  stop.store(true);
+  producer.join();
+  PopTimes t;
+  for (double v : us) t.meanUs += v;
+  t.meanUs /= static_cast<double>(pops);
+  std::sort(us.begin(), us.end());
+  t.p99Us = us[pops * 99 / 100];
+  t.maxUs = us.back();
+  return t;
+}
+} // namespace
+
+static void run_jitter_bench() {
+  constexpr unsigned kFrames = 128, kChannels = 2;
+  constexpr size_t kPops = 200000;
+  std::vector<float> block(kFrames * kChannels, 0.25f), out(kFrames * kChannels);
+
+  JitterBuffer ring(8192, kChannels);
+  ring.set_channels(kChannels);
+  ring.set_target_frames(2 * kFrames);
+  PopTimes lockFree = time_contended_pops(
+      kPops,
+      [&] {
+        if (ring.capacity() - ring.size() >= kFrames) ring.push(block.data(), kFrames);
+        else std::this_thread::yield();
+      },
+      [&] { ring.pop(out.data(), kFrames); });
+
+  MutexJitterBuffer locked;
+  PopTimes mutex = time_contended_pops(
+      kPops,
+      [&] {
+        if (locked.size() < 64) locked.push(block);
+        else std::this_thread::yield();
+      },
+      [&] { locked.pop(out.data(), kFrames * kChannels); });
+
+  printf("\njitter buffer, %u-frame stereo pops against a flat-out pusher (%zu pops)\n", kFrames, kPops);
+  printf("%-12s %10s %10s %10s\n", "buffer", "mean us", "p99 us", "max us");
+  printf("%-12s %10.3f %10.3f %10.1f\n", "lock-free", lockFree.meanUs, lockFree.p99Us, lockFree.maxUs);
+  printf("%-12s %10.3f %10.3f %10.1f\n", "mutex", mutex.meanUs, mutex.p99Us, mutex.maxUs);
+}
+
 int main(int argc, char** argv) {
-  if (argc < 3) {
-    printf("Usage: lan_jam_client <server_ip> <server_port>\n");
+  std::vector<std::string> args;
+  std::string backendSpec = "rtaudio";
+  double seconds = 0.0;
+  bool bot = false, listDevices = false;
+  AudioStreamConfig streamCfg;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--backend" && i + 1 < argc) backendSpec = argv[++i];
+    else if (a == "--rate" && i + 1 < argc) streamCfg.sampleRate = static_cast<unsigned>(std::stoul(argv[++i]));
+    else if (a == "--frames" && i + 1 < argc) streamCfg.frames = std::clamp<unsigned>(std::stoul(argv[++i]), 32, 1024);
+    else if (a == "--device" && i + 1 < argc) streamCfg.outputDevice = streamCfg.inputDevice = std::stoul(argv[++i]);
+    else if (a == "--list-devices") listDevices = true;
+    else if (a == "--bench") {
+      run_voice_bench();
+      run_reverb_bench();
+      run_jitter_bench();
+      return 0;
+    }
+    else if (a == "--seconds" && i + 1 < argc) seconds = std::stod(argv[++i]);
+    else if (a == "--bot") bot = true;
+    else args.push_back(a);
+  }
+  auto backend = make_audio_backend(backendSpec, seconds);
+  if (backend && listDevices) {
+    for (const auto& d : backend->devices()) {
+      printf("%3u  %-40s out %2u  in %2u%s%s\n", d.id, d.name.c_str(), d.outputChannels, d.inputChannels,
+             d.isDefaultOutput ? "  [default out]" : "", d.isDefaultInput ? "  [default in]" : "");
+    }
+    return 0;
+  }
+  if (args.size() < 2 || !backend) {
+    printf("Usage: lan_jam_client <server_ip> <server_port> [input_channel]\n"
+           "                      [--backend rtaudio|null|file:<out.wav>[,<in.wav>]] [--seconds N] [--bot]\n"
+           "                      [--rate Hz] [--frames 32..1024] [--device id] [--list-devices]\n"
+           "       lan_jam_client --bench\n");
     return 1;
   }
-  std::string host = argv[1];
-  uint16_t port = static_cast<uint16_t>(std::stoi(argv[2]));
+  std::string host = args[0];
+  uint16_t port = static_cast<uint16_t>(std::stoi(args[1]));
+  streamCfg.inputChannel = args.size() > 2 ? std::stoi(args[2]) : AudioIO::kNoInput;
+  const unsigned rate = streamCfg.sampleRate; // RtAudio opens at exactly this rate or fails
+  // Anything but a sound card runs unattended: report periodically instead of waiting for Enter
+  bool unattended = bot || seconds > 0.0 || backendSpec != "rtaudio";
 
   asio::io_context io;
   UdpSocket udp(io);
@@ -28,55 +515,194 @@ int main(int argc, char** argv) {
   udp.set_remote(host, port);
 
   ClientCtx ctx;
-  ctx.jitter.set_target_blocks(2); // ~2 audio buffers of delay
+  ctx.remote.set_sample_rate(rate);
+  ctx.remote.set_block_frames(streamCfg.frames);
 
   // RX thread
   std::thread rx([&]{
-    std::vector<uint8_t> buf(1500);
+    std::vector<uint8_t> buf(kMaxDatagram);
+    std::vector<float> samples(kMaxDatagram / sizeof(float));
     asio::ip::udp::endpoint from;
+    auto lastReap = std::chrono::steady_clock::now();
     while (ctx.running.load()) {
       size_t n = udp.recv(buf.data(), buf.size(), from);
       if (!n) continue;
-      // Interpret payload as float32 mono frames
-      if (n % sizeof(float) != 0) continue;
-      size_t frames = n / sizeof(float);
-      std::vector<float> block(frames);
-      std::memcpy(block.data(), buf.data(), n);
-      ctx.jitter.push(block);
+      MsgType type;
+      if (!peek_msg_type(buf.data(), n, type)) continue;
+      if (type == MsgType::Welcome) {
+        WelcomeMsg welcome;
+        if (!decode_welcome(buf.data(), n, welcome)) continue;
+        ctx.session.apply(welcome);
+        if (welcome.status == WelcomeStatus::Rejected) {
+          printf("Server rejected session: %s\n", to_string(welcome.reason));
+        } else {
+          printf("Session %u Hz, %u frames/packet, %u ch, pcm %s (sender %u)\n", welcome.config.sample_rate,
+                 welcome.config.block_frames, welcome.config.channels, to_string(welcome.config.format),
+                 welcome.sender_id);
+        }
+        continue;
+      }
+      if (type != MsgType::Audio) continue;
+      PacketHeader hdr;
+      size_t count = decode_audio(buf.data(), n, hdr, samples.data(), samples.size());
+      if (!count) continue;
+      auto now = std::chrono::steady_clock::now();
+      auto arrival = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          now.time_since_epoch()).count());
+      ctx.remote.on_packet(hdr, samples.data(), count, arrival);
+      if (now - lastReap > std::chrono::milliseconds(500)) {
+        lastReap = now;
+        ctx.remote.reap(now);
+      }
+    }
+  });
+
+  // Handshake: repeat HELLO until the server answers
+  std::thread hello([&]{
+    HelloMsg msg;
+    msg.caps.sample_rate = rate;
+    msg.caps.block_frames = static_cast<uint16_t>(streamCfg.frames);
+    msg.caps.channels = kMaxWireChannels;
+    std::vector<uint8_t> buf(64);
+    size_t len = encode_hello(buf.data(), buf.size(), msg);
+    while (ctx.running.load() && !ctx.session.ready.load() && !ctx.session.rejected.load()) {
+      udp.send(buf.data(), len);
+      std::this_thread::sleep_for(std::chrono::milliseconds(kHelloRetryMs));
     }
   });
 
   // Audio
-  AudioIO audio;
-  SynthVoice synth;
-  synth.set_sample_rate(48000.0);
-  audio.set_callback([&](float* out, unsigned nframes){
-    // 1) Local synth
-    synth.render(out, nframes);
-
-    // 2) Mix in remote
-    std::vector<float> mix(nframes, 0.0f);
-    size_t got = ctx.jitter.pop(mix.data(), nframes);
-    if (got) {
-      for (size_t i = 0; i < got; ++i) out[i] += 0.5f * mix[i];
-    }
-
-    // 3) Ship current block as PCM
-    // Copy out to tx buffer to avoid racing
-    std::vector<uint8_t> bytes(nframes * sizeof(float));
-    std::memcpy(bytes.data(), out, bytes.size());
-    udp.send(bytes.data(), bytes.size());
+  AudioIO audio(std::move(backend));
+  AudioSender sender(udp, ctx.session);
+  sender.start();
+  InputMonitor monitor;
+  // The local voice as a graph patch: three saws -> low-pass -> ADSR -> level
+  DspGraph voice;
+  auto* oscMix = voice.add<MixerNode>(3, 1.0f / 3.0f);
+  std::array<OscillatorNode*, 3> oscs{};
+  for (unsigned i = 0; i < oscs.size(); ++i) {
+    oscs[i] = voice.add<OscillatorNode>(0);
+    voice.connect(oscs[i], oscMix, i);
+  }
+  auto* filter = voice.add<FilterNode>();
+  auto* env = voice.add<EnvelopeNode>();
+  auto* level = voice.add<GainNode>(0.15f);
+  voice.connect(oscMix, filter);
+  voice.connect(filter, env);
+  voice.connect(env, level);
+  constexpr unsigned kGraphMaxFrames = 4096;
+  voice.compile(rate, kGraphMaxFrames, kMaxWireChannels);
+
+  // Master bus: the voice, the input heard directly and every remote peer.
+  // The send path taps the voice alone, so peers never hear themselves.
+  const float* busIn = nullptr; // this block's capture
+  DspGraph bus;
+  DspNode* synthBus = bus.add_source([&](const DspContext& c, float* o) {
+    voice.process(c);
+    std::copy_n(voice.output(level), static_cast<size_t>(c.nframes) * c.channels, o);
+    audio.meter().mark(DspStage::Synth);
+  });
+  DspNode* monitorBus = bus.add_source([&](const DspContext& c, float* o) {
+    monitor.process(busIn, o, c.nframes, c.channels, InputMonitor::Direct, 1.0f);
+  });
+  DspNode* remoteBus = bus.add_source([&](const DspContext& c, float* o) {
+    ctx.remote.mix(o, c.nframes, c.channels, 0.5f);
+    audio.meter().mark(DspStage::RemoteMix);
   });
-  if (!audio.open(48000, 128)) {
-    printf("Failed to open audio\n");
+  auto* master = bus.add<MixerNode>(3);
+  bus.connect(synthBus, master, 0);
+  bus.connect(monitorBus, master, 1);
+  bus.connect(remoteBus, master, 2);
+  bus.expose(synthBus);
+  bus.compile(rate, kGraphMaxFrames, kMaxWireChannels);
+
+  uint64_t frameClock = 0; // frames rendered, drives the bot's pattern
+  audio.set_callback([&](const float* in, float* out, unsigned nframes){
+    const unsigned ch = audio.channels();
+    // 1) As a bot, play a pentatonic eighth-note pattern at 120 BPM
+    if (bot) {
+      static constexpr float kScale[] = {220.0f, 246.94f, 277.18f, 329.63f, 369.99f, 440.0f};
+      const uint64_t stepFrames = rate / 4; // frames per eighth note
+      uint64_t step = frameClock / stepFrames;
+      if ((frameClock + nframes) / stepFrames != step || frameClock == 0) {
+        for (auto* osc : oscs) osc->set_freq(kScale[(step * 7 + step / 6) % 6]);
+        env->gate(true, rate);
+      } else if (frameClock % stepFrames < stepFrames / 2 && (frameClock + nframes) % stepFrames >= stepFrames / 2) {
+        env->gate(false, rate);
+      }
+      frameClock += nframes;
+    }
+    audio.meter().mark(DspStage::Sequencer);
+
+    // 2) Run the bus, then queue synth + live input for the sender thread in
+    //    as many channels as the session allows
+    const bool sending = ctx.session.ready.load();
+    const unsigned sendCh = std::clamp<unsigned>(ctx.session.channels.load(), 1, std::min<unsigned>(ch, kMaxWireChannels));
+    const auto now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    for (unsigned off = 0; off < nframes; off += bus.max_frames()) {
+      const unsigned n = std::min(nframes - off, bus.max_frames());
+      busIn = in ? in + off : nullptr;
+      bus.process({n, ch, static_cast<double>(rate)});
+      std::copy_n(bus.output(master), static_cast<size_t>(n) * ch, out + static_cast<size_t>(off) * ch);
+      if (!sending) continue;
+      const float* synth = bus.output(synthBus);
+      float tx[AudioSender::kBlockFrames * kMaxWireChannels];
+      for (unsigned sub = 0; sub < n; sub += AudioSender::kBlockFrames) {
+        unsigned m = std::min(n - sub, AudioSender::kBlockFrames);
+        std::fill_n(tx, m * sendCh, 0.0f);
+        mix_channels(tx, sendCh, synth + static_cast<size_t>(sub) * ch, ch, m, 1.0f);
+        if (busIn) mix_channels(tx, sendCh, busIn + sub, 1, m, 1.0f);
+        sender.submit(tx, m, sendCh, now + static_cast<uint64_t>(off + sub) * 1000000000ull / rate, rate);
+      }
+    }
+    audio.meter().mark(DspStage::Send);
+  });
+  auto start = std::chrono::steady_clock::now();
+  if (!audio.open(streamCfg)) {
+    printf("Failed to open audio (%s backend)\n", audio.backend_name());
     ctx.running = false;
+  } else if (audio.has_input()) {
+    printf("Capturing input channel %d (device latency %u frames)\n", streamCfg.inputChannel, audio.latency_frames());
   }
 
-  printf("Client running. Press Enter to quit.\n");
-  getchar();
+  if (!unattended) {
+    printf("Client running. Press Enter to quit.\n");
+    getchar();
+  } else {
+    printf("Client running on the %s backend%s\n", audio.backend_name(), bot ? " as a bot" : "");
+    auto elapsed = [&]{ return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    // the file backend finishes by itself; the others run for --seconds (or until killed)
+    double nextReport = 1.0;
+    while (ctx.running.load() && audio.is_running() && (seconds <= 0.0 || elapsed() < seconds)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      if (elapsed() < nextReport) continue;
+      nextReport += 1.0;
+      auto load = audio.meter().report();
+      printf("[%6.0fs] dsp %.1f%% p99 %.3f ms xruns %llu late %llu | peers %zu", elapsed(), load.loadPercent,
+             load.p99Ms, static_cast<unsigned long long>(load.xruns), static_cast<unsigned long long>(load.lateBlocks),
+             ctx.remote.active_count());
+      for (size_t i = 0; i < RemoteMixer::kMaxPeers; ++i) {
+        const auto& s = ctx.remote.stream(i);
+        if (s.state.load() != RemoteMixer::Stream::Active) continue;
+        printf(" | #%u depth %zu/%zu underruns %llu drift %.0f ppm", s.senderId.load(), s.jitter.size(),
+               s.jitter.target_frames(), static_cast<unsigned long long>(s.jitter.underruns()),
+               s.resampler.drift_ppm());
+      }
+      printf("\n");
+    }
+    if (auto* file = dynamic_cast<FileBackend*>(&audio.backend())) {
+      double rendered = static_cast<double>(file->rendered_frames()) / rate;
+      printf("Rendered %.1f s of audio in %.2f s (%.1fx real time)\n", rendered, elapsed(),
+             rendered / std::max(elapsed(), 1e-6));
+    }
+  }
 
   ctx.running = false;
   audio.close();
+  sender.stop();
+  udp.close();
   rx.join();
+  hello.join();
   return 0;
 }
@@ -11,106 +11,308 @@
 
 #include "common/UdpSocket.h"
 #include "common/Discovery.h"
-#include "common/JitterBuffer.h"
+#include "common/ServerDirectory.h"
+#include "common/Packet.h"
+#include "common/Session.h"
+#include "common/SharedTransport.h"
 #include "audio/AudioIO.h"
-#include "audio/SynthVoice.h"
+#include "audio/AudioSender.h"
+#include "audio/Convolver.h"
+#include "audio/DspGraph.h"
+#include "audio/DspNodes.h"
+#include "audio/EventQueue.h"
+#include "audio/InputMonitor.h"
+#include "audio/MixKernels.h"
+#include "audio/RemoteMixer.h"
+#include "audio/VoiceAllocator.h"
+#include "audio/VoiceEngine.h"
+#include "audio/WavFile.h"
 #include "gui/GuiApp.h"
 
-// Simple polyphonic voice pool used from the audio thread only
-struct Voice {
-  SynthVoice synth;
-  int note = -1; // 0..11, -1 idle
-  bool released = false; // note_off called
-  uint64_t lastUsed = 0; // for voice stealing
-};
+static std::vector<AudioDeviceChoice> to_choices(const std::vector<AudioDeviceInfo>& devices) {
+  std::vector<AudioDeviceChoice> list;
+  for (const auto& d : devices) {
+    AudioDeviceChoice c;
+    c.id = d.id;
+    c.name = d.name;
+    c.outputChannels = d.outputChannels;
+    c.inputChannels = d.inputChannels;
+    c.sampleRates = d.sampleRates;
+    c.isDefaultOutput = d.isDefaultOutput;
+    c.isDefaultInput = d.isDefaultInput;
+    list.push_back(std::move(c));
+  }
+  return list;
+}
 
+// Polyphonic voice pool used from the audio thread only. The engine
+// renders; the allocator keeps the note bookkeeping for allocation and
+// stealing. Voices are preallocated up front; polyphony only caps how many
+// may sound, so changing it never allocates on the audio thread.
 struct VoicePool {
-  std::vector<Voice> voices;
-  uint64_t tick = 0;
-
-  VoicePool(size_t n, double sr) { voices.resize(n); for (auto &v : voices) v.synth.set_sample_rate(sr); }
-  void resize(size_t n, double sr) {
-    voices.clear();
-    voices.resize(n);
-    for (auto &v : voices) v.synth.set_sample_rate(sr);
-    tick = 0;
+  static_assert(VoiceAllocator::kMaxVoices == VoiceEngine::kMaxVoices);
+  VoiceEngine engine;
+  VoiceAllocator alloc;
+  double sampleRate = 0.0;
+  float pan = 0.0f, spread = 0.0f; // applied to voices as they start
+
+  VoicePool(size_t n, double sr) : alloc(n) {
+    set_sample_rate(sr);
+    // helpers only join in when enough voices are sounding
+    engine.set_render_threads(VoiceEngine::default_render_threads());
   }
+  // Only recomputes coefficients lazily, so it is safe on the audio thread
+  void set_sample_rate(double sr) {
+    sampleRate = sr;
+    engine.set_sample_rate(sr);
+  }
+  // Voices beyond a lowered limit keep sounding until stolen or released
+  void set_polyphony(size_t n) { alloc.set_limit(n); }
 
-  void set_global_params_from_gui(const GuiState& gui) {
-    for (size_t i = 0; i < voices.size(); ++i) {
-      auto &v = voices[i];
-      for (int osc = 0; osc < 3; ++osc) {
-        v.synth.set_osc_wave(osc, gui.params.osc[osc].wave.load());
-        v.synth.set_osc_octave(osc, gui.params.osc[osc].octave.load());
-        v.synth.set_osc_detune(osc, gui.params.osc[osc].detune.load());
-        v.synth.set_osc_phase(osc, gui.params.osc[osc].phase.load());
-      }
-      v.synth.set_cutoff(gui.params.cutoff.load());
-      v.synth.set_resonance(gui.params.resonance.load());
-      v.synth.set_filter_type(gui.params.filterType.load());
-      v.synth.set_filter_slope(gui.params.filterSlope.load());
-      v.synth.set_env_attack(gui.params.envAttack.load());
-      v.synth.set_env_decay(gui.params.envDecay.load());
-      v.synth.set_env_sustain(gui.params.envSustain.load());
-      v.synth.set_env_release(gui.params.envRelease.load());
+  // Called only when the GUI publishes a changed patch
+  void apply(const SynthPatch& p) {
+    for (int osc = 0; osc < 3; ++osc) {
+      engine.set_osc_wave(osc, p.osc[osc].wave);
+      engine.set_osc_octave(osc, p.osc[osc].octave);
+      engine.set_osc_detune(osc, p.osc[osc].detune);
+      engine.set_osc_phase(osc, p.osc[osc].phase);
     }
+    engine.set_cutoff(p.cutoff);
+    engine.set_resonance(p.resonance);
+    engine.set_filter_type(p.filterType);
+    engine.set_filter_slope(p.filterSlope);
+    engine.set_filter_mode(p.filterMode);
+    engine.set_oversampling(static_cast<unsigned>(p.oversampling));
+    engine.set_env_attack(p.envAttack);
+    engine.set_env_decay(p.envDecay);
+    engine.set_env_sustain(p.envSustain);
+    engine.set_env_release(p.envRelease);
+    engine.set_mod_matrix(p.mod);
+    pan = p.pan;
+    spread = p.stereoSpread;
+  }
+
+  // MIDI note numbers; the pitch class places the voice across the field
+  void note_on(int note, float velocity) {
+    // a free voice, or the oldest sounding one once the limit is reached
+    size_t idx = alloc.note_on(note);
+    float freq = 440.0f * std::pow(2.0f, (static_cast<float>(note) - 69.0f) / 12.0f);
+    engine.note_on(idx, freq, pan + spread * (static_cast<float>(note % 12) / 5.5f - 1.0f), velocity);
+  }
+
+  void note_off(int note) {
+    alloc.note_off(note, [&](size_t v) { engine.note_off(v); });
   }
 
-  void note_on(int note, int octave) {
-    // choose free voice or steal oldest
-    Voice* choose = nullptr;
-    for (auto &v : voices) {
-      if (!v.synth.is_active() && v.note == -1) { choose = &v; break; }
+  void handle(const AudioEvent& e) {
+    switch (e.type) {
+      case AudioEvent::NoteOn: note_on(e.note, e.value); break;
+      case AudioEvent::NoteOff: note_off(e.note); break;
+      case AudioEvent::Param:
+        if (e.id == AudioEvent::ParamPolyphony)
+          set_polyphony(static_cast<size_t>(std::clamp(static_cast<int>(e.value), 1, 256)));
+        break;
+      default: break;
     }
-    if (!choose) {
-      // steal least recently used
-      uint64_t oldest = UINT64_MAX; size_t idx = 0;
-      for (size_t i = 0; i < voices.size(); ++i) {
-        if (voices[i].lastUsed < oldest) { oldest = voices[i].lastUsed; idx = i; }
-      }
-      choose = &voices[idx];
+  }
+
+  void render_mixed(float* out, unsigned nframes, unsigned channels) {
+    // the engine adds every active voice into the interleaved out
+    engine.render(out, nframes, channels);
+    // released voices go back to the free list once their envelope ends
+    alloc.reap([&](size_t v) { return !engine.is_active(v); });
+  }
+};
+
+// One callback's voice events in frame order, built before the bus runs
+// and consumed by the synth source as it renders up to each offset
+struct BlockEvents {
+  static constexpr size_t kMax = 512;
+  struct Timed {
+    unsigned offset;
+    AudioEvent event;
+  };
+  std::array<Timed, kMax> list;
+  size_t count = 0;
+  size_t next = 0;
+  uint64_t dropped = 0;
+
+  void clear() { count = next = 0; }
+  void add(unsigned offset, const AudioEvent& e) {
+    if (count == kMax) { ++dropped; return; }
+    list[count++] = {offset, e};
+  }
+  // Stable, and linear on the nearly sorted lists a block produces
+  void sort() {
+    for (size_t i = 1; i < count; ++i) {
+      Timed t = list[i];
+      size_t j = i;
+      for (; j > 0 && list[j - 1].offset > t.offset; --j) list[j] = list[j - 1];
+      list[j] = t;
     }
-    // init voice
-    choose->note = note;
-    choose->released = false;
-    choose->lastUsed = ++tick;
-    int midi = (octave + 1) * 12 + note;
-    float freq = 440.0f * std::pow(2.0f, (static_cast<float>(midi) - 69.0f) / 12.0f);
-    choose->synth.set_freq(freq);
-    choose->synth.note_on();
   }
+};
 
-  void note_off(int note) {
-    for (auto &v : voices) {
-      if (v.note == note && v.synth.is_active()) {
-        v.synth.note_off();
-        v.released = true;
-        // keep v.note until envelope finishes (we'll clear below)
-      }
+// 16-step pattern player on the audio thread. The position is kept in
+// fractional frames, so every step starts on its own frame of the block
+// whatever the buffer size; notes are released 80% of a step later.
+// Offline it obeys local transport events; in a session it follows the
+// shared transport instead (follow()).
+struct StepSequencer {
+  static constexpr int kRows = 12;
+  static constexpr int kSteps = 16;
+  static constexpr double kFollowGain = 1.0 / 16.0; // share of a small error removed per block
+  static constexpr double kJumpSteps = 0.125;       // larger errors are jumped, not slewed
+  bool playing = false;
+  double bpm = 120.0;
+  int step = -1;          // last step played; the next is step + 1
+  double untilStep = 0.0; // frames until the next step
+  std::array<int, kRows> heldNote{};      // MIDI note per row, -1 = none
+  std::array<double, kRows> untilOff{};   // frames until that note's release
+
+  StepSequencer() { heldNote.fill(-1); }
+
+  // Transport change at `offset`; note-offs for pending notes go to `out`
+  void transport(const AudioEvent& e, unsigned offset, BlockEvents& out) {
+    switch (e.id) {
+      case AudioEvent::TransportPlay: playing = true; break;
+      case AudioEvent::TransportPause: playing = false; release_all(offset, out); break;
+      case AudioEvent::TransportStop:
+        playing = false;
+        release_all(offset, out);
+        step = -1;
+        untilStep = 0.0;
+        break;
+      case AudioEvent::TransportRestart:
+        playing = true;
+        release_all(offset, out);
+        step = -1;
+        untilStep = 0.0;
+        break;
+      case AudioEvent::TransportTempo:
+        if (e.value > 0.0f) {
+          // the part of the step still to come stretches with the tempo
+          untilStep *= bpm / e.value;
+          bpm = e.value;
+        }
+        break;
+      default: break;
     }
   }
 
-  void render_mixed(float* out, unsigned nframes) {
-    // mix all voices into out (synth.render adds into out)
-    for (auto &v : voices) {
-      if (v.synth.is_active()) {
-        v.synth.render(out, nframes);
+  // Shared transport: lines the sequencer up with t at server time atNs,
+  // which is frame `offset` of the block. Starts, tempo changes and errors
+  // over kJumpSteps take t's position at once; smaller ones (clock drift,
+  // a refined clock estimate) are slewed out over a few blocks.
+  void follow(const TransportState& t, uint64_t atNs, unsigned offset, double sampleRate, BlockEvents& out) {
+    if (!t.playing) {
+      if (playing) release_all(offset, out);
+      playing = false;
+      bpm = t.bpm;
+      return;
+    }
+    const bool starting = !playing || bpm != static_cast<double>(t.bpm);
+    playing = true;
+    bpm = t.bpm;
+    const double perStep = sampleRate * 60.0 / bpm / 4.0;
+    const double target = t.step_at(atNs);
+    // our position: the next step is step + 1, untilStep frames away
+    double err = target - (static_cast<double>(step + 1) - untilStep / perStep);
+    err -= kSteps * std::floor(err / kSteps + 0.5); // nearest way round the pattern
+    if (starting || std::fabs(err) > kJumpSteps) {
+      const double next = std::ceil(target);
+      const auto before = static_cast<int64_t>(next) - 1; // last step already due
+      step = static_cast<int>((before % kSteps + kSteps) % kSteps);
+      untilStep = (next - target) * perStep;
+    } else {
+      untilStep = std::max(0.0, untilStep - err * perStep * kFollowGain);
+    }
+  }
+
+  // Frames [from, to) of the block: releases and steps at their frames
+  template <class Grid>
+  void run(unsigned from, unsigned to, double sampleRate, const Grid& grid, int baseOct, BlockEvents& out,
+           std::atomic<int>& stepOut) {
+    const double span = static_cast<double>(to - from);
+    for (int r = 0; r < kRows; ++r) {
+      if (heldNote[r] < 0) continue;
+      if (untilOff[r] < span) {
+        out.add(from + static_cast<unsigned>(std::max(untilOff[r], 0.0)), AudioEvent::note_off(heldNote[r]));
+        heldNote[r] = -1;
       } else {
-        // voice idle, clear note if it was released previously
-        if (v.note != -1 && v.released) {
-          v.note = -1;
-          v.released = false;
+        untilOff[r] -= span;
+      }
+    }
+    if (!playing) return;
+    const double perStep = sampleRate * 60.0 / bpm / 4.0; // 16th notes
+    double pos = untilStep;
+    for (; pos < span; pos += perStep) {
+      const auto at = from + static_cast<unsigned>(pos);
+      step = (step + 1) % kSteps;
+      stepOut.store(step);
+      for (int r = kRows - 1; r >= 0; --r) {
+        if (!grid[r][step].load()) continue;
+        if (heldNote[r] >= 0) out.add(at, AudioEvent::note_off(heldNote[r]));
+        heldNote[r] = (baseOct + 1) * 12 + r;
+        out.add(at, AudioEvent::note_on(heldNote[r], 1.0f));
+        // released within this span if it ends first, else counted down later
+        untilOff[r] = pos + perStep * 0.8;
+        if (untilOff[r] < span) {
+          out.add(from + static_cast<unsigned>(untilOff[r]), AudioEvent::note_off(heldNote[r]));
+          heldNote[r] = -1;
+        } else {
+          untilOff[r] -= span;
         }
       }
     }
+    untilStep = pos - span;
+  }
+
+  void release_all(unsigned offset, BlockEvents& out) {
+    for (int& n : heldNote) {
+      if (n >= 0) out.add(offset, AudioEvent::note_off(n));
+      n = -1;
+    }
+  }
+};
+
+// The shared transport as the audio thread sees it: the state in force
+// and the next one, which takes over at its anchor
+struct TransportFollower {
+  TransportView view;
+  TransportState current;
+  TransportState next;
+  bool pending = false;
+
+  void update(const TransportView& v) {
+    view = v;
+    if (!v.valid) {
+      pending = false;
+      return;
+    }
+    if (v.state.version == current.version || (pending && v.state.version == next.version)) return;
+    next = v.state;
+    pending = true;
+  }
+  // Promotes the next state if it starts within the block whose frame 0 is
+  // server time startNs; `at` is the frame it starts on
+  bool due(uint64_t startNs, unsigned nframes, double nsPerFrame, unsigned& at) {
+    if (!pending) return false;
+    const double rel = static_cast<double>(static_cast<int64_t>(next.anchorNs - startNs)) / nsPerFrame;
+    if (rel >= nframes) return false;
+    at = rel <= 0.0 ? 0u : std::min(nframes - 1, static_cast<unsigned>(rel));
+    current = next;
+    pending = false;
+    return true;
   }
 };
 
 struct ClientCtx {
   std::atomic<bool> running{true};
-  JitterBuffer jitter;
-  std::atomic<float> remoteGain{0.5f};
-  std::atomic<uint32_t> xruns{0};
+  RemoteMixer remote; // one jitter buffer + playout controller per sending peer
+  std::atomic<bool> audioOpened{false}; // main has made its first open attempt
+  ClientSession session;
+  ClientTransport transport; // server clock estimate and shared transport state
 };
 
 int main() {
@@ -123,6 +325,7 @@ int main() {
     gui.params.osc[osc].detune.store(0.0f);
     gui.params.osc[osc].phase.store(osc == 0 ? 0.0f : osc * 120.0f);
   }
+  publish_patch(gui, true); // the GUI thread publishes from here on
 
   // Launch GUI in its own thread
   std::thread guiThread([&] { run_gui(gui); });
@@ -132,204 +335,509 @@ int main() {
   udp.bind_any(0);
 
   ClientCtx ctx;
-  ctx.jitter.set_target_blocks(2);
+
+  AudioIO audio;
+  AudioSender sender(udp, ctx.session);
+  sender.start();
+  InputMonitor monitor;
+  {
+    std::lock_guard<CheckedMutex> lock(gui.device.mutex);
+    gui.device.devices = to_choices(audio.devices());
+  }
+
+  // Master bus graph, filled in once the voice pool exists; the reverb
+  // insert is created up front since the control thread loads its responses
+  DspGraph bus;
+  constexpr unsigned kBusMaxFrames = 4096;
+  auto* reverb = bus.add<ReverbNode>();
+
+  // (Re)opens the stream with the GUI's device, rate, buffer and input choice.
+  // The stream must be closed; everything rate-dependent is updated here or
+  // follows audio.sample_rate() in the callback.
+  auto openAudio = [&] {
+    AudioStreamConfig cfg;
+    cfg.outputDevice = gui.device.outputDevice.load();
+    cfg.inputDevice = gui.device.inputDevice.load();
+    cfg.sampleRate = gui.device.sampleRate.load();
+    cfg.frames = std::clamp(gui.device.bufferFrames.load(), 32u, 1024u);
+    cfg.inputChannel = gui.input.channel.load();
+    // the stream starts on open; bus nodes take the actual rate per block
+    bus.compile(cfg.sampleRate, kBusMaxFrames, kMaxWireChannels);
+    bool ok = audio.open(cfg);
+    unsigned rate = ok ? audio.sample_rate() : cfg.sampleRate;
+    unsigned frames = ok ? audio.buffer_frames() : cfg.frames;
+    ctx.remote.set_sample_rate(rate);
+    ctx.remote.set_block_frames(frames);
+    ctx.remote.retire_all(); // reclaimed with the new rate by the next packets
+    gui.device.activeRate.store(rate);
+    gui.device.activeFrames.store(frames);
+    gui.device.latencyFrames.store(ok ? audio.latency_frames() : 0);
+    gui.input.available.store(static_cast<int>(audio.input_channel_count()));
+    gui.input.active.store(audio.has_input());
+    gui.audioRunning.store(audio.is_running());
+    std::lock_guard<CheckedMutex> lock(gui.device.mutex);
+    gui.device.message = ok ? std::string() : "Could not open the device at " + std::to_string(cfg.sampleRate) +
+                                                  " Hz / " + std::to_string(cfg.frames) + " frames";
+    return ok;
+  };
 
   // Simple RX loop
   std::thread rx([&] {
-    std::vector<uint8_t> buf(1500);
+    std::vector<uint8_t> buf(kMaxDatagram);
+    std::vector<float> samples(kMaxDatagram / sizeof(float));
     asio::ip::udp::endpoint from;
+    auto lastReap = std::chrono::steady_clock::now();
     while (!gui.quitRequested.load()) {
       size_t n = udp.recv(buf.data(), buf.size(), from);
       if (!n) continue;
-      if (n % sizeof(float) != 0) continue;
-      size_t frames = n / sizeof(float);
-      std::vector<float> block(frames);
-      std::memcpy(block.data(), buf.data(), n);
-      ctx.jitter.push(block);
+      const uint64_t rxNs = steady_now_ns();
+      MsgType type;
+      if (!peek_msg_type(buf.data(), n, type)) continue;
+      if (type == MsgType::ClockPong) {
+        ClockPongMsg pong;
+        if (!decode_clock_pong(buf.data(), n, pong)) continue;
+        ctx.transport.on_pong(pong, rxNs);
+        gui.transportShared.store(ctx.transport.active());
+        gui.stats.clockRttMs.store(static_cast<float>(ctx.transport.rtt_ms()));
+        gui.stats.clockOffsetMs.store(static_cast<float>(ctx.transport.offset_ms()));
+        continue;
+      }
+      if (type == MsgType::TransportState) {
+        TransportState state;
+        if (!decode_transport_state(buf.data(), n, state)) continue;
+        if (ctx.transport.on_state(state)) {
+          // the GUI shows the session's transport rather than its own
+          gui.sequencer.playing.store(state.playing);
+          gui.sequencer.bpm.store(static_cast<int>(std::lround(state.bpm)));
+        }
+        gui.transportShared.store(ctx.transport.active());
+        continue;
+      }
+      if (type == MsgType::Welcome) {
+        WelcomeMsg welcome;
+        if (!decode_welcome(buf.data(), n, welcome)) continue;
+        ctx.session.apply(welcome);
+        std::string msg = welcome.status == WelcomeStatus::Rejected
+            ? std::string("Rejected by server: ") + to_string(welcome.reason)
+            : "Session " + std::to_string(welcome.config.sample_rate) + " Hz, " +
+              std::to_string(welcome.config.block_frames) + " frames/packet, " +
+              std::to_string(welcome.config.channels) + " ch, pcm " + to_string(welcome.config.format) +
+              (welcome.status == WelcomeStatus::Adapted ? " (adapted)" : "");
+        std::lock_guard<CheckedMutex> lock(gui.discoveryMutex);
+        gui.sessionMessage = std::move(msg);
+        continue;
+      }
+      if (type != MsgType::Audio) continue;
+      PacketHeader hdr;
+      size_t count = decode_audio(buf.data(), n, hdr, samples.data(), samples.size());
+      if (!count) continue;
+      auto now = std::chrono::steady_clock::now();
+      ctx.remote.on_packet(hdr, samples.data(), count, rxNs);
+      if (now - lastReap > std::chrono::milliseconds(500)) {
+        lastReap = now;
+        ctx.remote.reap(now);
+      }
       gui.stats.rxPackets.fetch_add(1);
-      gui.stats.jitterDepth.store(ctx.jitter.size()); // optional helper
     }
   });
 
+  // Live LAN server list fed by server beacons
+  ServerDirectory directory(io);
+  if (!directory.start()) {
+    std::lock_guard<CheckedMutex> lock(gui.discoveryMutex);
+    gui.discoveryMessage = "LAN discovery unavailable (beacon port in use?)";
+  }
+
   // Connect when requested
   std::thread netCtl([&] {
+    // HELLO advertises the stream as opened; rebuilt when the device changes
+    std::vector<uint8_t> helloBuf(64);
+    size_t helloLen = 0;
+    HelloMsg hello;
+    hello.caps.channels = kMaxWireChannels;
+    bool helloPending = false;
+    std::chrono::steady_clock::time_point lastHello{};
+    std::chrono::steady_clock::time_point lastPing{};
+    std::vector<uint8_t> ctlBuf(64);
+    auto lastPublish = std::chrono::steady_clock::now();
+    auto lastDspReport = lastPublish;
+    // Reverb response as read from disk, rebuilt whenever the stream rate changes
+    WavData irWav;
+    unsigned irRate = 0;
+    const Convolver* irActive = nullptr; // last handed to the bus; alive until the next one is collected
+    double irTailSeconds = 0.0;
     for (;;) {
       if (gui.quitRequested.load()) break;
-      if (gui.connectRequested.exchange(false)) {
-        std::printf("Connect requested -> setting remote to %s:%u\n", gui.serverHost.c_str(), gui.serverPort);
-        udp.set_remote(gui.serverHost, gui.serverPort);
-        std::printf("Set remote %s:%u\n", gui.serverHost.c_str(), gui.serverPort);
+
+      auto now = std::chrono::steady_clock::now();
+      if (now - lastPublish >= std::chrono::milliseconds(250)) {
+        lastPublish = now;
+        std::vector<LanServerInfo> servers;
+        for (const auto& e : directory.snapshot()) {
+          LanServerInfo info;
+          info.host = e.host;
+          info.port = e.beacon.port;
+          info.peers = e.beacon.peers;
+          info.load = e.beacon.load;
+          for (size_t i = 0; i < e.beacon.rooms.size(); ++i) {
+            if (i) info.rooms += ", ";
+            info.rooms += e.beacon.rooms[i];
+          }
+          info.ageMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now - e.lastSeen).count());
+          servers.push_back(std::move(info));
+        }
+        {
+          std::lock_guard<CheckedMutex> lock(gui.discoveryMutex);
+          gui.lanServers = std::move(servers);
+        }
+
+        // per-peer receive stats out, per-peer gains in
+        size_t worstDepth = 0, worstTarget = 0, sumTarget = 0;
+        float worstJitter = 0.0f, worstLoss = 0.0f;
+        uint64_t underruns = 0, overflows = 0, compressed = 0;
+        uint32_t active = 0;
+        for (size_t i = 0; i < RemoteMixer::kMaxPeers; ++i) {
+          const auto& st = ctx.remote.stream(i);
+          auto& view = gui.stats.peers[i];
+          bool live = st.state.load() == RemoteMixer::Stream::Active;
+          uint32_t id = st.senderId.load();
+          if (live && (!view.active.load() || view.senderId.load() != id)) view.gain.store(1.0f); // new peer
+          view.active.store(live);
+          view.senderId.store(id);
+          if (!live) continue;
+          ++active;
+          ctx.remote.set_gain(i, view.gain.load());
+          view.depth.store(st.jitter.size());
+          view.target.store(st.playout.target_frames());
+          view.jitterMs.store(st.playout.jitter_ms());
+          view.lossPercent.store(st.playout.loss_percent());
+          view.sampleRate.store(st.sampleRate.load());
+          view.driftPpm.store(st.resampler.drift_ppm());
+          worstDepth = std::max(worstDepth, st.jitter.size());
+          worstTarget = std::max(worstTarget, st.playout.target_frames());
+          sumTarget += st.playout.target_frames();
+          worstJitter = std::max(worstJitter, st.playout.jitter_ms());
+          worstLoss = std::max(worstLoss, st.playout.loss_percent());
+          underruns += st.jitter.underruns();
+          overflows += st.jitter.overflows();
+          compressed += st.jitter.compressed_frames();
+        }
+        gui.stats.activePeers.store(active);
+        gui.stats.jitterDepth.store(worstDepth);
+        gui.stats.jitterTarget.store(worstTarget);
+        gui.stats.jitterMs.store(worstJitter);
+        gui.stats.lossPercent.store(worstLoss);
+        gui.stats.jitterUnderruns.store(underruns);
+        gui.stats.jitterOverflows.store(overflows);
+        gui.stats.jitterCompressed.store(compressed);
+
+        // Compensated monitor: roughly what peers add before they hear us,
+        // i.e. one packet plus the buffering we see on their streams
+        size_t delay = ctx.session.blockFrames.load() + (active ? sumTarget / active : 0);
+        monitor.set_delay_frames(delay);
+        gui.input.monitorDelayMs.store(static_cast<float>(monitor.delay_frames() * 1000.0 / gui.device.activeRate.load()));
       }
 
-      if (gui.discoverRequested.exchange(false)) {
-        // perform a simple UDP broadcast discovery on kDiscoveryPort
-        gui.discovering.store(true);
+      // DSP load over 1 s windows (enough callbacks for a meaningful p99)
+      if (now - lastDspReport >= std::chrono::seconds(1)) {
+        lastDspReport = now;
+        auto load = audio.meter().report();
+        gui.stats.xruns.store(static_cast<uint32_t>(load.xruns));
+        gui.stats.dspLoad.store(load.loadPercent);
+        gui.stats.callbackP99Ms.store(load.p99Ms);
+        gui.stats.callbackMaxMs.store(load.maxMs);
+        gui.stats.callbackDeadlineMs.store(load.deadlineMs);
+        gui.stats.lateCallbacks.fetch_add(load.lateBlocks);
+        for (int s = 0; s < DspLoadMeter::kStages; ++s) gui.stats.stageLoad[s].store(load.stagePercent[s]);
+        if (irActive) {
+          gui.reverb.tailLoad.store(static_cast<float>(100.0 * (irActive->tail_seconds() - irTailSeconds)));
+          irTailSeconds = irActive->tail_seconds();
+          gui.reverb.lateBlocks.store(irActive->late_blocks());
+        }
+      }
+
+      // Audio stream control (only after main has opened the stream)
+      if (ctx.audioOpened.load()) {
+        if (gui.device.rescanRequested.exchange(false)) {
+          auto devices = to_choices(audio.devices());
+          std::lock_guard<CheckedMutex> lock(gui.device.mutex);
+          gui.device.devices = std::move(devices);
+        }
+        bool reopen = gui.input.reopenRequested.exchange(false);
+        reopen |= gui.device.applyRequested.exchange(false);
+        if (reopen) {
+          audio.close();
+          if (!openAudio()) std::printf("Audio reopen failed\n");
+        }
+        if (gui.audioStopRequested.exchange(false)) gui.audioRunning.store(!audio.stop());
+        if (gui.audioStartRequested.exchange(false)) gui.audioRunning.store(audio.start());
+      }
+
+      // Reverb: partitions are built here, never on the audio thread
+      if (gui.reverb.loadRequested.exchange(false)) {
+        std::string path;
         {
-          std::lock_guard<std::mutex> lock(gui.discoveryMutex);
-          gui.discoveryMessage.clear();
-          gui.discoveredHost.clear();
+          std::lock_guard<CheckedMutex> lock(gui.reverb.mutex);
+          path = gui.reverb.path;
         }
-        try {
-          asio::ip::udp::socket dsock( io );
-          dsock.open(asio::ip::udp::v4());
-          dsock.set_option(asio::socket_base::broadcast(true));
-          asio::ip::udp::endpoint bcast(asio::ip::address_v4::broadcast(), kDiscoveryPort);
-          dsock.send_to(asio::buffer(std::string(kDiscoveryMsg)), bcast);
-
-          // wait briefly for replies
-          dsock.non_blocking(true);
-          std::vector<uint8_t> buf(1500);
-          asio::ip::udp::endpoint from;
-          auto start = std::chrono::steady_clock::now();
-          bool found = false;
-          while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(600)) {
-            asio::error_code ec;
-            size_t n = dsock.receive_from(asio::buffer(buf), from, 0, ec);
-            if (ec == asio::error::would_block || ec == asio::error::try_again) {
-              std::this_thread::sleep_for(std::chrono::milliseconds(20));
-              continue;
-            }
-            if (ec || n == 0) continue;
-            std::string reply(reinterpret_cast<const char*>(buf.data()), n);
-            if (reply.rfind(kDiscoveryReplyPrefix, 0) == 0) {
-              // reply format: PREFIX:port
-              auto sep = reply.find(':');
-              uint16_t serverPort = 50000;
-              if (sep != std::string::npos) {
-                serverPort = static_cast<uint16_t>(std::stoi(reply.substr(sep+1)));
-              }
-              {
-                std::lock_guard<std::mutex> lock(gui.discoveryMutex);
-                gui.discoveredHost = from.address().to_string();
-                gui.discoveryMessage = std::string("Found server at ") + gui.discoveredHost + ":" + std::to_string(serverPort);
-                gui.serverHost = gui.discoveredHost;
-                gui.serverPort = serverPort;
-              }
-              gui.discoveryStatus.store(1);
-              found = true;
-              break;
+        WavData wav;
+        if (read_wav(path, wav)) {
+          irWav = std::move(wav);
+          irRate = 0;
+        } else {
+          std::lock_guard<CheckedMutex> lock(gui.reverb.mutex);
+          gui.reverb.message = "Could not read " + path;
+        }
+      }
+      const unsigned streamRate = gui.device.activeRate.load();
+      if (irWav.frames() && irRate != streamRate) {
+        irRate = streamRate;
+        auto conv = Convolver::from_wav(irWav, streamRate);
+        std::lock_guard<CheckedMutex> lock(gui.reverb.mutex);
+        if (conv) {
+          gui.reverb.seconds.store(static_cast<float>(conv->ir_frames()) / static_cast<float>(streamRate));
+          gui.reverb.channels.store(conv->ir_channels());
+          gui.reverb.message.clear();
+          irActive = conv.get();
+          irTailSeconds = 0.0;
+          reverb->set_impulse(std::move(conv));
+        } else {
+          gui.reverb.message = "The impulse response is empty or silent";
+        }
+      }
+      reverb->collect();
+
+      // HELLO advertises the stream as opened; after a device change peers
+      // must learn the new rate and packet size, so renegotiate the session
+      unsigned rate = gui.device.activeRate.load();
+      auto frames = static_cast<uint16_t>(gui.device.activeFrames.load());
+      if (!helloLen || hello.caps.sample_rate != rate || hello.caps.block_frames != frames) {
+        hello.caps.sample_rate = rate;
+        hello.caps.block_frames = frames;
+        helloLen = encode_hello(helloBuf.data(), helloBuf.size(), hello);
+        if (ctx.session.ready.load() || helloPending) {
+          ctx.session.reset();
+          helloPending = true;
+          lastHello = {};
+        }
+      }
+
+      if (gui.connectRequested.exchange(false)) {
+        // Port 0 means "auto": take a server from the beacon list, no round trip needed.
+        // Host and port are shared with the GUI thread under discoveryMutex.
+        std::string host;
+        uint16_t port = 0;
+        {
+          std::lock_guard<CheckedMutex> lock(gui.discoveryMutex);
+          if (gui.serverPort == 0) {
+            auto it = std::find_if(gui.lanServers.begin(), gui.lanServers.end(),
+                                   [&](const LanServerInfo& srv) { return srv.host == gui.serverHost; });
+            if (it == gui.lanServers.end() && !gui.lanServers.empty()) it = gui.lanServers.begin();
+            if (it != gui.lanServers.end()) {
+              gui.serverHost = it->host;
+              gui.serverPort = it->port;
+              gui.hostDirty.store(true);
+            } else {
+              gui.discoveryMessage = "No server announced on the LAN yet";
             }
           }
-          if (!found) {
-            std::lock_guard<std::mutex> lock(gui.discoveryMutex);
-            gui.discoveryMessage = "No server found";
-            gui.discoveryStatus.store(-1);
-          }
-        } catch (const std::exception& e) {
-          std::lock_guard<std::mutex> lock(gui.discoveryMutex);
-          gui.discoveryMessage = std::string("Discovery error: ") + e.what();
-          gui.discoveryStatus.store(-1);
+          host = gui.serverHost;
+          port = gui.serverPort;
         }
-        gui.discovering.store(false);
+        if (port != 0) {
+          std::printf("Connect requested -> setting remote to %s:%u\n", host.c_str(), port);
+          udp.set_remote(host, port);
+          std::printf("Set remote %s:%u\n", host.c_str(), port);
+          ctx.session.reset();
+          ctx.transport.reset(); // a new server clock and transport
+          gui.transportShared.store(false);
+          helloPending = true;
+          lastHello = {};
+          std::lock_guard<CheckedMutex> lock(gui.discoveryMutex);
+          gui.sessionMessage = "Negotiating session...";
+        }
+      }
+
+      // Repeat HELLO until the server answers (or rejects us)
+      if (helloPending && (ctx.session.ready.load() || ctx.session.rejected.load())) helloPending = false;
+      if (helloPending && now - lastHello >= std::chrono::milliseconds(kHelloRetryMs)) {
+        lastHello = now;
+        udp.send(helloBuf.data(), helloLen);
+      }
+
+      // Shared transport: keep the server clock estimate fresh and pass
+      // the GUI's transport changes on as requests
+      if (ctx.session.ready.load() && now - lastPing >= std::chrono::milliseconds(kClockPingMs)) {
+        lastPing = now;
+        ClockPingMsg ping;
+        ping.t0 = steady_now_ns();
+        if (size_t len = encode_clock_ping(ctlBuf.data(), ctlBuf.size(), ping)) udp.send(ctlBuf.data(), len);
+      }
+      while (const AudioEvent* e = gui.transportRequests.front()) {
+        TransportRequestMsg req;
+        req.command = static_cast<TransportCommand>(e->id); // TransportOp and TransportCommand share an order
+        req.bpm = e->value;
+        gui.transportRequests.pop();
+        if (!ctx.session.ready.load()) continue;
+        if (size_t len = encode_transport_request(ctlBuf.data(), ctlBuf.size(), req)) udp.send(ctlBuf.data(), len);
+      }
+
+      if (gui.discoverRequested.exchange(false)) {
+        // Beacons keep the list current; a probe just refreshes it right away
+        directory.probe();
+        std::lock_guard<CheckedMutex> lock(gui.discoveryMutex);
+        gui.discoveryMessage = "Discovery probe sent";
       }
       std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
   });
 
-  // Audio: create voice pool and wire to GUI gate/note
-  AudioIO audio;
+  // Audio: voice pool, driven by the GUI's events and the sequencer
   const size_t kVoiceCount = 8;
-  VoicePool vpool(kVoiceCount, 48000.0);
-
-  audio.set_callback([&](float* out, unsigned nframes) {
-    // zero output buffer
-    for (unsigned i = 0; i < nframes; ++i) out[i] = 0.0f;
-
-  // Sample-accurate sequencer handling (runs in audio thread)
-    static const int kSeqRows = 12;
-    static const int kSeqSteps = 16;
-    static const double sampleRate = 48000.0;
-    static double sampleAcc = 0.0; // leftover samples toward next step
-    static uint64_t globalSamplePos = 0; // increasing sample counter
-    static int currentStep = 0;
-    static bool seqOwnsGate = false;
-    static uint64_t seqReleaseSample = 0;
-  int baseOct = std::clamp(gui.params.octave.load(), 0, 8);
-  int note = std::clamp(gui.params.note.load(), 0, 11);
-  bool playing = gui.sequencer.playing.load();
-  int bpm = gui.sequencer.bpm.load();
-    if (bpm <= 0) bpm = 120;
-    double samplesPerStep = (sampleRate * 60.0) / static_cast<double>(bpm) / 4.0; // 16th notes
-  static uint16_t seqReleaseMask = 0;
-  if (playing) {
-      // accumulate and advance steps as needed
-      sampleAcc += static_cast<double>(nframes);
-      while (sampleAcc >= samplesPerStep) {
-        sampleAcc -= samplesPerStep;
-        currentStep = (currentStep + 1) % kSeqSteps;
-  gui.sequencer.step.store(currentStep);
-
-        // trigger all rows set at this step (polyphonic step)
-        for (int r = kSeqRows - 1; r >= 0; --r) {
-          if (gui.sequencer.grid[r][currentStep].load()) {
-            vpool.note_on(r, baseOct);
-            seqReleaseMask |= static_cast<uint16_t>(1u << r);
-          }
-        }
-        if (seqReleaseMask != 0) {
-          seqReleaseSample = globalSamplePos + static_cast<uint64_t>(samplesPerStep * 0.8);
-        }
-      }
-    } else {
-      // if paused, reset accumulator so we restart cleanly when started
-      sampleAcc = 0.0;
+  VoicePool vpool(kVoiceCount, gui.device.sampleRate.load());
+
+  // The synth voices, the input monitor and every remote peer, mixed and run
+  // through the reverb into the device output; the send path taps the synth
+  // alone. Sources mark their own load-meter stage when done.
+  const float* busIn = nullptr; // this block's capture, for the monitor
+  float busInGain = 1.0f;
+  unsigned busOff = 0;          // frame of the callback block the bus is at
+  BlockEvents blockEvents;
+  StepSequencer sequencer;
+  TransportFollower follower;
+  // renders up to each event's frame, then applies it
+  DspNode* synthBus = bus.add_source([&](const DspContext& c, float* o) {
+    unsigned pos = 0;
+    while (pos < c.nframes) {
+      auto& be = blockEvents;
+      for (; be.next < be.count && be.list[be.next].offset <= busOff + pos; ++be.next) vpool.handle(be.list[be.next].event);
+      unsigned end = c.nframes;
+      if (be.next < be.count) end = std::min(end, be.list[be.next].offset - busOff);
+      vpool.render_mixed(o + static_cast<size_t>(pos) * c.channels, end - pos, c.channels);
+      pos = end;
     }
+    audio.meter().mark(DspStage::Synth);
+  });
+  DspNode* monitorBus = bus.add_source([&](const DspContext& c, float* o) {
+    monitor.process(busIn, o, c.nframes, c.channels, gui.input.monitorMode.load(),
+                    busInGain * gui.input.monitorGain.load());
+  });
+  DspNode* remoteBus = bus.add_source([&](const DspContext& c, float* o) {
+    ctx.remote.mix(o, c.nframes, c.channels, gui.params.remoteGain.load());
+    audio.meter().mark(DspStage::RemoteMix);
+  });
+  auto* master = bus.add<MixerNode>(3);
+  bus.connect(synthBus, master, 0);
+  bus.connect(monitorBus, master, 1);
+  bus.connect(remoteBus, master, 2);
+  bus.connect(master, reverb);
+  bus.expose(synthBus);
+
+  audio.set_callback([&](const float* in, float* out, unsigned nframes) {
+    // the master bus writes every frame of the interleaved output
+    const unsigned ch = audio.channels();
+    // rate of the open stream; voices follow it after a device change
+    const double sampleRate = audio.sample_rate();
+    if (vpool.sampleRate != sampleRate) vpool.set_sample_rate(sampleRate);
+    // voice settings change only when the GUI publishes a new patch
+    if (const SynthPatch* patch = gui.patch.read()) vpool.apply(*patch);
 
-    // process GUI note on/off requests (bitmasks) - consume and clear atomically
-    uint16_t onReq = gui.noteOnRequests.exchange(0);
-    if (onReq) {
-      for (int n = 0; n < 12; ++n) if (onReq & (1u << n)) vpool.note_on(n, baseOct);
+    // This block's voice events: queued GUI events at the frames their
+    // timestamps map to, with the sequencer run up to each transport change
+    const auto now = EventQueue::now_ns();
+    const int baseOct = std::clamp(gui.params.octave.load(), 0, 8);
+    if (const TransportView* view = ctx.transport.view.read()) follower.update(*view);
+    blockEvents.clear();
+    gui.events.begin_block(now, nframes, sampleRate);
+    unsigned seqPos = 0;
+    AudioEvent ev;
+    unsigned evOffset = 0;
+    while (gui.events.pop(ev, evOffset)) {
+      if (ev.type != AudioEvent::Transport) {
+        blockEvents.add(evOffset, ev);
+        continue;
+      }
+      if (follower.view.valid) continue; // the session's transport rules
+      sequencer.run(seqPos, evOffset, sampleRate, gui.sequencer.grid, baseOct, blockEvents, gui.sequencer.step);
+      sequencer.transport(ev, evOffset, blockEvents);
+      seqPos = evOffset;
     }
-    uint16_t offReq = gui.noteOffRequests.exchange(0);
-    if (offReq) {
-      for (int n = 0; n < 12; ++n) if (offReq & (1u << n)) vpool.note_off(n);
+    if (follower.view.valid) {
+      // Shared transport: frame 0 is heard one output latency after the
+      // (smoothed) callback time; on the server's clock that is where
+      // every client's sequencer must be, and each change starts on the
+      // frame its anchor falls on
+      const double nsPerFrame = 1e9 / sampleRate;
+      const uint64_t heardNs = gui.events.block_ns() + static_cast<uint64_t>(gui.device.latencyFrames.load() * nsPerFrame);
+      const uint64_t startNs = follower.view.to_server(heardNs);
+      for (unsigned at = 0;;) {
+        sequencer.follow(follower.current, startNs + static_cast<uint64_t>(at * nsPerFrame), at, sampleRate, blockEvents);
+        if (!follower.due(startNs, nframes, nsPerFrame, at)) break;
+        sequencer.run(seqPos, at, sampleRate, gui.sequencer.grid, baseOct, blockEvents, gui.sequencer.step);
+        seqPos = at;
+      }
     }
+    sequencer.run(seqPos, nframes, sampleRate, gui.sequencer.grid, baseOct, blockEvents, gui.sequencer.step);
+    blockEvents.sort();
+    gui.stats.droppedEvents.store(gui.events.dropped() + blockEvents.dropped);
+    audio.meter().mark(DspStage::Sequencer);
 
-    // allow dynamic polyphony change requested by GUI
-    int desired = std::clamp(gui.polyphony.load(), 1, 256);
-    if (static_cast<int>(vpool.voices.size()) != desired) {
-      vpool.resize(static_cast<size_t>(desired), 48000.0);
-    }
-    // update voice params from GUI (cheap to do each callback)
-    vpool.set_global_params_from_gui(gui);
-    // (old gate path removed - GUI now communicates note on/off via request bitmasks)
-
-    // render voices into out
-    vpool.render_mixed(out, nframes);
-
-    // mix remote audio
-    std::vector<float> mix(nframes, 0.0f);
-    size_t got = ctx.jitter.pop(mix.data(), nframes);
-    if (got) {
-      float rg = ctx.remoteGain.load();
-      for (size_t i = 0; i < got; ++i) out[i] += rg * mix[i];
+    // live input level (the send path and monitor both use it)
+    float inGain = gui.input.gain.load();
+    if (in) {
+      float peak = 0.0f;
+      for (unsigned i = 0; i < nframes; ++i) peak = std::max(peak, std::fabs(in[i]));
+      gui.input.level.store(peak * inGain);
     }
+    busInGain = inGain;
+    reverb->set_enabled(gui.reverb.enabled.load());
+    reverb->set_wet(gui.reverb.wet.load());
+
+    const bool sending = ctx.session.ready.load();
+    // mono send halves the bandwidth, the local output stays stereo
+    const unsigned sendCh = gui.monoSend.load()
+        ? 1u
+        : std::clamp<unsigned>(ctx.session.channels.load(), 1, std::min<unsigned>(ch, kMaxWireChannels));
+    for (unsigned off = 0; off < nframes; off += bus.max_frames()) {
+      const unsigned n = std::min(nframes - off, bus.max_frames());
+      busIn = in ? in + off : nullptr;
+      busOff = off;
+      bus.process({n, ch, sampleRate});
+      audio.meter().mark(DspStage::Effects);
+      std::copy_n(bus.output(reverb), static_cast<size_t>(n) * ch, out + static_cast<size_t>(off) * ch);
 
-    // send audio
-    std::vector<uint8_t> bytes(nframes * sizeof(float));
-    std::memcpy(bytes.data(), out, bytes.size());
-    udp.send(bytes.data(), bytes.size());
-
-    // advance sample position and handle sequencer note release timing
-    globalSamplePos += nframes;
-    if (seqReleaseMask != 0 && globalSamplePos >= seqReleaseSample) {
-      // release all scheduled notes for that step
-      for (int n = 0; n < 12; ++n) if (seqReleaseMask & (1u << n)) vpool.note_off(n);
-      seqReleaseMask = 0;
+      // queue synth + input for the sender thread (it packetizes in the negotiated
+      // size/format); the remote mix is left out, so peers never hear themselves
+      if (!sending) continue;
+      const float* synth = bus.output(synthBus);
+      float tx[AudioSender::kBlockFrames * kMaxWireChannels];
+      for (unsigned sub = 0; sub < n; sub += AudioSender::kBlockFrames) {
+        unsigned m = std::min(n - sub, AudioSender::kBlockFrames);
+        std::fill_n(tx, m * sendCh, 0.0f);
+        mix_channels(tx, sendCh, synth + static_cast<size_t>(sub) * ch, ch, m, 1.0f);
+        if (busIn) mix_channels(tx, sendCh, busIn + sub, 1, m, inGain);
+        sender.submit(tx, m, sendCh,
+                      now + static_cast<uint64_t>(off + sub) * 1000000000ull / static_cast<uint64_t>(sampleRate),
+                      static_cast<uint32_t>(sampleRate));
+      }
     }
+    audio.meter().mark(DspStage::Send);
   });
 
-  if (!audio.open(48000, 128)) {
+  if (!openAudio()) {
     std::printf("Audio open failed\n");
   }
+  ctx.audioOpened.store(true);
 
   // Wait for GUI to exit
   guiThread.join();
   // Ensure other threads see quit and unblock any blocking socket calls
   gui.quitRequested.store(true);
   udp.close();
-  audio.close();
   rx.join();
-  netCtl.join();
+  netCtl.join(); // may reopen the stream, so close audio after it
+  audio.close();
+  sender.stop();
+  directory.stop();
   return 0;
 }
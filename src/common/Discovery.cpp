@@ -0,0 +1,64 @@
+#include "Discovery.h"
+
+#include <charconv>
+
+namespace {
+
+bool parse_uint(std::string_view s, uint32_t& out) {
+  auto res = std::from_chars(s.data(), s.data() + s.size(), out);
+  return res.ec == std::errc{} && res.ptr == s.data() + s.size();
+}
+
+} // namespace
+
+std::string format_beacon(const ServerBeacon& beacon) {
+  std::string msg = std::string(kBeaconPrefix) + ":" + std::to_string(beacon.port);
+  msg += ";peers=" + std::to_string(beacon.peers);
+  msg += ";load=" + std::to_string(beacon.load);
+  msg += ";rooms=";
+  for (size_t i = 0; i < beacon.rooms.size(); ++i) {
+    if (i) msg += ',';
+    msg += beacon.rooms[i];
+  }
+  return msg;
+}
+
+bool parse_beacon(std::string_view msg, ServerBeacon& out) {
+  bool legacy = msg.rfind(kDiscoveryReplyPrefix, 0) == 0;
+  if (!legacy && msg.rfind(kBeaconPrefix, 0) != 0) return false;
+  auto colon = msg.find(':');
+  if (colon == std::string_view::npos) return false;
+  msg.remove_prefix(colon + 1);
+
+  out = ServerBeacon{};
+  auto semi = msg.find(';');
+  uint32_t port = 0;
+  if (!parse_uint(msg.substr(0, semi), port) || port == 0 || port > 0xFFFF) return false;
+  out.port = static_cast<uint16_t>(port);
+  if (legacy || semi == std::string_view::npos) return true;
+  msg.remove_prefix(semi + 1);
+
+  // key=value fields; unknown keys are ignored so the format can grow
+  while (!msg.empty()) {
+    semi = msg.find(';');
+    std::string_view field = msg.substr(0, semi);
+    msg = semi == std::string_view::npos ? std::string_view{} : msg.substr(semi + 1);
+    auto eq = field.find('=');
+    if (eq == std::string_view::npos) continue;
+    std::string_view key = field.substr(0, eq);
+    std::string_view value = field.substr(eq + 1);
+    if (key == "peers") {
+      parse_uint(value, out.peers);
+    } else if (key == "load") {
+      parse_uint(value, out.load);
+    } else if (key == "rooms") {
+      while (!value.empty()) {
+        auto comma = value.find(',');
+        if (comma) out.rooms.emplace_back(value.substr(0, comma));
+        if (comma == std::string_view::npos) break;
+        value.remove_prefix(comma + 1);
+      }
+    }
+  }
+  return true;
+}
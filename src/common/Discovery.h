@@ -1,9 +1,30 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
 
 inline constexpr uint16_t kDiscoveryPort = 50001;
 inline constexpr const char* kDiscoveryMsg = "LANJAM_DISCOVER";
 inline constexpr const char* kDiscoveryReplyPrefix = "LANJAM_SERVER";
-inline constexpr const char* kHelloMsg = "LANJAM_HELLO";
-inline constexpr const char* kWelcomeMsg = "LANJAM_WELCOME";
+
+// Servers periodically broadcast a beacon to kBeaconPort so clients can keep a
+// live server list without probing. Format:
+//   LANJAM_BEACON:<port>;peers=<n>;load=<pps>;rooms=<a,b,...>
+inline constexpr uint16_t kBeaconPort = 50002;
+inline constexpr const char* kBeaconPrefix = "LANJAM_BEACON";
+inline constexpr int kBeaconIntervalMs = 1000;
+inline constexpr int kBeaconExpiryMs = 3500; // drop servers after ~3 missed beacons
+inline constexpr const char* kDefaultRoom = "main";
+
+struct ServerBeacon {
+  uint16_t port = 0;
+  uint32_t peers = 0;
+  uint32_t load = 0; // forwarded packets per second
+  std::vector<std::string> rooms;
+};
+
+std::string format_beacon(const ServerBeacon& beacon);
+// Accepts both beacons and legacy "LANJAM_SERVER:<port>" discovery replies.
+bool parse_beacon(std::string_view msg, ServerBeacon& out);
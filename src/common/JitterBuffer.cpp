@@ -1,29 +1,125 @@
 #include "JitterBuffer.h"
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 
-void JitterBuffer::push(const std::vector<float>& block) {
-  std::scoped_lock<std::mutex> lk(m_);
-  q_.push_back(block);
-  // optional cap
-  if (q_.size() > 64) q_.pop_front();
+namespace {
+// Samples below this (about -60 dBFS) count as silence for time compression
+constexpr float kQuietLevel = 1e-3f;
+// A frame is only dropped from inside a stretch of at least this many quiet
+// frames, so a zero crossing in loud material is never mistaken for silence
+constexpr size_t kQuietRun = 48;
+
+size_t next_pow2(size_t n) {
+  size_t p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+// Copy `n` samples between a linear buffer and the ring, starting at ring sample `pos`
+void ring_copy_in(std::vector<float>& ring, size_t mask, size_t pos, const float* src, size_t n) {
+  size_t start = pos & mask;
+  size_t first = std::min(n, ring.size() - start);
+  std::memcpy(ring.data() + start, src, first * sizeof(float));
+  std::memcpy(ring.data(), src + first, (n - first) * sizeof(float));
+}
+
+void ring_copy_out(const std::vector<float>& ring, size_t mask, size_t pos, float* dst, size_t n) {
+  size_t start = pos & mask;
+  size_t first = std::min(n, ring.size() - start);
+  std::memcpy(dst, ring.data() + start, first * sizeof(float));
+  std::memcpy(dst + first, ring.data(), (n - first) * sizeof(float));
+}
+}
+
+JitterBuffer::JitterBuffer(size_t capacityFrames, unsigned maxChannels)
+    : ring_(next_pow2(std::max<size_t>(capacityFrames, 64) * std::max(maxChannels, 1u)), 0.0f),
+      mask_(ring_.size() - 1),
+      maxChannels_(std::max(maxChannels, 1u)) {}
+
+void JitterBuffer::set_channels(unsigned channels) {
+  channels_ = std::clamp(channels, 1u, maxChannels_);
+  reset();
+}
+
+size_t JitterBuffer::push(const float* frames, size_t nframes) {
+  uint64_t w = write_.load(std::memory_order_relaxed);
+  uint64_t r = read_.load(std::memory_order_acquire);
+  size_t space = capacity() - static_cast<size_t>(w - r);
+  size_t n = std::min(nframes, space);
+  if (n < nframes) overflows_.fetch_add(1, std::memory_order_relaxed);
+
+  ring_copy_in(ring_, mask_, static_cast<size_t>(w) * channels_, frames, n * channels_);
+  write_.store(w + n, std::memory_order_release);
+  return n;
 }
+
 size_t JitterBuffer::pop(float* out, size_t nframes) {
-  std::scoped_lock<std::mutex> lk(m_);
-  if (q_.size() <= target_) return 0;
-  auto blk = q_.front();
-  q_.pop_front();
-  size_t n = std::min(nframes, blk.size());
-  std::copy_n(blk.data(), n, out);
+  uint64_t r = read_.load(std::memory_order_relaxed);
+  uint64_t w = write_.load(std::memory_order_acquire);
+  size_t avail = static_cast<size_t>(w - r);
+
+  const size_t ch = channels_;
+  if (priming_) {
+    if (avail < std::max<size_t>(target_.load(std::memory_order_relaxed), 1)) {
+      std::fill_n(out, nframes * ch, 0.0f);
+      return 0;
+    }
+    priming_ = false;
+  }
+
+  // Above target: drop quiet frames (at most a quarter of this callback)
+  // from inside a run of silence so the delay shrinks without audible
+  // artifacts. The run is measured from the head and its last kQuietRun
+  // frames are kept, so playback resumes on silence, not at the next onset.
+  size_t target = target_.load(std::memory_order_relaxed);
+  if (avail > target + nframes) {
+    size_t maxDrop = std::min(avail - target - nframes, nframes / 4);
+    auto quiet = [&](uint64_t frame) {
+      for (size_t c = 0; c < ch; ++c) {
+        if (std::fabs(ring_[(static_cast<size_t>(frame) * ch + c) & mask_]) >= kQuietLevel) return false;
+      }
+      return true;
+    };
+    size_t run = 0;
+    const size_t scan = std::min(avail, maxDrop + kQuietRun);
+    while (run < scan && quiet(r + run)) ++run;
+    size_t drop = run > kQuietRun ? std::min(run - kQuietRun, maxDrop) : 0;
+    if (drop) {
+      r += drop;
+      avail -= drop;
+      compressed_.fetch_add(drop, std::memory_order_relaxed);
+    }
+  }
+
+  size_t n = std::min(nframes, avail);
+  ring_copy_out(ring_, mask_, static_cast<size_t>(r) * ch, out, n * ch);
+  read_.store(r + n, std::memory_order_release);
+
+  if (n < nframes) {
+    // ran dry: pad with silence and rebuild the cushion before resuming
+    std::fill(out + n * ch, out + nframes * ch, 0.0f);
+    underruns_.fetch_add(1, std::memory_order_relaxed);
+    priming_ = true;
+  }
   return n;
 }
 
-void JitterBuffer::set_target_blocks(size_t blocks) { 
-    std::scoped_lock<std::mutex> lk(m_);
-    target_ = blocks; 
+void JitterBuffer::reset() {
+  write_.store(0, std::memory_order_relaxed);
+  read_.store(0, std::memory_order_relaxed);
+  underruns_.store(0, std::memory_order_relaxed);
+  overflows_.store(0, std::memory_order_relaxed);
+  compressed_.store(0, std::memory_order_relaxed);
+  priming_ = true;
+}
+
+void JitterBuffer::set_target_frames(size_t frames) {
+  target_.store(std::min(frames, capacity() / 2), std::memory_order_relaxed);
 }
 
-size_t JitterBuffer::size() const { 
-    std::scoped_lock<std::mutex> lk(m_); 
-    return q_.size(); 
+size_t JitterBuffer::size() const {
+  uint64_t r = read_.load(std::memory_order_acquire);
+  uint64_t w = write_.load(std::memory_order_acquire);
+  return static_cast<size_t>(w - r);
 }
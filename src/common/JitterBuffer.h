@@ -1,18 +1,55 @@
 #pragma once
-#include <deque>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <mutex>
 
+// Frame-granular single-producer/single-consumer ring of interleaved frames.
+// The network thread pushes whatever packet size arrives, the audio callback
+// pops whatever buffer size it runs at; neither side locks or allocates after
+// construction. Storage is sized for maxChannels, so the channel count can
+// change (while idle) without reallocating.
 class JitterBuffer {
 public:
-  // store vectors of float samples
-  void push(const std::vector<float>& block);
-  size_t pop(float* out, size_t nframes); // returns frames written
-  void set_target_blocks(size_t blocks);  // fixed delay in blocks
-  size_t size() const;
+  explicit JitterBuffer(size_t capacityFrames = 8192, unsigned maxChannels = 2);
+
+  // Only safe while neither side uses it; also empties the ring.
+  void set_channels(unsigned channels);
+  unsigned channels() const { return channels_; }
+
+  // Producer side. Frames that do not fit are dropped (counted as overflow).
+  size_t push(const float* frames, size_t nframes);
+  void push(const std::vector<float>& block) { push(block.data(), block.size() / channels_); }
+
+  // Consumer side, wait-free. Always fills `nframes` (zero-padding when short)
+  // and returns how many real frames were written. Playback (re)starts only
+  // once the target depth has been buffered. When the buffer holds more than
+  // the target, frames from within stretches of silence are skipped to bring
+  // the delay back down.
+  size_t pop(float* out, size_t nframes);
+
+  // Empties the ring and clears counters. Only safe while neither side uses it.
+  void reset();
+
+  void set_target_frames(size_t frames);
+  size_t target_frames() const { return target_.load(std::memory_order_relaxed); }
+  size_t capacity() const { return (mask_ + 1) / channels_; } // frames
+  size_t size() const; // buffered frames
+
+  uint64_t underruns() const { return underruns_.load(std::memory_order_relaxed); }
+  uint64_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+  uint64_t compressed_frames() const { return compressed_.load(std::memory_order_relaxed); }
 
 private:
-  std::deque<std::vector<float>> q_;
-  mutable std::mutex m_;
-  size_t target_ = 2;
+  std::vector<float> ring_;
+  size_t mask_;       // over samples
+  unsigned maxChannels_;
+  unsigned channels_ = 1;
+  alignas(64) std::atomic<uint64_t> write_{0}; // producer-owned
+  alignas(64) std::atomic<uint64_t> read_{0};  // consumer-owned
+  alignas(64) std::atomic<size_t> target_{256};
+  std::atomic<uint64_t> underruns_{0};
+  std::atomic<uint64_t> overflows_{0};
+  std::atomic<uint64_t> compressed_{0};
+  bool priming_ = true; // consumer only
 };
@@ -0,0 +1,77 @@
+#include "Packet.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool peek_msg_type(const uint8_t* data, size_t len, MsgType& type) {
+  if (len < 5) return false;
+  WireReader r(data, len);
+  if (r.u32() != kWireMagic) return false;
+  type = static_cast<MsgType>(r.u8());
+  return true;
+}
+
+size_t encode_audio(uint8_t* dst, size_t cap, const PacketHeader& hdr, const float* samples) {
+  size_t count = static_cast<size_t>(hdr.frames) * hdr.channels;
+  size_t bytes = kAudioHeaderSize + count * bytes_per_sample(hdr.format);
+  if (bytes > cap) return 0;
+
+  WireWriter w(dst, cap);
+  w.u32(kWireMagic);
+  w.u8(static_cast<uint8_t>(MsgType::Audio));
+  w.u8(hdr.flags);
+  w.u8(static_cast<uint8_t>(hdr.format));
+  w.u8(hdr.channels);
+  w.u32(hdr.room_id);
+  w.u32(hdr.sender_id);
+  w.u32(hdr.seq);
+  w.u64(hdr.timestamp_ns);
+  w.u32(hdr.sample_rate);
+  w.u16(hdr.frames);
+  w.u16(0); // reserved
+
+  uint8_t* p = dst + kAudioHeaderSize;
+  if (hdr.format == SampleFormat::S16) {
+    for (size_t i = 0; i < count; ++i) {
+      float s = std::clamp(samples[i], -1.0f, 1.0f);
+      auto v = static_cast<int16_t>(std::lrint(s * 32767.0f));
+      p[2 * i] = static_cast<uint8_t>(v);
+      p[2 * i + 1] = static_cast<uint8_t>(static_cast<uint16_t>(v) >> 8);
+    }
+  } else {
+    // float32 is sent in host order; all supported targets are little-endian
+    std::memcpy(p, samples, count * sizeof(float));
+  }
+  return bytes;
+}
+
+size_t decode_audio(const uint8_t* src, size_t len, PacketHeader& hdr, float* out, size_t maxSamples) {
+  if (len < kAudioHeaderSize) return 0;
+  WireReader r(src, len);
+  if (r.u32() != kWireMagic || r.u8() != static_cast<uint8_t>(MsgType::Audio)) return 0;
+  hdr.flags = r.u8();
+  hdr.format = static_cast<SampleFormat>(r.u8());
+  hdr.channels = r.u8();
+  hdr.room_id = r.u32();
+  hdr.sender_id = r.u32();
+  hdr.seq = r.u32();
+  hdr.timestamp_ns = r.u64();
+  hdr.sample_rate = r.u32();
+  hdr.frames = r.u16();
+  r.u16();
+  if (hdr.format != SampleFormat::F32 && hdr.format != SampleFormat::S16) return 0;
+  if (hdr.channels == 0 || hdr.channels > kMaxWireChannels) return 0;
+
+  size_t count = static_cast<size_t>(hdr.frames) * hdr.channels;
+  if (count > maxSamples || r.remaining() < count * bytes_per_sample(hdr.format)) return 0;
+  const uint8_t* p = r.cursor();
+  if (hdr.format == SampleFormat::S16) {
+    for (size_t i = 0; i < count; ++i) {
+      auto v = static_cast<int16_t>(static_cast<uint16_t>(p[2 * i] | (p[2 * i + 1] << 8)));
+      out[i] = static_cast<float>(v) * (1.0f / 32768.0f);
+    }
+  } else {
+    std::memcpy(out, p, count * sizeof(float));
+  }
+  return count;
+}
@@ -1,16 +1,107 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 
+// Every binary LANjam datagram starts with kWireMagic followed by a MsgType byte.
+// Multi-byte fields are little-endian on the wire.
+inline constexpr uint32_t kWireMagic = 0x4D4A4E4C; // "LNJM"
+inline constexpr size_t kMaxDatagram = 1500;
+inline constexpr size_t kMaxAudioPayload = 1400;   // keep audio datagrams under a typical MTU
+inline constexpr uint8_t kMaxWireChannels = 2;     // interleaved frames: mono or stereo
+
+enum class MsgType : uint8_t {
+  Audio   = 1,
+  Hello   = 2,
+  Welcome = 3,
+  ClockPing = 4,
+  ClockPong = 5,
+  TransportRequest = 6,
+  TransportState = 7,
+};
+
+enum class SampleFormat : uint8_t {
+  F32 = 0,
+  S16 = 1,
+};
+
+enum class Codec : uint8_t {
+  Pcm = 0,
+};
+
+inline size_t bytes_per_sample(SampleFormat f) { return f == SampleFormat::S16 ? 2 : 4; }
+
 struct PacketHeader {
-  uint32_t room_id;
-  uint32_t sender_id;
-  uint32_t seq;
-  uint64_t timestamp_ns;
-  uint8_t  flags;
+  uint32_t room_id = 0;
+  uint32_t sender_id = 0;   // assigned by the server in WELCOME
+  uint32_t seq = 0;
+  uint64_t timestamp_ns = 0;
+  uint8_t  flags = 0;
+  SampleFormat format = SampleFormat::F32;
+  uint8_t  channels = 1;
+  uint16_t frames = 0;
+  uint32_t sample_rate = 48000;
 };
 
+inline constexpr size_t kAudioHeaderSize = 36;
+inline constexpr size_t kSenderIdOffset = 12; // lets the relay stamp sender ids in place
+
 struct AudioPacket {
   PacketHeader hdr{};
   std::vector<uint8_t> payload; // raw PCM for v0; Opus later
 };
+
+// Minimal bounds-checked little-endian writer/reader for wire messages.
+class WireWriter {
+public:
+  WireWriter(uint8_t* buf, size_t cap) : buf_(buf), cap_(cap) {}
+  void u8(uint8_t v) { put(&v, 1); }
+  void u16(uint16_t v) { uint8_t b[2] = {uint8_t(v), uint8_t(v >> 8)}; put(b, 2); }
+  void u32(uint32_t v) { for (int i = 0; i < 4; ++i) u8(uint8_t(v >> (8 * i))); }
+  void u64(uint64_t v) { for (int i = 0; i < 8; ++i) u8(uint8_t(v >> (8 * i))); }
+  size_t size() const { return pos_; }
+  bool ok() const { return ok_; }
+
+private:
+  void put(const uint8_t* p, size_t n) {
+    if (pos_ + n > cap_) { ok_ = false; return; }
+    std::memcpy(buf_ + pos_, p, n);
+    pos_ += n;
+  }
+  uint8_t* buf_;
+  size_t cap_;
+  size_t pos_ = 0;
+  bool ok_ = true;
+};
+
+class WireReader {
+public:
+  WireReader(const uint8_t* buf, size_t len) : buf_(buf), len_(len) {}
+  uint8_t u8() { return pos_ < len_ ? buf_[pos_++] : (ok_ = false, 0); }
+  uint16_t u16() { uint16_t v = u8(); v |= uint16_t(u8()) << 8; return v; }
+  uint32_t u32() { uint32_t v = 0; for (int i = 0; i < 4; ++i) v |= uint32_t(u8()) << (8 * i); return v; }
+  uint64_t u64() { uint64_t v = 0; for (int i = 0; i < 8; ++i) v |= uint64_t(u8()) << (8 * i); return v; }
+  size_t remaining() const { return len_ > pos_ ? len_ - pos_ : 0; }
+  const uint8_t* cursor() const { return buf_ + pos_; }
+  bool ok() const { return ok_; }
+
+private:
+  const uint8_t* buf_;
+  size_t len_;
+  size_t pos_ = 0;
+  bool ok_ = true;
+};
+
+// Returns the message type of a LANjam datagram, or false for foreign/legacy data.
+bool peek_msg_type(const uint8_t* data, size_t len, MsgType& type);
+
+// Audio datagrams: header followed by `frames * channels` interleaved samples
+// in hdr.format. Returns bytes written (0 if it does not fit in cap).
+size_t encode_audio(uint8_t* dst, size_t cap, const PacketHeader& hdr, const float* samples);
+// Decodes into `out` (capacity maxSamples). Returns samples written, 0 on malformed input.
+size_t decode_audio(const uint8_t* src, size_t len, PacketHeader& hdr, float* out, size_t maxSamples);
+// Largest frame count per datagram for the given layout.
+inline size_t max_frames_per_packet(uint8_t channels, SampleFormat f) {
+  return kMaxAudioPayload / (static_cast<size_t>(channels ? channels : 1) * bytes_per_sample(f));
+}
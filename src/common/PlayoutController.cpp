@@ -0,0 +1,77 @@
+#include "PlayoutController.h"
+#include "JitterBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Per-packet decay of the peak jitter and underrun margins. At ~375 packets/s
+// (128 frames @ 48 kHz) the margin halves in roughly 10 seconds.
+constexpr double kMarginDecay = 0.99982;
+constexpr double kJitterScale = 4.0; // mean deviation -> safety margin
+}
+
+void PlayoutController::reset() {
+  haveLast_ = false;
+  nextSeq_ = 0;
+  received_ = 0;
+  jitterNs_ = 0.0;
+  peakNs_ = 0.0;
+  underrunMargin_ = 0.0;
+  jitterMs_.store(0.0f);
+  lossPct_.store(0.0f);
+  lost_.store(0);
+}
+
+void PlayoutController::on_packet(JitterBuffer& jb, uint32_t seq, uint64_t timestampNs, size_t frames,
+                                  uint64_t arrivalNs) {
+  if (!haveLast_) {
+    haveLast_ = true;
+    nextSeq_ = seq + 1;
+    lastArrival_ = arrivalNs;
+    lastTimestamp_ = timestampNs;
+    lastUnderruns_ = jb.underruns();
+    received_ = 1;
+  } else {
+    auto gap = static_cast<int32_t>(seq - nextSeq_);
+    if (gap >= 0) {
+      lost_.fetch_add(static_cast<uint64_t>(gap), std::memory_order_relaxed);
+      nextSeq_ = seq + 1;
+    } else if (lost_.load(std::memory_order_relaxed) > 0) {
+      // late/reordered packet that we already counted as lost
+      lost_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    ++received_;
+
+    // D(i-1,i) = (Rj - Ri) - (Sj - Si); J += (|D| - J) / 16
+    double d = (static_cast<double>(arrivalNs) - static_cast<double>(lastArrival_)) -
+               (static_cast<double>(timestampNs) - static_cast<double>(lastTimestamp_));
+    jitterNs_ += (std::fabs(d) - jitterNs_) / 16.0;
+    peakNs_ = std::max(peakNs_ * kMarginDecay, std::fabs(d));
+    if (gap >= 0) {
+      lastArrival_ = arrivalNs;
+      lastTimestamp_ = timestampNs;
+    }
+  }
+
+  // Underruns: grow fast (one packet plus the current jitter per event)
+  uint64_t under = jb.underruns();
+  if (under != lastUnderruns_) {
+    double perEvent = static_cast<double>(frames) + jitterNs_ * 1e-9 * sr_;
+    underrunMargin_ += perEvent * static_cast<double>(under - lastUnderruns_);
+    lastUnderruns_ = under;
+  }
+  underrunMargin_ *= kMarginDecay;
+
+  double jitterFrames = std::max(kJitterScale * jitterNs_, peakNs_) * 1e-9 * sr_;
+  double base = static_cast<double>(std::max(frames, blockFrames_.load(std::memory_order_relaxed)));
+  auto target = static_cast<size_t>(std::ceil(base + jitterFrames + underrunMargin_));
+  target = std::min(target, jb.capacity() / 2);
+  jb.set_target_frames(target);
+  target_.store(target, std::memory_order_relaxed);
+
+  jitterMs_.store(static_cast<float>(jitterNs_ * 1e-6), std::memory_order_relaxed);
+  uint64_t lost = lost_.load(std::memory_order_relaxed);
+  lossPct_.store(static_cast<float>(100.0 * static_cast<double>(lost) / static_cast<double>(lost + received_)),
+                 std::memory_order_relaxed);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class JitterBuffer;
+
+// Adaptive playout delay for one remote stream. Runs on the network thread:
+// every packet updates the RFC 3550 inter-arrival jitter estimate and the loss
+// counters from sequence numbers and sender timestamps, then retunes the
+// JitterBuffer target. Underruns grow the target immediately; the extra margin
+// decays slowly and the buffer drains the excess by dropping quiet frames.
+class PlayoutController {
+public:
+  void set_sample_rate(double sr) { sr_ = sr; }
+  // Smallest useful target: the local audio callback size. Any thread (the
+  // control thread sets it when the stream reopens).
+  void set_block_frames(size_t frames) { blockFrames_.store(frames, std::memory_order_relaxed); }
+  void reset();
+
+  void on_packet(JitterBuffer& jb, uint32_t seq, uint64_t timestampNs, size_t frames, uint64_t arrivalNs);
+
+  // Stats (readable from any thread)
+  float jitter_ms() const { return jitterMs_.load(std::memory_order_relaxed); }
+  float loss_percent() const { return lossPct_.load(std::memory_order_relaxed); }
+  size_t target_frames() const { return target_.load(std::memory_order_relaxed); }
+  uint64_t lost() const { return lost_.load(std::memory_order_relaxed); }
+
+private:
+  double sr_ = 48000.0;
+  std::atomic<size_t> blockFrames_{128};
+
+  bool haveLast_ = false;
+  uint32_t nextSeq_ = 0;
+  uint64_t lastArrival_ = 0;
+  uint64_t lastTimestamp_ = 0;
+  uint64_t lastUnderruns_ = 0;
+  uint64_t received_ = 0;
+
+  double jitterNs_ = 0.0;   // RFC 3550 smoothed |D|
+  double peakNs_ = 0.0;     // slowly decaying worst transit deviation
+  double underrunMargin_ = 0.0; // frames, added after underruns
+
+  std::atomic<float> jitterMs_{0.0f};
+  std::atomic<float> lossPct_{0.0f};
+  std::atomic<size_t> target_{0};
+  std::atomic<uint64_t> lost_{0};
+};
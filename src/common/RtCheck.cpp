@@ -0,0 +1,48 @@
+#include "RtCheck.h"
+
+#ifdef LANJAM_RT_DEBUG
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local int tlsDepth = 0;
+thread_local bool tlsReporting = false;
+
+void* checked_alloc(std::size_t size) {
+  if (tlsDepth > 0) rt_violation("heap allocation");
+  if (size == 0) size = 1;
+  if (void* p = std::malloc(size)) return p;
+  throw std::bad_alloc();
+}
+}
+
+RtScope::RtScope() { ++tlsDepth; }
+RtScope::~RtScope() { --tlsDepth; }
+
+bool rt_in_callback() { return tlsDepth > 0; }
+
+void rt_violation(const char* what) {
+  if (tlsReporting) return;
+  tlsReporting = true;
+  tlsDepth = 0; // let the report itself allocate
+  std::fprintf(stderr, "RT violation: %s inside the audio callback\n", what);
+  std::fflush(stderr);
+  std::abort();
+}
+
+// Global allocation hooks (the aligned and nothrow forms are not used on the audio path)
+void* operator new(std::size_t size) { return checked_alloc(size); }
+void* operator new[](std::size_t size) { return checked_alloc(size); }
+void operator delete(void* p) noexcept {
+  if (p && tlsDepth > 0) rt_violation("heap free");
+  std::free(p);
+}
+void operator delete[](void* p) noexcept {
+  if (p && tlsDepth > 0) rt_violation("heap free");
+  std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { operator delete[](p); }
+
+#endif
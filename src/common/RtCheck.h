@@ -0,0 +1,40 @@
+#pragma once
+#include <mutex>
+
+// Real-time safety checks for the audio callback. Built with LANJAM_RT_DEBUG
+// (CMake option of the same name), any heap allocation or CheckedMutex lock
+// taken while an RtScope is alive on the current thread is reported and
+// aborts the process. Without the option everything here compiles away.
+#ifdef LANJAM_RT_DEBUG
+
+// Marks the current thread as running the audio callback
+struct RtScope {
+  RtScope();
+  ~RtScope();
+  RtScope(const RtScope&) = delete;
+  RtScope& operator=(const RtScope&) = delete;
+};
+
+bool rt_in_callback();
+void rt_violation(const char* what);
+
+// std::mutex that traps when locked from the audio callback
+class CheckedMutex {
+public:
+  void lock() { if (rt_in_callback()) rt_violation("mutex lock"); m_.lock(); }
+  bool try_lock() { if (rt_in_callback()) rt_violation("mutex try_lock"); return m_.try_lock(); }
+  void unlock() { m_.unlock(); }
+
+private:
+  std::mutex m_;
+};
+
+#else
+
+struct RtScope {
+  RtScope() {}
+};
+inline bool rt_in_callback() { return false; }
+using CheckedMutex = std::mutex;
+
+#endif
@@ -0,0 +1,100 @@
+#include "ServerDirectory.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+ServerDirectory::ServerDirectory(asio::io_context& io) : sock_(io) {}
+
+ServerDirectory::~ServerDirectory() { stop(); }
+
+bool ServerDirectory::start() {
+  if (running_.load()) return true;
+  try {
+    // Several clients on one machine share the beacon port
+    sock_.open(asio::ip::udp::v4());
+    sock_.set_option(asio::socket_base::reuse_address(true));
+    sock_.set_option(asio::socket_base::broadcast(true));
+    sock_.bind(asio::ip::udp::endpoint(asio::ip::udp::v4(), kBeaconPort));
+    sock_.non_blocking(true);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "ServerDirectory: cannot listen on %u -> %s\n", kBeaconPort, e.what());
+    std::error_code ec;
+    sock_.close(ec);
+    return false;
+  }
+  running_.store(true);
+  thread_ = std::thread([this] { run(); });
+  return true;
+}
+
+void ServerDirectory::stop() {
+  running_.store(false);
+  if (thread_.joinable()) thread_.join();
+  std::error_code ec;
+  if (sock_.is_open()) sock_.close(ec);
+}
+
+void ServerDirectory::probe() {
+  if (!running_.load()) return;
+  asio::ip::udp::endpoint bcast(asio::ip::address_v4::broadcast(), kDiscoveryPort);
+  std::error_code ec;
+  sock_.send_to(asio::buffer(kDiscoveryMsg, std::strlen(kDiscoveryMsg)), bcast, 0, ec);
+  if (ec) std::fprintf(stderr, "ServerDirectory: probe failed -> %s\n", ec.message().c_str());
+}
+
+std::vector<ServerDirectory::Entry> ServerDirectory::snapshot() const {
+  auto cutoff = std::chrono::steady_clock::now() - std::chrono::milliseconds(kBeaconExpiryMs);
+  std::vector<Entry> out;
+  {
+    std::lock_guard<std::mutex> lock(m_);
+    for (const auto& e : entries_) {
+      if (e.lastSeen >= cutoff) out.push_back(e);
+    }
+  }
+  return out;
+}
+
+void ServerDirectory::run() {
+  std::vector<uint8_t> buf(1500);
+  auto lastPrune = std::chrono::steady_clock::now();
+  while (running_.load()) {
+    asio::ip::udp::endpoint from;
+    asio::error_code ec;
+    size_t n = sock_.receive_from(asio::buffer(buf), from, 0, ec);
+    auto now = std::chrono::steady_clock::now();
+    if (ec == asio::error::would_block || ec == asio::error::try_again) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    } else if (!ec && n) {
+      ServerBeacon beacon;
+      std::string_view msg(reinterpret_cast<const char*>(buf.data()), n);
+      if (parse_beacon(msg, beacon)) {
+        std::string host = from.address().to_string();
+        std::lock_guard<std::mutex> lock(m_);
+        auto it = std::find_if(entries_.begin(), entries_.end(), [&](const Entry& e) {
+          return e.host == host && e.beacon.port == beacon.port;
+        });
+        if (it == entries_.end()) {
+          entries_.push_back(Entry{host, std::move(beacon), now});
+          std::sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) {
+            return a.host != b.host ? a.host < b.host : a.beacon.port < b.beacon.port;
+          });
+        } else {
+          // legacy probe replies carry only the port; keep the last full beacon
+          if (msg.rfind(kBeaconPrefix, 0) == 0) it->beacon = std::move(beacon);
+          it->lastSeen = now;
+        }
+      }
+    }
+
+    if (now - lastPrune > std::chrono::milliseconds(kBeaconExpiryMs)) {
+      lastPrune = now;
+      auto cutoff = now - std::chrono::milliseconds(kBeaconExpiryMs);
+      std::lock_guard<std::mutex> lock(m_);
+      entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                    [&](const Entry& e) { return e.lastSeen < cutoff; }),
+                     entries_.end());
+    }
+  }
+}
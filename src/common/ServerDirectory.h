@@ -0,0 +1,40 @@
+#pragma once
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Discovery.h"
+
+// Background listener that keeps a live list of LAN servers from their
+// periodic beacons (and from replies to explicit probes).
+class ServerDirectory {
+public:
+  struct Entry {
+    std::string host;
+    ServerBeacon beacon;
+    std::chrono::steady_clock::time_point lastSeen;
+  };
+
+  explicit ServerDirectory(asio::io_context& io);
+  ~ServerDirectory();
+
+  bool start();
+  void stop();
+  // Broadcast a discovery request; replies land in the list asynchronously.
+  void probe();
+  // Live servers (expired entries removed), sorted by host:port.
+  std::vector<Entry> snapshot() const;
+
+private:
+  void run();
+
+  asio::ip::udp::socket sock_;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  mutable std::mutex m_;
+  std::vector<Entry> entries_;
+};
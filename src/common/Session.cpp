@@ -0,0 +1,187 @@
+#include "Session.h"
+
+#include <algorithm>
+
+size_t encode_hello(uint8_t* dst, size_t cap, const HelloMsg& msg) {
+  WireWriter w(dst, cap);
+  w.u32(kWireMagic);
+  w.u8(static_cast<uint8_t>(MsgType::Hello));
+  w.u8(msg.version);
+  w.u32(msg.caps.sample_rate);
+  w.u16(msg.caps.block_frames);
+  w.u16(msg.caps.min_block_frames);
+  w.u8(msg.caps.channels);
+  w.u8(msg.caps.codecs);
+  w.u8(msg.caps.formats);
+  w.u8(msg.caps.max_fec_level);
+  return w.ok() ? w.size() : 0;
+}
+
+bool decode_hello(const uint8_t* src, size_t len, HelloMsg& msg) {
+  WireReader r(src, len);
+  if (r.u32() != kWireMagic || r.u8() != static_cast<uint8_t>(MsgType::Hello)) return false;
+  msg.version = r.u8();
+  msg.caps.sample_rate = r.u32();
+  msg.caps.block_frames = r.u16();
+  msg.caps.min_block_frames = r.u16();
+  msg.caps.channels = r.u8();
+  msg.caps.codecs = r.u8();
+  msg.caps.formats = r.u8();
+  msg.caps.max_fec_level = r.u8();
+  return r.ok();
+}
+
+size_t encode_welcome(uint8_t* dst, size_t cap, const WelcomeMsg& msg) {
+  WireWriter w(dst, cap);
+  w.u32(kWireMagic);
+  w.u8(static_cast<uint8_t>(MsgType::Welcome));
+  w.u8(static_cast<uint8_t>(msg.status));
+  w.u8(static_cast<uint8_t>(msg.reason));
+  w.u32(msg.sender_id);
+  w.u32(msg.config.sample_rate);
+  w.u16(msg.config.block_frames);
+  w.u8(msg.config.channels);
+  w.u8(static_cast<uint8_t>(msg.config.codec));
+  w.u8(static_cast<uint8_t>(msg.config.format));
+  w.u8(msg.config.fec_level);
+  return w.ok() ? w.size() : 0;
+}
+
+bool decode_welcome(const uint8_t* src, size_t len, WelcomeMsg& msg) {
+  WireReader r(src, len);
+  if (r.u32() != kWireMagic || r.u8() != static_cast<uint8_t>(MsgType::Welcome)) return false;
+  msg.status = static_cast<WelcomeStatus>(r.u8());
+  msg.reason = static_cast<RejectReason>(r.u8());
+  msg.sender_id = r.u32();
+  msg.config.sample_rate = r.u32();
+  msg.config.block_frames = r.u16();
+  msg.config.channels = r.u8();
+  msg.config.codec = static_cast<Codec>(r.u8());
+  msg.config.format = static_cast<SampleFormat>(r.u8());
+  msg.config.fec_level = r.u8();
+  return r.ok();
+}
+
+const char* to_string(RejectReason reason) {
+  switch (reason) {
+    case RejectReason::None:       return "none";
+    case RejectReason::Version:    return "protocol version mismatch";
+    case RejectReason::SampleRate: return "sample rate too far from session rate";
+    case RejectReason::Channels:   return "unsupported channel count";
+    case RejectReason::Codec:      return "no common codec";
+    case RejectReason::Format:     return "no common sample format";
+    case RejectReason::BlockSize:  return "no common block size";
+  }
+  return "unknown";
+}
+
+const char* to_string(SampleFormat format) {
+  return format == SampleFormat::S16 ? "s16" : "f32";
+}
+
+RejectReason SessionNegotiator::compute(const std::unordered_map<std::string, Peer>& peers, SessionConfig& out) {
+  uint8_t codecs = 0xFF, formats = 0xFF, channels = 0xFF, fec = 0xFF;
+  uint16_t block = 0xFFFF, minBlock = 0;
+  for (const auto& [key, p] : peers) {
+    codecs &= p.caps.codecs;
+    formats &= p.caps.formats;
+    channels = std::min(channels, p.caps.channels);
+    fec = std::min(fec, p.caps.max_fec_level);
+    block = std::min(block, p.caps.block_frames);
+    minBlock = std::max(minBlock, p.caps.min_block_frames);
+  }
+  if (peers.empty()) return RejectReason::None;
+  if (channels == 0) return RejectReason::Channels;
+  channels = std::min(channels, kMaxWireChannels); // upper bound; a sender may still send mono
+  if (!(codecs & codec_bit(Codec::Pcm))) return RejectReason::Codec;
+
+  // Prefer full-resolution float, fall back to 16-bit
+  if (formats & format_bit(SampleFormat::F32)) out.format = SampleFormat::F32;
+  else if (formats & format_bit(SampleFormat::S16)) out.format = SampleFormat::S16;
+  else return RejectReason::Format;
+
+  size_t maxBlock = max_frames_per_packet(channels, out.format);
+  block = static_cast<uint16_t>(std::min<size_t>(block, maxBlock));
+  if (block < minBlock || block == 0) return RejectReason::BlockSize;
+
+  out.codec = Codec::Pcm;
+  out.channels = channels;
+  out.fec_level = fec;
+  out.block_frames = block;
+  return RejectReason::None;
+}
+
+WelcomeMsg SessionNegotiator::join(const std::string& peer, const HelloMsg& hello) {
+  WelcomeMsg reply;
+  reply.status = WelcomeStatus::Rejected;
+  reply.config = config_;
+  if (hello.version != kProtocolVersion) {
+    reply.reason = RejectReason::Version;
+    return reply;
+  }
+
+  auto candidate = peers_;
+  bool known = candidate.count(peer) != 0;
+  bool alone = candidate.empty() || (candidate.size() == 1 && known);
+  SessionConfig next = config_;
+  if (alone) {
+    next.sample_rate = hello.caps.sample_rate;
+  } else if (hello.caps.sample_rate * 2 < config_.sample_rate ||
+             hello.caps.sample_rate > config_.sample_rate * 2) {
+    // receivers resample other rates, but only within a factor of 4 between any two peers
+    reply.reason = RejectReason::SampleRate;
+    return reply;
+  }
+
+  Peer& p = candidate[peer];
+  p.caps = hello.caps;
+  if (!known) p.sender_id = nextSenderId_;
+  RejectReason reason = compute(candidate, next);
+  if (reason != RejectReason::None) {
+    reply.reason = reason;
+    return reply;
+  }
+
+  if (!known) ++nextSenderId_;
+  peers_ = std::move(candidate);
+  config_ = next;
+
+  bool asked = config_.block_frames == hello.caps.block_frames &&
+               config_.channels == hello.caps.channels &&
+               config_.format == SampleFormat::F32;
+  reply.status = asked ? WelcomeStatus::Accepted : WelcomeStatus::Adapted;
+  reply.sender_id = peers_[peer].sender_id;
+  reply.config = config_;
+  return reply;
+}
+
+bool SessionNegotiator::leave(const std::string& peer) {
+  if (!peers_.erase(peer)) return false;
+  SessionConfig next = config_;
+  if (compute(peers_, next) != RejectReason::None) return false;
+  bool changed = next.block_frames != config_.block_frames || next.channels != config_.channels ||
+                 next.format != config_.format || next.fec_level != config_.fec_level;
+  config_ = next;
+  return changed && !peers_.empty();
+}
+
+uint32_t SessionNegotiator::sender_id(const std::string& peer) const {
+  auto it = peers_.find(peer);
+  return it == peers_.end() ? 0 : it->second.sender_id;
+}
+
+void ClientSession::apply(const WelcomeMsg& msg) {
+  if (msg.status == WelcomeStatus::Rejected) {
+    ready.store(false);
+    rejected.store(true);
+    return;
+  }
+  senderId.store(msg.sender_id);
+  sampleRate.store(msg.config.sample_rate);
+  blockFrames.store(msg.config.block_frames);
+  channels.store(msg.config.channels);
+  format.store(static_cast<uint8_t>(msg.config.format));
+  fecLevel.store(msg.config.fec_level);
+  rejected.store(false);
+  ready.store(true);
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "Packet.h"
+
+// Binary HELLO/WELCOME handshake. A client announces what it can do (HELLO);
+// the server folds that into the session and answers with the parameters the
+// client must use (WELCOME). When a join or leave changes the session the
+// server re-sends WELCOME (status Update) to everyone.
+inline constexpr uint8_t kProtocolVersion = 1;
+inline constexpr int kHelloRetryMs = 500;
+inline constexpr int kPeerTimeoutMs = 10000;
+
+// Bit masks over Codec / SampleFormat values
+inline constexpr uint8_t codec_bit(Codec c) { return static_cast<uint8_t>(1u << static_cast<uint8_t>(c)); }
+inline constexpr uint8_t format_bit(SampleFormat f) { return static_cast<uint8_t>(1u << static_cast<uint8_t>(f)); }
+
+struct SessionCaps {
+  uint32_t sample_rate = 48000;
+  uint16_t block_frames = 128;   // preferred frames per packet (the audio buffer size)
+  uint16_t min_block_frames = 16;
+  uint8_t  channels = 1;         // most channels the peer sends/receives
+  uint8_t  codecs = codec_bit(Codec::Pcm);
+  uint8_t  formats = format_bit(SampleFormat::F32) | format_bit(SampleFormat::S16);
+  uint8_t  max_fec_level = 0;    // 0 = no FEC
+};
+
+struct SessionConfig {
+  uint32_t sample_rate = 48000;  // reference rate; peers within a factor of 2 may run their own
+  uint16_t block_frames = 128;
+  uint8_t  channels = 1;
+  Codec    codec = Codec::Pcm;
+  SampleFormat format = SampleFormat::F32;
+  uint8_t  fec_level = 0;
+};
+
+enum class WelcomeStatus : uint8_t {
+  Accepted = 0, // session matches the peer's preferences
+  Adapted  = 1, // accepted, but the peer must use different values than it asked for
+  Update   = 2, // session changed after another peer joined/left
+  Rejected = 3,
+};
+
+enum class RejectReason : uint8_t {
+  None = 0,
+  Version,
+  SampleRate,
+  Channels,
+  Codec,
+  Format,
+  BlockSize,
+};
+
+struct HelloMsg {
+  uint8_t version = kProtocolVersion;
+  SessionCaps caps;
+};
+
+struct WelcomeMsg {
+  WelcomeStatus status = WelcomeStatus::Accepted;
+  RejectReason reason = RejectReason::None;
+  uint32_t sender_id = 0;
+  SessionConfig config;
+};
+
+size_t encode_hello(uint8_t* dst, size_t cap, const HelloMsg& msg);
+bool decode_hello(const uint8_t* src, size_t len, HelloMsg& msg);
+size_t encode_welcome(uint8_t* dst, size_t cap, const WelcomeMsg& msg);
+bool decode_welcome(const uint8_t* src, size_t len, WelcomeMsg& msg);
+
+const char* to_string(RejectReason reason);
+const char* to_string(SampleFormat format);
+
+// Server-side negotiation state: per-peer capabilities folded into one session.
+// The first peer fixes the sample rate; the block size is the smallest block
+// any peer asked for (bounded by every peer's minimum and the datagram size);
+// codec, format and FEC are the best values every peer supports.
+class SessionNegotiator {
+public:
+  // Adds or refreshes a peer. Rejections leave the session untouched.
+  WelcomeMsg join(const std::string& peer, const HelloMsg& hello);
+  // Returns true if the session changed as a result.
+  bool leave(const std::string& peer);
+  bool has_peer(const std::string& peer) const { return peers_.count(peer) != 0; }
+  uint32_t sender_id(const std::string& peer) const;
+  size_t peer_count() const { return peers_.size(); }
+  const SessionConfig& config() const { return config_; }
+
+private:
+  struct Peer {
+    SessionCaps caps;
+    uint32_t sender_id = 0;
+  };
+  static RejectReason compute(const std::unordered_map<std::string, Peer>& peers, SessionConfig& out);
+
+  std::unordered_map<std::string, Peer> peers_;
+  SessionConfig config_;
+  uint32_t nextSenderId_ = 1;
+};
+
+// Client-side view of the negotiated session. Written by the network thread
+// when a WELCOME arrives, read lock-free by the audio thread.
+struct ClientSession {
+  std::atomic<bool>     ready{false};
+  std::atomic<bool>     rejected{false};
+  std::atomic<uint32_t> senderId{0};
+  std::atomic<uint32_t> sampleRate{48000};
+  std::atomic<uint16_t> blockFrames{128};
+  std::atomic<uint8_t>  channels{1};
+  std::atomic<uint8_t>  format{static_cast<uint8_t>(SampleFormat::F32)};
+  std::atomic<uint8_t>  fecLevel{0};
+
+  void apply(const WelcomeMsg& msg);
+  void reset() { ready.store(false); rejected.store(false); }
+  SampleFormat sample_format() const { return static_cast<SampleFormat>(format.load()); }
+};
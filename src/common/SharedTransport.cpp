@@ -0,0 +1,191 @@
+#include "SharedTransport.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+namespace {
+constexpr double kOffsetSmoothing = 0.25; // per round trip, toward the best recent sample
+constexpr float kMinBpm = 20.0f;
+constexpr float kMaxBpm = 400.0f;
+
+int64_t diff_ns(uint64_t a, uint64_t b) { return static_cast<int64_t>(a - b); }
+} // namespace
+
+double TransportState::step_at(uint64_t serverNs) const {
+  if (!playing) return anchorStep;
+  return anchorStep + static_cast<double>(diff_ns(serverNs, anchorNs)) * static_cast<double>(bpm) / 15e9;
+}
+
+uint64_t steady_now_ns() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+size_t encode_clock_ping(uint8_t* dst, size_t cap, const ClockPingMsg& msg) {
+  WireWriter w(dst, cap);
+  w.u32(kWireMagic);
+  w.u8(static_cast<uint8_t>(MsgType::ClockPing));
+  w.u64(msg.t0);
+  return w.ok() ? w.size() : 0;
+}
+
+bool decode_clock_ping(const uint8_t* src, size_t len, ClockPingMsg& msg) {
+  WireReader r(src, len);
+  if (r.u32() != kWireMagic || r.u8() != static_cast<uint8_t>(MsgType::ClockPing)) return false;
+  msg.t0 = r.u64();
+  return r.ok();
+}
+
+size_t encode_clock_pong(uint8_t* dst, size_t cap, const ClockPongMsg& msg) {
+  WireWriter w(dst, cap);
+  w.u32(kWireMagic);
+  w.u8(static_cast<uint8_t>(MsgType::ClockPong));
+  w.u64(msg.t0);
+  w.u64(msg.t1);
+  w.u64(msg.t2);
+  return w.ok() ? w.size() : 0;
+}
+
+bool decode_clock_pong(const uint8_t* src, size_t len, ClockPongMsg& msg) {
+  WireReader r(src, len);
+  if (r.u32() != kWireMagic || r.u8() != static_cast<uint8_t>(MsgType::ClockPong)) return false;
+  msg.t0 = r.u64();
+  msg.t1 = r.u64();
+  msg.t2 = r.u64();
+  return r.ok();
+}
+
+size_t encode_transport_request(uint8_t* dst, size_t cap, const TransportRequestMsg& msg) {
+  WireWriter w(dst, cap);
+  w.u32(kWireMagic);
+  w.u8(static_cast<uint8_t>(MsgType::TransportRequest));
+  w.u8(static_cast<uint8_t>(msg.command));
+  w.u32(std::bit_cast<uint32_t>(msg.bpm));
+  return w.ok() ? w.size() : 0;
+}
+
+bool decode_transport_request(const uint8_t* src, size_t len, TransportRequestMsg& msg) {
+  WireReader r(src, len);
+  if (r.u32() != kWireMagic || r.u8() != static_cast<uint8_t>(MsgType::TransportRequest)) return false;
+  uint8_t command = r.u8();
+  msg.bpm = std::bit_cast<float>(r.u32());
+  if (command > static_cast<uint8_t>(TransportCommand::Tempo)) return false;
+  msg.command = static_cast<TransportCommand>(command);
+  return r.ok();
+}
+
+size_t encode_transport_state(uint8_t* dst, size_t cap, const TransportState& msg) {
+  WireWriter w(dst, cap);
+  w.u32(kWireMagic);
+  w.u8(static_cast<uint8_t>(MsgType::TransportState));
+  w.u8(msg.playing ? 1 : 0);
+  w.u32(std::bit_cast<uint32_t>(msg.bpm));
+  w.u64(msg.anchorNs);
+  w.u64(std::bit_cast<uint64_t>(msg.anchorStep));
+  w.u64(msg.version);
+  return w.ok() ? w.size() : 0;
+}
+
+bool decode_transport_state(const uint8_t* src, size_t len, TransportState& msg) {
+  WireReader r(src, len);
+  if (r.u32() != kWireMagic || r.u8() != static_cast<uint8_t>(MsgType::TransportState)) return false;
+  msg.playing = r.u8() != 0;
+  msg.bpm = std::bit_cast<float>(r.u32());
+  msg.anchorNs = r.u64();
+  msg.anchorStep = std::bit_cast<double>(r.u64());
+  msg.version = r.u64();
+  return r.ok() && msg.bpm >= kMinBpm && msg.bpm <= kMaxBpm && std::isfinite(msg.anchorStep);
+}
+
+TransportLeader::TransportLeader() {
+  // versions continue upward across server restarts, so clients take the new state
+  state_.version = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+bool TransportLeader::apply(const TransportRequestMsg& req, uint64_t nowNs) {
+  TransportState next = state_;
+  next.anchorNs = std::max(nowNs + static_cast<uint64_t>(kTransportLeadMs) * 1000000u, state_.anchorNs);
+  next.anchorStep = state_.step_at(next.anchorNs);
+  switch (req.command) {
+    case TransportCommand::Play:
+      if (state_.playing) return false;
+      next.playing = true;
+      break;
+    case TransportCommand::Pause:
+      if (!state_.playing) return false;
+      next.playing = false;
+      break;
+    case TransportCommand::Stop:
+      next.playing = false;
+      next.anchorStep = 0.0;
+      break;
+    case TransportCommand::Restart:
+      next.playing = true;
+      next.anchorStep = 0.0;
+      break;
+    case TransportCommand::Tempo:
+      if (!(req.bpm > 0.0f)) return false;
+      next.bpm = std::clamp(req.bpm, kMinBpm, kMaxBpm);
+      if (next.bpm == state_.bpm) return false;
+      break;
+  }
+  ++next.version;
+  state_ = next;
+  return true;
+}
+
+void ClockSync::reset() {
+  count_ = 0;
+  offset_ = rtt_ = 0.0;
+}
+
+void ClockSync::add(uint64_t t0, uint64_t t1, uint64_t t2, uint64_t t3) {
+  Sample s;
+  s.offset = 0.5 * (static_cast<double>(diff_ns(t1, t0)) + static_cast<double>(diff_ns(t2, t3)));
+  s.rtt = std::max(0.0, static_cast<double>(diff_ns(t3, t0)) - static_cast<double>(diff_ns(t2, t1)));
+  samples_[count_ % kWindow] = s;
+  ++count_;
+  const Sample* best = &samples_[0];
+  for (size_t i = 1; i < std::min(count_, kWindow); ++i)
+    if (samples_[i].rtt < best->rtt) best = &samples_[i];
+  if (count_ == 1) offset_ = best->offset;
+  else offset_ += (best->offset - offset_) * kOffsetSmoothing;
+  rtt_ = best->rtt;
+}
+
+void ClientTransport::check_reset() {
+  if (!resetRequested_.exchange(false)) return;
+  clock_.reset();
+  state_ = {};
+  haveState_ = false;
+  publish();
+}
+
+void ClientTransport::publish() {
+  TransportView& v = view.write_buffer();
+  v.valid = clock_.valid() && haveState_;
+  v.offsetNs = clock_.offset_ns();
+  v.state = state_;
+  view.publish();
+  rttMs_.store(clock_.rtt_ns() * 1e-6);
+  offsetMs_.store(clock_.offset_ns() * 1e-6);
+  active_.store(v.valid);
+}
+
+void ClientTransport::on_pong(const ClockPongMsg& msg, uint64_t nowNs) {
+  check_reset();
+  clock_.add(msg.t0, msg.t1, msg.t2, nowNs);
+  publish();
+}
+
+bool ClientTransport::on_state(const TransportState& state) {
+  check_reset();
+  if (haveState_ && static_cast<int64_t>(state.version - state_.version) <= 0) return false;
+  state_ = state;
+  haveState_ = true;
+  publish();
+  return true;
+}
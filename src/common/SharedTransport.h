@@ -0,0 +1,144 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Packet.h"
+#include "TripleBuffer.h"
+
+// Shared transport: the server owns play state, tempo and bar position for
+// the whole session and every client follows it against the server's clock.
+// Clients estimate that clock with CLOCK_PING/CLOCK_PONG round trips; a
+// TRANSPORT_REQUEST (a press of Play, a tempo change) asks the server for a
+// change, which it schedules kTransportLeadMs ahead and sends to everyone as
+// a TRANSPORT_STATE, so every sequencer switches at the same instant.
+inline constexpr int kClockPingMs = 100;
+inline constexpr int kTransportLeadMs = 100;
+inline constexpr int kTransportRepeatMs = 1000; // state re-sent for late joiners and lost datagrams
+
+enum class TransportCommand : uint8_t { Play = 0, Pause, Stop, Restart, Tempo };
+
+// Step position (16th notes, unwrapped) as a line over server time: the
+// position is anchorStep at anchorNs and moves at bpm * 4 steps a minute
+// while playing. A change takes effect at its anchor.
+struct TransportState {
+  bool     playing = false;
+  float    bpm = 120.0f;
+  uint64_t anchorNs = 0;    // server steady_clock
+  double   anchorStep = 0.0;
+  uint64_t version = 0;     // grows with every change
+
+  double step_at(uint64_t serverNs) const;
+};
+
+struct ClockPingMsg {
+  uint64_t t0 = 0; // client send time
+};
+
+struct ClockPongMsg {
+  uint64_t t0 = 0; // echoed
+  uint64_t t1 = 0; // server receive time
+  uint64_t t2 = 0; // server send time
+};
+
+struct TransportRequestMsg {
+  TransportCommand command = TransportCommand::Play;
+  float bpm = 0.0f; // Tempo only
+};
+
+size_t encode_clock_ping(uint8_t* dst, size_t cap, const ClockPingMsg& msg);
+bool decode_clock_ping(const uint8_t* src, size_t len, ClockPingMsg& msg);
+size_t encode_clock_pong(uint8_t* dst, size_t cap, const ClockPongMsg& msg);
+bool decode_clock_pong(const uint8_t* src, size_t len, ClockPongMsg& msg);
+size_t encode_transport_request(uint8_t* dst, size_t cap, const TransportRequestMsg& msg);
+bool decode_transport_request(const uint8_t* src, size_t len, TransportRequestMsg& msg);
+size_t encode_transport_state(uint8_t* dst, size_t cap, const TransportState& msg);
+bool decode_transport_state(const uint8_t* src, size_t len, TransportState& msg);
+
+uint64_t steady_now_ns();
+
+// Server side: the authoritative transport. Changes are anchored
+// kTransportLeadMs after the request so they reach every client in time.
+class TransportLeader {
+public:
+  TransportLeader();
+  // Applies a request received at server time nowNs; false if it changed nothing
+  bool apply(const TransportRequestMsg& req, uint64_t nowNs);
+  const TransportState& state() const { return state_; }
+
+private:
+  TransportState state_;
+};
+
+// Client-side estimate of the server clock, NTP style: each round trip
+// gives an offset whose error is at most half its round-trip time, so the
+// offset of the quickest of the last kWindow round trips is used, smoothed
+// so a new minimum nudges the estimate rather than stepping it.
+class ClockSync {
+public:
+  static constexpr size_t kWindow = 8;
+  static constexpr size_t kMinSamples = 4;
+
+  void reset();
+  // t0 ping sent, t1/t2 server receive/send, t3 pong received
+  void add(uint64_t t0, uint64_t t1, uint64_t t2, uint64_t t3);
+  bool valid() const { return count_ >= kMinSamples; }
+  double offset_ns() const { return offset_; } // server minus local
+  double rtt_ns() const { return rtt_; }       // of the sample in use
+
+private:
+  struct Sample {
+    double offset = 0.0;
+    double rtt = 0.0;
+  };
+  std::array<Sample, kWindow> samples_{};
+  size_t count_ = 0;
+  double offset_ = 0.0;
+  double rtt_ = 0.0;
+};
+
+// What the audio thread follows: the server clock offset and the newest
+// transport state. valid is false until both are known.
+struct TransportView {
+  bool valid = false;
+  double offsetNs = 0.0;
+  TransportState state;
+
+  uint64_t to_server(uint64_t localNs) const {
+    return static_cast<uint64_t>(static_cast<int64_t>(localNs) + static_cast<int64_t>(offsetNs));
+  }
+};
+
+// Client-side view of the shared transport. The receive thread feeds it
+// pongs and states and publishes a TransportView per change; the audio
+// thread reads view lock-free.
+class ClientTransport {
+public:
+  // Any thread: forget the clock and state (a new server)
+  void reset() {
+    active_.store(false);
+    resetRequested_.store(true);
+  }
+  bool active() const { return active_.load(); }
+  double rtt_ms() const { return rttMs_.load(); }
+  double offset_ms() const { return offsetMs_.load(); }
+
+  // Receive thread; on_state returns true for a new state
+  void on_pong(const ClockPongMsg& msg, uint64_t nowNs);
+  bool on_state(const TransportState& state);
+
+  TripleBuffer<TransportView> view;
+
+private:
+  void check_reset();
+  void publish();
+
+  ClockSync clock_;
+  TransportState state_;
+  bool haveState_ = false;
+  std::atomic<bool> resetRequested_{false};
+  std::atomic<bool> active_{false};
+  std::atomic<double> rttMs_{0.0};
+  std::atomic<double> offsetMs_{0.0};
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Fixed-capacity single-producer/single-consumer queue of whole elements.
+// Slots are written and read in place (prepare/commit, front/pop), so large
+// elements such as audio blocks are never copied or allocated after
+// construction. Both sides are wait-free.
+template <typename T>
+class SpscQueue {
+public:
+  explicit SpscQueue(size_t capacity) : slots_(next_pow2(capacity)), mask_(slots_.size() - 1) {}
+
+  // Producer: slot to fill, or nullptr when full. Publish it with commit().
+  T* prepare() {
+    size_t w = write_.load(std::memory_order_relaxed);
+    if (w - read_.load(std::memory_order_acquire) > mask_) return nullptr;
+    return &slots_[w & mask_];
+  }
+  void commit() { write_.store(write_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  // Consumer: oldest element, or nullptr when empty. Release it with pop().
+  T* front() {
+    size_t r = read_.load(std::memory_order_relaxed);
+    if (r == write_.load(std::memory_order_acquire)) return nullptr;
+    return &slots_[r & mask_];
+  }
+  void pop() { read_.store(read_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  size_t size() const {
+    size_t r = read_.load(std::memory_order_acquire);
+    return write_.load(std::memory_order_acquire) - r;
+  }
+  size_t capacity() const { return mask_ + 1; }
+
+private:
+  static size_t next_pow2(size_t n) {
+    size_t p = 2;
+    while (p < n) p <<= 1;
+    return p;
+  }
+
+  std::vector<T> slots_;
+  size_t mask_;
+  alignas(64) std::atomic<size_t> write_{0}; // producer-owned
+  alignas(64) std::atomic<size_t> read_{0};  // consumer-owned
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Single-writer/single-reader latest-value exchange. The writer fills
+// write_buffer() and publish()es it; the reader picks up the newest
+// published value with read(), which returns nullptr when nothing changed
+// since its last read. Three slots mean neither side ever waits or sees a
+// half-written value, and values published in between are simply skipped.
+template <typename T>
+class TripleBuffer {
+public:
+  // Writer
+  T& write_buffer() { return slots_[back_]; }
+  void publish() {
+    versions_[back_] = ++version_;
+    uint8_t prev = middle_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel);
+    back_ = prev & kIndex;
+  }
+
+  // Reader: newest value if one was published since the last read
+  const T* read() {
+    if (!(middle_.load(std::memory_order_relaxed) & kFresh)) return nullptr;
+    uint8_t prev = middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = prev & kIndex;
+    return &slots_[front_];
+  }
+  const T& current() const { return slots_[front_]; } // last value read
+  uint64_t current_version() const { return versions_[front_]; } // 0 before the first read
+
+private:
+  static constexpr uint8_t kIndex = 3;
+  static constexpr uint8_t kFresh = 4;
+
+  T slots_[3]{};
+  uint64_t versions_[3] = {0, 0, 0};
+  uint8_t back_ = 0;                  // writer-owned
+  uint8_t front_ = 1;                 // reader-owned
+  std::atomic<uint8_t> middle_{2};    // shared; kFresh set when unread
+  uint64_t version_ = 0;              // writer-owned publish count
+};
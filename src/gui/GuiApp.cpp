@@ -25,6 +25,19 @@
 #include "GuiStyle.h"
 #include "audio/SynthVoice.h"
 
+// Transport changes play locally, or become requests to the server while
+// the session shares one transport
+static void send_transport(GuiState& shared, AudioEvent::TransportOp op, float value = 0.0f) {
+  if (!shared.transportShared.load()) {
+    shared.events.push(AudioEvent::transport(op, value));
+    return;
+  }
+  if (AudioEvent* slot = shared.transportRequests.prepare()) {
+    *slot = AudioEvent::transport(op, value);
+    shared.transportRequests.commit();
+  }
+}
+
 // Simple ImGui rotary knob widget (returns true if value changed)
 // showLabelBelow: when false the knob will not render its label/number below the control
 static bool ImGuiKnob(const char* label, int* v, int v_min, int v_max, float size = 48.0f, bool showLabelBelow = true) {
@@ -148,12 +161,24 @@ int run_gui(GuiState& shared) {
     ImGui::NewFrame();
 
     std::string discoveryMsg;
-    std::string discoveredHost;
+    std::string sessionMsg;
+    std::vector<LanServerInfo> lanServers;
+    std::string serverHost;
+    uint16_t serverPort = 0;
     {
-      std::lock_guard<std::mutex> lock(shared.discoveryMutex);
+      std::lock_guard<CheckedMutex> lock(shared.discoveryMutex);
       discoveryMsg = shared.discoveryMessage;
-      discoveredHost = shared.discoveredHost;
+      sessionMsg = shared.sessionMessage;
+      lanServers = shared.lanServers;
+      serverHost = shared.serverHost;
+      serverPort = shared.serverPort;
     }
+    // the net thread may pick a server too, so every write goes through the lock
+    auto setServer = [&](const std::string& host, uint16_t port) {
+      std::lock_guard<CheckedMutex> lock(shared.discoveryMutex);
+      shared.serverHost = serverHost = host;
+      shared.serverPort = serverPort = port;
+    };
 
     // (Transport controls moved inside the main ImGui window so UI is contained in a single element)
 
@@ -179,6 +204,7 @@ int run_gui(GuiState& shared) {
     // Draw the knob without its label so we can place the numeric inline with controls
     if (ImGuiKnob("BPM", &bpmVal, 40, 240, 56.0f, false)) {
       shared.sequencer.bpm.store(bpmVal);
+      send_transport(shared, AudioEvent::TransportTempo, static_cast<float>(bpmVal));
     }
     ImGui::SameLine();
     ImGui::Text("BPM %d", bpmVal);
@@ -186,23 +212,27 @@ int run_gui(GuiState& shared) {
     bool isPlaying = shared.sequencer.playing.load();
     if (ImGui::Button(isPlaying ? "Pause" : "Play")) {
       shared.sequencer.playing.store(!isPlaying);
+      send_transport(shared, isPlaying ? AudioEvent::TransportPause : AudioEvent::TransportPlay);
     }
     ImGui::SameLine();
     if (ImGui::Button("Stop")) {
       shared.sequencer.playing.store(false);
       shared.sequencer.step.store(0);
       shared.noteGate.store(false);
+      send_transport(shared, AudioEvent::TransportStop);
     }
     ImGui::SameLine();
     if (ImGui::Button("Restart")) {
       shared.sequencer.step.store(0);
       shared.sequencer.playing.store(true);
+      send_transport(shared, AudioEvent::TransportRestart);
     }
     ImGui::SameLine();
     int poly = shared.polyphony.load();
     ImGui::PushItemWidth(100.0f);
     if (ImGui::SliderInt("Poly", &poly, 1, 64)) {
       shared.polyphony.store(poly);
+      shared.events.push(AudioEvent::param(AudioEvent::ParamPolyphony, static_cast<float>(poly)));
     }
     ImGui::PopItemWidth();
     ImGui::EndGroup();
@@ -212,7 +242,10 @@ int run_gui(GuiState& shared) {
         bool updateHostBuf = initHost;
         if (shared.hostDirty.exchange(false)) updateHostBuf = true;
         if (updateHostBuf) {
-          std::snprintf(hostBuf, sizeof(hostBuf), "%s", shared.serverHost.c_str());
+          std::lock_guard<CheckedMutex> lock(shared.discoveryMutex); // the net thread may have just picked one
+          serverHost = shared.serverHost;
+          serverPort = shared.serverPort;
+          std::snprintf(hostBuf, sizeof(hostBuf), "%s", serverHost.c_str());
           initHost = false;
         }
 
@@ -220,30 +253,63 @@ int run_gui(GuiState& shared) {
         ImGui::InputText("Server", hostBuf, IM_ARRAYSIZE(hostBuf));
         ImGui::PopItemWidth();
         ImGui::SameLine();
-        int p = static_cast<int>(shared.serverPort);
+        int p = static_cast<int>(serverPort);
         ImGui::SetNextItemWidth(70.0f);
-        ImGui::InputInt("Port", &p);
-        p = std::clamp(p, 0, 65535);
-        shared.serverPort = static_cast<uint16_t>(p);
-        if (p == 0) { ImGui::SameLine(); ImGui::TextUnformatted("(auto)"); }
+        if (ImGui::InputInt("Port", &p)) setServer(serverHost, static_cast<uint16_t>(std::clamp(p, 0, 65535)));
+        if (serverPort == 0) { ImGui::SameLine(); ImGui::TextUnformatted("(auto)"); }
 
         if (ImGui::Button("Connect")) {
-          shared.serverHost = hostBuf;
+          setServer(hostBuf, serverPort);
           shared.connectRequested.store(true);
         }
         ImGui::SameLine();
-        bool discovering = shared.discovering.load();
-        ImGui::BeginDisabled(discovering);
         if (ImGui::Button("Discover LAN")) {
           shared.discoverRequested.store(true);
         }
-        ImGui::EndDisabled();
-        if (discovering) {
-          ImGui::SameLine();
-          ImGui::TextUnformatted("Searching...");
-        } else if (!discoveryMsg.empty()) {
+        bool mono = shared.monoSend.load();
+        if (ImGui::Checkbox("Mono send (low bandwidth)", &mono)) shared.monoSend.store(mono);
+        if (!sessionMsg.empty()) {
+          ImGui::TextWrapped("%s", sessionMsg.c_str());
+        }
+        if (!discoveryMsg.empty()) {
           ImGui::TextWrapped("%s", discoveryMsg.c_str());
         }
+
+        // Live server list from beacons; click a row to pick it, double-click to connect
+        ImGui::SeparatorText("LAN Servers");
+        if (lanServers.empty()) {
+          ImGui::TextDisabled("No servers announced yet");
+        } else if (ImGui::BeginTable("LanServers", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingStretchProp)) {
+          ImGui::TableSetupColumn("Server");
+          ImGui::TableSetupColumn("Peers");
+          ImGui::TableSetupColumn("Load (pkt/s)");
+          ImGui::TableSetupColumn("Rooms");
+          ImGui::TableSetupColumn("Seen (ms)");
+          ImGui::TableHeadersRow();
+          for (size_t i = 0; i < lanServers.size(); ++i) {
+            const auto& srv = lanServers[i];
+            std::string label = srv.host + ":" + std::to_string(srv.port);
+            bool current = (serverHost == srv.host && serverPort == srv.port);
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::PushID(static_cast<int>(i));
+            if (ImGui::Selectable(label.c_str(), current, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick)) {
+              std::snprintf(hostBuf, sizeof(hostBuf), "%s", srv.host.c_str());
+              setServer(srv.host, srv.port);
+              if (ImGui::IsMouseDoubleClicked(0)) shared.connectRequested.store(true);
+            }
+            ImGui::PopID();
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%u", srv.peers);
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%u", srv.load);
+            ImGui::TableSetColumnIndex(3);
+            ImGui::TextUnformatted(srv.rooms.c_str());
+            ImGui::TableSetColumnIndex(4);
+            ImGui::Text("%d", srv.ageMs);
+          }
+          ImGui::EndTable();
+        }
         ImGui::EndTabItem();
       }
 
@@ -258,6 +324,7 @@ int run_gui(GuiState& shared) {
         // Use press-and-hold behavior: while the button is active (mouse held) the gate is true.
         int currentNote = shared.params.note.load();
         static int activeKeyHeld = -1; // which key is currently held by mouse (GUI thread only)
+        static int heldMidiNote = -1;  // the note it started, so an octave change can't strand it
         for (int i = 0; i < 12; ++i) {
           ImGui::PushID(i);
           bool selected = (currentNote == i);
@@ -276,14 +343,16 @@ int run_gui(GuiState& shared) {
             // when held, set the selected note and raise the gate
             shared.params.note.store(i);
             currentNote = i;
-            // request a note-on event for this key (audio thread will consume)
-            shared.noteOnRequests.fetch_or(static_cast<uint16_t>(1u << i));
-            activeKeyHeld = i;
+            // one timestamped note-on per press (the audio thread plays it at that frame)
+            if (activeKeyHeld != i) {
+              heldMidiNote = (octave + 1) * 12 + i;
+              shared.events.push(AudioEvent::note_on(heldMidiNote, 1.0f));
+              activeKeyHeld = i;
+            }
           } else {
             // if this key was previously held but now released, drop the gate
             if (activeKeyHeld == i) {
-              // request a note-off event for this key
-              shared.noteOffRequests.fetch_or(static_cast<uint16_t>(1u << i));
+              shared.events.push(AudioEvent::note_off(heldMidiNote));
               activeKeyHeld = -1;
             }
           }
@@ -341,9 +410,27 @@ int run_gui(GuiState& shared) {
         int stages = shared.params.filterSlope.load();
         if (ImGui::SliderInt("Slope (stages)", &stages, 1, 4)) shared.params.filterSlope.store(stages);
 
+        // same responses; the SVF follows cutoff changes per sample
+        const char* filterModes[] = {"Biquad", "SVF (zero-delay)"};
+        int filterMode = shared.params.filterMode.load();
+        if (ImGui::Combo("Filter Model", &filterMode, filterModes, IM_ARRAYSIZE(filterModes)))
+          shared.params.filterMode.store(filterMode);
+
+        // Oversampling trades polyphony for cleaner highs (see lan_jam_client --bench)
+        const char* qualities[] = {"Normal (1x)", "High (2x)", "Ultra (4x)", "Extreme (8x)"};
+        int quality = 0;
+        while ((1 << quality) < shared.params.oversampling.load() && quality < 3) ++quality;
+        if (ImGui::Combo("Quality", &quality, qualities, IM_ARRAYSIZE(qualities)))
+          shared.params.oversampling.store(1 << quality);
+
         float rg = shared.params.remoteGain.load();
         if (ImGui::SliderFloat("Remote Gain", &rg, 0.0f, 1.0f, "%.2f")) shared.params.remoteGain.store(rg);
 
+        float pan = shared.params.pan.load();
+        if (ImGui::SliderFloat("Pan", &pan, -1.0f, 1.0f, "%.2f")) shared.params.pan.store(pan);
+        float spread = shared.params.stereoSpread.load();
+        if (ImGui::SliderFloat("Stereo Spread", &spread, 0.0f, 1.0f, "%.2f")) shared.params.stereoSpread.store(spread);
+
   ImGui::SeparatorText("Amplitude Envelope (ADSR)");
   float attack = shared.params.envAttack.load();
   if (ImGui::SliderFloat("Attack (s)", &attack, 0.001f, 2.0f, "%.3f")) shared.params.envAttack.store(attack);
@@ -358,7 +445,7 @@ int run_gui(GuiState& shared) {
 
         constexpr int kResponsePoints = 128;
         static std::array<float, kResponsePoints> response{};
-        const float sampleRate = 48000.0f;
+        const float sampleRate = static_cast<float>(shared.device.activeRate.load());
         const float logStart = std::log10(20.0f);
         const float logEnd = std::log10(sampleRate * 0.5f);
 
@@ -386,6 +473,55 @@ int run_gui(GuiState& shared) {
         ImGui::EndTabItem();
       }
 
+      if (ImGui::BeginTabItem("Mod")) {
+        // GUI-thread copy; publish_patch hands it to the audio thread
+        ModMatrix& mod = shared.params.mod;
+        const char* lfoShapes[] = {"Sine", "Triangle", "Saw", "Square"};
+        for (int i = 0; i < ModMatrix::kLfos; ++i) {
+          ImGui::PushID(i);
+          ImGui::SeparatorText(i == 0 ? "LFO 1" : "LFO 2");
+          ImGui::SliderFloat("Rate (Hz)", &mod.lfo[i].rate, 0.01f, 20.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+          ImGui::Combo("Shape", &mod.lfo[i].shape, lfoShapes, IM_ARRAYSIZE(lfoShapes));
+          ImGui::PopID();
+        }
+
+        ImGui::SeparatorText("Filter Envelope");
+        ImGui::SliderFloat("Attack (s)##fenv", &mod.envAttack, 0.001f, 2.0f, "%.3f");
+        ImGui::SliderFloat("Decay (s)##fenv", &mod.envDecay, 0.001f, 2.0f, "%.3f");
+        ImGui::SliderFloat("Sustain##fenv", &mod.envSustain, 0.0f, 1.0f, "%.2f");
+        ImGui::SliderFloat("Release (s)##fenv", &mod.envRelease, 0.001f, 5.0f, "%.3f");
+
+        ImGui::SeparatorText("Routes");
+        const char* sources[] = {"None", "LFO 1", "LFO 2", "Filter Env", "Velocity", "Key"};
+        const char* dests[] = {"Cutoff", "Pitch", "Pan", "Amp"};
+        const float destRange[] = {8.0f, 24.0f, 1.0f, 1.0f}; // octaves, semitones, pan, gain
+        const char* destFormat[] = {"%+.2f oct", "%+.2f st", "%+.2f", "%+.2f"};
+        for (int i = 0; i < ModMatrix::kRoutes; ++i) {
+          auto& r = mod.routes[i];
+          ImGui::PushID(100 + i);
+          ImGui::SetNextItemWidth(110.0f);
+          ImGui::Combo("##src", &r.source, sources, IM_ARRAYSIZE(sources));
+          ImGui::SameLine();
+          ImGui::SetNextItemWidth(90.0f);
+          if (ImGui::Combo("##dst", &r.dest, dests, IM_ARRAYSIZE(dests)))
+            r.amount = std::clamp(r.amount, -destRange[r.dest], destRange[r.dest]);
+          ImGui::SameLine();
+          ImGui::SliderFloat("##amount", &r.amount, -destRange[r.dest], destRange[r.dest], destFormat[r.dest]);
+          ImGui::PopID();
+        }
+
+        ImGui::SeparatorText("Control Rate");
+        const int periods[] = {8, 16, 32, 64};
+        const char* periodNames[] = {"8 frames", "16 frames", "32 frames", "64 frames"};
+        int periodIdx = 0;
+        for (int i = 0; i < IM_ARRAYSIZE(periods); ++i)
+          if (periods[i] <= mod.controlPeriod) periodIdx = i;
+        if (ImGui::Combo("Update Period", &periodIdx, periodNames, IM_ARRAYSIZE(periodNames)))
+          mod.controlPeriod = periods[periodIdx];
+        ImGui::TextDisabled("Routes are evaluated once per period and ramped in between");
+        ImGui::EndTabItem();
+      }
+
       if (ImGui::BeginTabItem("Sequencer")) {
         // --- Sequencer tab ---
         ImGui::Text("Sequencer");
@@ -394,6 +530,7 @@ int run_gui(GuiState& shared) {
         int bpmVal = shared.sequencer.bpm.load();
         if (ImGuiKnob("BPM", &bpmVal, 40, 240, 48.0f)) {
           shared.sequencer.bpm.store(bpmVal);
+          send_transport(shared, AudioEvent::TransportTempo, static_cast<float>(bpmVal));
         }
         ImGui::SameLine();
         bool isPlaying = shared.sequencer.playing.load();
@@ -401,8 +538,10 @@ int run_gui(GuiState& shared) {
           shared.sequencer.playing.store(!isPlaying);
           if (shared.sequencer.playing.load()) {
             shared.sequencer.step.store(0);
+            send_transport(shared, AudioEvent::TransportRestart);
           } else {
             shared.noteGate.store(false);
+            send_transport(shared, AudioEvent::TransportStop);
           }
         }
 
@@ -468,6 +607,159 @@ int run_gui(GuiState& shared) {
         ImGui::EndTabItem();
       }
 
+      if (ImGui::BeginTabItem("Audio")) {
+        // Choices are staged here and applied together; Apply reopens the stream live
+        std::vector<AudioDeviceChoice> devices;
+        std::string message;
+        {
+          std::lock_guard<CheckedMutex> lock(shared.device.mutex);
+          devices = shared.device.devices;
+          message = shared.device.message;
+        }
+        auto deviceCombo = [&](const char* label, std::atomic<unsigned>& sel, bool output) {
+          unsigned id = sel.load();
+          std::string preview = "System default";
+          for (const auto& d : devices) if (d.id == id) preview = d.name;
+          ImGui::SetNextItemWidth(320.0f);
+          if (ImGui::BeginCombo(label, preview.c_str())) {
+            if (ImGui::Selectable("System default", id == 0)) sel.store(0);
+            for (const auto& d : devices) {
+              if ((output ? d.outputChannels : d.inputChannels) == 0) continue;
+              std::string name = d.name + ((output ? d.isDefaultOutput : d.isDefaultInput) ? " (default)" : "");
+              if (ImGui::Selectable(name.c_str(), d.id == id)) sel.store(d.id);
+            }
+            ImGui::EndCombo();
+          }
+        };
+        deviceCombo("Output device", shared.device.outputDevice, true);
+        deviceCombo("Input device", shared.device.inputDevice, false);
+
+        // rates the chosen output device reports (common ones if it reports none)
+        std::vector<unsigned> rates = {44100, 48000, 88200, 96000};
+        unsigned outId = shared.device.outputDevice.load();
+        for (const auto& d : devices) {
+          bool chosen = outId ? d.id == outId : d.isDefaultOutput;
+          if (chosen && !d.sampleRates.empty()) rates = d.sampleRates;
+        }
+        unsigned rate = shared.device.sampleRate.load();
+        ImGui::SetNextItemWidth(160.0f);
+        if (ImGui::BeginCombo("Sample rate", (std::to_string(rate) + " Hz").c_str())) {
+          for (unsigned r : rates) {
+            if (ImGui::Selectable((std::to_string(r) + " Hz").c_str(), r == rate)) shared.device.sampleRate.store(r);
+          }
+          ImGui::EndCombo();
+        }
+        static constexpr unsigned kBufferSizes[] = {32, 64, 128, 256, 512, 1024};
+        unsigned frames = shared.device.bufferFrames.load();
+        ImGui::SetNextItemWidth(160.0f);
+        if (ImGui::BeginCombo("Buffer size", (std::to_string(frames) + " frames").c_str())) {
+          for (unsigned f : kBufferSizes) {
+            char label[48];
+            std::snprintf(label, sizeof(label), "%u frames (%.2f ms)", f, f * 1000.0 / rate);
+            if (ImGui::Selectable(label, f == frames)) shared.device.bufferFrames.store(f);
+          }
+          ImGui::EndCombo();
+        }
+
+        if (ImGui::Button("Apply")) shared.device.applyRequested.store(true);
+        ImGui::SameLine();
+        if (ImGui::Button("Rescan devices")) shared.device.rescanRequested.store(true);
+
+        unsigned activeRate = shared.device.activeRate.load();
+        unsigned activeFrames = shared.device.activeFrames.load();
+        ImGui::Text("Running: %u Hz, %u frames (%.2f ms), device latency %u frames", activeRate, activeFrames,
+                    activeFrames * 1000.0 / activeRate, shared.device.latencyFrames.load());
+        if (!message.empty()) ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.3f, 1.0f), "%s", message.c_str());
+        ImGui::EndTabItem();
+      }
+
+      if (ImGui::BeginTabItem("Input")) {
+        // Channel list comes from the selected input device; picking one reopens the stream duplex
+        int available = shared.input.available.load();
+        int channel = shared.input.channel.load();
+        std::string preview = channel < 0 ? std::string("None (synth only)") : "Input " + std::to_string(channel + 1);
+        ImGui::SetNextItemWidth(200.0f);
+        if (ImGui::BeginCombo("Input channel", preview.c_str())) {
+          if (ImGui::Selectable("None (synth only)", channel < 0) && channel >= 0) {
+            shared.input.channel.store(-1);
+            shared.input.reopenRequested.store(true);
+          }
+          for (int ch = 0; ch < available; ++ch) {
+            std::string label = "Input " + std::to_string(ch + 1);
+            if (ImGui::Selectable(label.c_str(), ch == channel) && ch != channel) {
+              shared.input.channel.store(ch);
+              shared.input.reopenRequested.store(true);
+            }
+          }
+          ImGui::EndCombo();
+        }
+        if (available == 0) ImGui::TextDisabled("No input device found");
+        else if (channel >= 0 && !shared.input.active.load()) ImGui::TextDisabled("Input could not be opened");
+
+        float inGain = shared.input.gain.load();
+        ImGui::SetNextItemWidth(200.0f);
+        if (ImGui::SliderFloat("Input gain", &inGain, 0.0f, 4.0f, "%.2f")) shared.input.gain.store(inGain);
+        ImGui::ProgressBar(std::min(shared.input.level.load(), 1.0f), ImVec2(200.0f, 0.0f), "");
+        ImGui::SameLine();
+        ImGui::TextUnformatted("Level");
+
+        ImGui::SeparatorText("Monitor");
+        int mode = shared.input.monitorMode.load();
+        bool changed = ImGui::RadioButton("Off", &mode, 0);
+        ImGui::SameLine();
+        changed |= ImGui::RadioButton("Direct", &mode, 1);
+        ImGui::SameLine();
+        changed |= ImGui::RadioButton("Latency-compensated", &mode, 2);
+        if (changed) shared.input.monitorMode.store(mode);
+        float monGain = shared.input.monitorGain.load();
+        ImGui::SetNextItemWidth(200.0f);
+        if (ImGui::SliderFloat("Monitor gain", &monGain, 0.0f, 2.0f, "%.2f")) shared.input.monitorGain.store(monGain);
+        if (mode == 2) ImGui::Text("Monitor delay: %.1f ms (matches what peers hear)", shared.input.monitorDelayMs.load());
+        ImGui::EndTabItem();
+      }
+
+      if (ImGui::BeginTabItem("Reverb")) {
+        // Convolution reverb on everything you hear; peers get the dry signal
+        static char irBuf[260];
+        static bool irInit = false;
+        if (!irInit) {
+          std::lock_guard<CheckedMutex> lock(shared.reverb.mutex);
+          std::snprintf(irBuf, sizeof(irBuf), "%s", shared.reverb.path.c_str());
+          irInit = true;
+        }
+        bool enabled = shared.reverb.enabled.load();
+        if (ImGui::Checkbox("Enable reverb", &enabled)) shared.reverb.enabled.store(enabled);
+        float wet = shared.reverb.wet.load();
+        ImGui::SetNextItemWidth(200.0f);
+        if (ImGui::SliderFloat("Wet", &wet, 0.0f, 1.0f, "%.2f")) shared.reverb.wet.store(wet);
+
+        ImGui::SeparatorText("Impulse response");
+        ImGui::SetNextItemWidth(320.0f);
+        ImGui::InputText("WAV file", irBuf, IM_ARRAYSIZE(irBuf));
+        ImGui::SameLine();
+        if (ImGui::Button("Load")) {
+          std::lock_guard<CheckedMutex> lock(shared.reverb.mutex);
+          shared.reverb.path = irBuf;
+          shared.reverb.message = "Loading...";
+          shared.reverb.loadRequested.store(true);
+        }
+        float seconds = shared.reverb.seconds.load();
+        if (seconds > 0.0f) {
+          ImGui::Text("Loaded: %.2f s, %s", seconds, shared.reverb.channels.load() > 1 ? "stereo" : "mono");
+          ImGui::Text("Tail thread: %.1f%% of one core   late blocks: %" PRIu64, shared.reverb.tailLoad.load(),
+                      shared.reverb.lateBlocks.load());
+        } else {
+          ImGui::TextDisabled("No impulse response loaded");
+        }
+        std::string message;
+        {
+          std::lock_guard<CheckedMutex> lock(shared.reverb.mutex);
+          message = shared.reverb.message;
+        }
+        if (!message.empty()) ImGui::TextWrapped("%s", message.c_str());
+        ImGui::EndTabItem();
+      }
+
       if (ImGui::BeginTabItem("Transport & Stats")) {
         bool audioRunning = shared.audioRunning.load();
         ImGui::Text("Audio status: %s", audioRunning ? "Running" : "Stopped");
@@ -481,9 +773,73 @@ int run_gui(GuiState& shared) {
 
         ImGui::Separator();
         ImGui::Text("RX packets: %u", shared.stats.rxPackets.load());
-        ImGui::Text("Jitter depth: %zu blocks", shared.stats.jitterDepth.load());
+        ImGui::Text("Jitter depth: %zu frames (target %zu, %.1f ms)", shared.stats.jitterDepth.load(),
+                    shared.stats.jitterTarget.load(), shared.stats.jitterTarget.load() * 1000.0 / shared.device.activeRate.load());
+        ImGui::Text("Arrival jitter: %.2f ms   Loss: %.2f%%", shared.stats.jitterMs.load(), shared.stats.lossPercent.load());
+        ImGui::Text("Jitter underruns: %" PRIu64 "   overflows: %" PRIu64 "   compressed: %" PRIu64 " frames",
+                    shared.stats.jitterUnderruns.load(), shared.stats.jitterOverflows.load(),
+                    shared.stats.jitterCompressed.load());
         ImGui::Text("XRuns: %u", shared.stats.xruns.load());
 
+        ImGui::SeparatorText("DSP Load");
+        float dsp = shared.stats.dspLoad.load();
+        char dspLabel[32];
+        std::snprintf(dspLabel, sizeof(dspLabel), "%.1f%%", dsp);
+        ImGui::ProgressBar(std::clamp(dsp / 100.0f, 0.0f, 1.0f), ImVec2(-1, 0), dspLabel);
+        ImGui::Text("Callback p99: %.3f ms   max: %.3f ms   deadline: %.3f ms", shared.stats.callbackP99Ms.load(),
+                    shared.stats.callbackMaxMs.load(), shared.stats.callbackDeadlineMs.load());
+        ImGui::Text("Late callbacks: %" PRIu64, shared.stats.lateCallbacks.load());
+        ImGui::Text("Dropped events: %" PRIu64, shared.stats.droppedEvents.load());
+        if (shared.transportShared.load())
+          ImGui::Text("Transport: shared with the session (server round trip %.2f ms, clock offset %.3f ms)",
+                      shared.stats.clockRttMs.load(), shared.stats.clockOffsetMs.load());
+        else
+          ImGui::TextUnformatted("Transport: local");
+        ImGui::Text("Sequencer %.1f%%   Synth %.1f%%   Send %.1f%%   Remote mix %.1f%%   Effects %.1f%%",
+                    shared.stats.stageLoad[0].load(), shared.stats.stageLoad[1].load(),
+                    shared.stats.stageLoad[2].load(), shared.stats.stageLoad[3].load(),
+                    shared.stats.stageLoad[4].load());
+
+        ImGui::SeparatorText("Remote Peers");
+        ImGui::Text("Active peers: %u", shared.stats.activePeers.load());
+        if (ImGui::BeginTable("RemotePeers", 8, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingStretchProp)) {
+          ImGui::TableSetupColumn("Sender");
+          ImGui::TableSetupColumn("Gain");
+          ImGui::TableSetupColumn("Depth");
+          ImGui::TableSetupColumn("Target");
+          ImGui::TableSetupColumn("Jitter (ms)");
+          ImGui::TableSetupColumn("Loss %");
+          ImGui::TableSetupColumn("Rate");
+          ImGui::TableSetupColumn("Drift (ppm)");
+          ImGui::TableHeadersRow();
+          for (size_t i = 0; i < shared.stats.peers.size(); ++i) {
+            auto& peer = shared.stats.peers[i];
+            if (!peer.active.load()) continue;
+            ImGui::PushID(static_cast<int>(i));
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::Text("#%u", peer.senderId.load());
+            ImGui::TableSetColumnIndex(1);
+            float g = peer.gain.load();
+            ImGui::SetNextItemWidth(120.0f);
+            if (ImGui::SliderFloat("##gain", &g, 0.0f, 2.0f, "%.2f")) peer.gain.store(g);
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%zu", peer.depth.load());
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%zu", peer.target.load());
+            ImGui::TableSetColumnIndex(4);
+            ImGui::Text("%.2f", peer.jitterMs.load());
+            ImGui::TableSetColumnIndex(5);
+            ImGui::Text("%.2f", peer.lossPercent.load());
+            ImGui::TableSetColumnIndex(6);
+            ImGui::Text("%u", peer.sampleRate.load());
+            ImGui::TableSetColumnIndex(7);
+            ImGui::Text("%+.0f", peer.driftPpm.load());
+            ImGui::PopID();
+          }
+          ImGui::EndTable();
+        }
+
         ImGui::EndTabItem();
       }
       ImGui::EndTabBar();
@@ -498,6 +854,9 @@ int run_gui(GuiState& shared) {
 
     ImGui::End();
 
+    // Hand this frame's synth edits to the audio thread
+    publish_patch(shared);
+
     // Render
     ImGui::Render();
     int w, h; glfwGetFramebufferSize(window, &w, &h);
@@ -3,6 +3,12 @@
 #include <string>
 #include <mutex>
 #include <array>
+#include <vector>
+
+#include "common/RtCheck.h"
+#include "common/TripleBuffer.h"
+#include "audio/EventQueue.h"
+#include "audio/ModMatrix.h"
 
 struct OscParams {
   std::atomic<int>   wave{0};     // 0=saw,1=square,2=sine
@@ -11,6 +17,33 @@ struct OscParams {
   std::atomic<float> phase{0.0f};  // degrees 0-360
 };
 
+// Plain copy of the voice-shaping parameters, published to the audio thread
+// as one consistent snapshot (GuiState::patch) whenever any of them changes
+struct SynthPatch {
+  struct Osc {
+    int   wave = 0;
+    int   octave = 0;
+    float detune = 0.0f;
+    float phase = 0.0f;
+    bool operator==(const Osc&) const = default;
+  };
+  std::array<Osc, 3> osc{};
+  float cutoff = 1200.0f;
+  float resonance = 0.7f;
+  int   filterType = 0;
+  int   filterSlope = 1;
+  int   filterMode = 0;
+  int   oversampling = 1;
+  float pan = 0.0f;
+  float stereoSpread = 0.5f;
+  float envAttack = 0.01f;
+  float envDecay = 0.1f;
+  float envSustain = 0.8f;
+  float envRelease = 0.2f;
+  ModMatrix mod{};
+  bool operator==(const SynthPatch&) const = default;
+};
+
 struct SynthParams {
   std::atomic<int>   octave{3};   // 3 -> A3 ~ 220 Hz
   std::atomic<int>   note{9};     // 0=C, 9=A
@@ -18,35 +51,173 @@ struct SynthParams {
   std::atomic<float> resonance{0.7f}; // filter Q
   std::atomic<int>   filterType{0};   // 0=low,1=band,2=high
   std::atomic<int>   filterSlope{1};  // stages 1-4
+  std::atomic<int>   filterMode{0};   // 0=biquad, 1=SVF (SynthVoice::FilterMode)
+  std::atomic<int>   oversampling{1}; // voice render rate multiple: 1, 2, 4, 8
   std::array<OscParams, 3> osc{};
   std::atomic<float> remoteGain{0.5f};
+  std::atomic<float> pan{0.0f};          // -1..1, voice placement
+  std::atomic<float> stereoSpread{0.5f}; // 0..1, spreads notes C..B across the field
   // ADSR envelope parameters (seconds for times, 0..1 for sustain)
   std::atomic<float> envAttack{0.01f};
   std::atomic<float> envDecay{0.1f};
   std::atomic<float> envSustain{0.8f};
   std::atomic<float> envRelease{0.2f};
+  // Edited and snapshotted on the GUI thread only; reaches the audio thread
+  // inside the published patch
+  ModMatrix mod{};
+
+  SynthPatch snapshot() const {
+    SynthPatch p;
+    for (size_t i = 0; i < osc.size(); ++i) {
+      p.osc[i].wave = osc[i].wave.load();
+      p.osc[i].octave = osc[i].octave.load();
+      p.osc[i].detune = osc[i].detune.load();
+      p.osc[i].phase = osc[i].phase.load();
+    }
+    p.cutoff = cutoff.load();
+    p.resonance = resonance.load();
+    p.filterType = filterType.load();
+    p.filterSlope = filterSlope.load();
+    p.filterMode = filterMode.load();
+    p.oversampling = oversampling.load();
+    p.pan = pan.load();
+    p.stereoSpread = stereoSpread.load();
+    p.envAttack = envAttack.load();
+    p.envDecay = envDecay.load();
+    p.envSustain = envSustain.load();
+    p.envRelease = envRelease.load();
+    p.mod = mod;
+    return p;
+  }
+};
+
+// Receive stats for one remote peer, indexed by mixer slot
+struct RemotePeerStats {
+  std::atomic<bool>     active{false};
+  std::atomic<uint32_t> senderId{0};
+  std::atomic<float>    gain{1.0f};        // GUI -> mixer
+  std::atomic<size_t>   depth{0};
+  std::atomic<size_t>   target{0};
+  std::atomic<float>    jitterMs{0.0f};
+  std::atomic<float>    lossPercent{0.0f};
+  std::atomic<uint32_t> sampleRate{0};      // sender's nominal rate
+  std::atomic<float>    driftPpm{0.0f};     // clock-drift correction applied by the resampler
 };
 
 struct NetStats {
   std::atomic<uint32_t> rxPackets{0};
-  std::atomic<uint32_t> xruns{0};
-  std::atomic<size_t>   jitterDepth{0};
+  std::atomic<uint32_t> xruns{0};           // device under/overflows
+  // audio callback timing, published once a second
+  std::atomic<float>    dspLoad{0.0f};         // % of the buffer period spent in the callback
+  std::atomic<float>    callbackP99Ms{0.0f};
+  std::atomic<float>    callbackMaxMs{0.0f};
+  std::atomic<float>    callbackDeadlineMs{0.0f};
+  std::atomic<uint64_t> lateCallbacks{0};      // callbacks that overran the buffer period
+  std::atomic<uint64_t> droppedEvents{0};      // GUI/sequencer events lost to full queues
+  std::atomic<float>    clockRttMs{0.0f};      // shared transport: server round trip
+  std::atomic<float>    clockOffsetMs{0.0f};   // shared transport: server clock minus ours
+  std::array<std::atomic<float>, 5> stageLoad{}; // sequencer, synth, send, remote mix, effects (% of period)
+  std::atomic<size_t>   jitterDepth{0};      // buffered remote frames
+  std::atomic<uint64_t> jitterUnderruns{0};
+  std::atomic<uint64_t> jitterOverflows{0};
+  std::atomic<uint64_t> jitterCompressed{0}; // quiet frames dropped to shrink delay
+  std::atomic<size_t>   jitterTarget{0};     // adaptive playout target (frames)
+  std::atomic<float>    jitterMs{0.0f};      // measured inter-arrival jitter
+  std::atomic<float>    lossPercent{0.0f};
+  // aggregate fields above report the worst peer (counters are totals)
+  std::atomic<uint32_t> activePeers{0};
+  std::array<RemotePeerStats, 16> peers{}; // must match RemoteMixer::kMaxPeers
+};
+
+// One row of the live LAN server list (filled from beacons by the net thread)
+struct LanServerInfo {
+  std::string host;
+  uint16_t    port = 0;
+  uint32_t    peers = 0;
+  uint32_t    load = 0;  // packets/s relayed
+  std::string rooms;
+  int         ageMs = 0; // time since last beacon
+};
+
+// Live input (mic / instrument) capture and local monitoring
+struct InputState {
+  std::atomic<int>   channel{-1};          // requested capture channel, -1 = none
+  std::atomic<int>   available{0};         // channels on the selected input device
+  std::atomic<bool>  active{false};        // stream is running full duplex
+  std::atomic<bool>  reopenRequested{false};
+  std::atomic<float> gain{1.0f};           // input level into the send path
+  std::atomic<int>   monitorMode{1};       // 0 off, 1 direct, 2 latency-compensated
+  std::atomic<float> monitorGain{1.0f};
+  std::atomic<float> monitorDelayMs{0.0f}; // compensation currently applied
+  std::atomic<float> level{0.0f};          // block peak after gain
+};
+
+// One entry of the audio device list (filled by the control thread)
+struct AudioDeviceChoice {
+  unsigned    id = 0;
+  std::string name;
+  unsigned    outputChannels = 0;
+  unsigned    inputChannels = 0;
+  std::vector<unsigned> sampleRates;
+  bool        isDefaultOutput = false;
+  bool        isDefaultInput = false;
+};
+
+// Device, sample rate and buffer size; Apply reopens the stream live
+struct DeviceState {
+  std::atomic<unsigned> outputDevice{0};   // 0 = system default
+  std::atomic<unsigned> inputDevice{0};
+  std::atomic<unsigned> sampleRate{48000};
+  std::atomic<unsigned> bufferFrames{128}; // 32..1024
+  std::atomic<bool>     applyRequested{false};
+  std::atomic<bool>     rescanRequested{false};
+  // what the open stream actually runs at
+  std::atomic<unsigned> activeRate{48000};
+  std::atomic<unsigned> activeFrames{128};
+  std::atomic<unsigned> latencyFrames{0};
+  mutable CheckedMutex  mutex; // guards the list; never taken by the audio thread
+  std::vector<AudioDeviceChoice> devices;
+  std::string message;
+};
+
+// Convolution reverb on the master bus; the control thread loads responses
+struct ReverbState {
+  std::atomic<bool>     enabled{false};
+  std::atomic<float>    wet{0.3f};
+  std::atomic<bool>     loadRequested{false};
+  std::atomic<float>    seconds{0.0f};     // loaded response, 0 = none
+  std::atomic<unsigned> channels{0};
+  std::atomic<uint64_t> lateBlocks{0};     // tail blocks the background thread missed
+  std::atomic<float>    tailLoad{0.0f};    // background thread, % of one core
+  mutable CheckedMutex  mutex; // guards path and message; never taken by the audio thread
+  std::string path;
+  std::string message;
 };
 
 struct GuiState {
   SynthParams params;
+  // params.snapshot() as last published by the GUI thread (publish_patch);
+  // the audio thread only re-applies voice settings when a new one arrives
+  TripleBuffer<SynthPatch> patch;
+  SynthPatch publishedPatch; // GUI thread only
   NetStats    stats;
+  InputState  input;
+  DeviceState device;
+  ReverbState reverb;
   // Lock-free sequencer state shared between GUI and audio thread.
   struct SequencerState {
+    // bpm and playing are the GUI's view; changes reach the audio thread
+    // as transport events, or the server while the transport is shared
     std::atomic<int> bpm{120};
     std::atomic<bool> playing{false};
-    std::atomic<int> step{0};
+    std::atomic<int> step{0}; // step playing, from the audio thread
     // grid[row][step] -> 0/1
     std::array<std::array<std::atomic<uint8_t>, 16>, 12> grid{};
     SequencerState() {
       for (int r = 0; r < 12; ++r) for (int s = 0; s < 16; ++s) grid[r][s].store(0);
     }
   } sequencer;
+  // guarded by discoveryMutex (the net thread fills them in for port 0)
   std::string serverHost = "127.0.0.1";
   uint16_t    serverPort  = 50000;
   // Gate for note on/off (true while a key is held)
@@ -57,19 +228,32 @@ struct GuiState {
   std::atomic<bool> audioStartRequested{false};
   std::atomic<bool> audioStopRequested{false};
   std::atomic<bool> discoverRequested{false};
-  std::atomic<bool> discovering{false};
-  std::atomic<int> discoveryStatus{0}; // 0 idle, 1 success, -1 failure
+  std::atomic<bool> monoSend{false}; // low-bandwidth mode: downmix what we send to mono
   // Desired polyphony requested by the GUI (audio thread will resize the pool)
   std::atomic<int> polyphony{8};
-  // Lightweight note request flags for GUI -> audio thread communication.
-  // Each bit represents one of 12 notes (0=C .. 11=B). GUI sets bits when a key is pressed or released;
-  // audio thread consumes and clears them via atomic exchange.
-  std::atomic<uint16_t> noteOnRequests{0};
-  std::atomic<uint16_t> noteOffRequests{0};
+  // Notes, polyphony and transport changes, GUI thread -> audio thread,
+  // played at the frame their timestamps map to
+  EventQueue events;
+  // While connected the server owns the transport (see send_transport in
+  // GuiApp.cpp): changes go to the net thread as requests instead, and the
+  // receive thread keeps sequencer.bpm/playing in step with the session
+  std::atomic<bool> transportShared{false};
+  SpscQueue<AudioEvent> transportRequests{64};
   std::atomic<bool> hostDirty{false};
-  mutable std::mutex discoveryMutex;
-  std::string discoveredHost;
+  mutable CheckedMutex discoveryMutex; // never taken by the audio thread
+  std::vector<LanServerInfo> lanServers;
   std::string discoveryMessage;
+  std::string sessionMessage; // negotiated session / rejection reason
 };
 
+// Publishes params.snapshot() if it differs from the last published patch.
+// One thread only (the GUI loop, or main before the GUI starts).
+inline void publish_patch(GuiState& state, bool force = false) {
+  SynthPatch p = state.params.snapshot();
+  if (!force && p == state.publishedPatch) return;
+  state.publishedPatch = p;
+  state.patch.write_buffer() = p;
+  state.patch.publish();
+}
+
 int run_gui(GuiState& shared);
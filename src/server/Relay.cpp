@@ -0,0 +1,212 @@
+#include "Relay.h"
+#include "common/Discovery.h"
+
+#include <cmath>
+#include <string_view>
+
+RelayServer::RelayServer(asio::io_context& io, uint16_t port, RelayObserver& observer)
+    : port_(port),
+      observer_(observer),
+      sock_(io, asio::ip::udp::endpoint(asio::ip::udp::v4(), port)),
+      beaconEp_(asio::ip::address_v4::broadcast(), kBeaconPort) {
+  sock_.non_blocking(true);
+  sock_.set_option(asio::socket_base::broadcast(true));
+  if (port != kDiscoveryPort) {
+    asio::ip::udp::endpoint discoverEp(asio::ip::udp::v4(), kDiscoveryPort);
+    discoverySock_ = std::make_unique<asio::ip::udp::socket>(io, discoverEp);
+    discoverySock_->set_option(asio::socket_base::reuse_address(true));
+    discoverySock_->non_blocking(true);
+  }
+  auto now = std::chrono::steady_clock::now();
+  lastTransport_ = lastExpiry_ = now;
+  lastBeacon_ = now - std::chrono::milliseconds(kBeaconIntervalMs); // first beacon right away
+  observer_.session_changed(session_, false);
+}
+
+bool RelayServer::poll() {
+  send_beacon();
+  expire_peers();
+  if (std::chrono::steady_clock::now() - lastTransport_ >= std::chrono::milliseconds(kTransportRepeatMs))
+    broadcast_transport();
+  if (discoverySock_) handle_discovery_socket();
+
+  asio::ip::udp::endpoint from;
+  asio::error_code ec;
+  size_t n = sock_.receive_from(asio::buffer(buffer_), from, 0, ec);
+  if (ec == asio::error::would_block || ec == asio::error::try_again) return false;
+  if (ec) {
+    observer_.log(std::string("Receive error: ") + ec.message());
+    return false;
+  }
+  if (n) handle(from, n);
+  return true;
+}
+
+bool RelayServer::answer_discovery(asio::ip::udp::socket& s, const asio::ip::udp::endpoint& from, size_t n) {
+  std::string_view payload(reinterpret_cast<const char*>(buffer_.data()), n);
+  if (payload.rfind(kDiscoveryMsg, 0) != 0) return false;
+  std::string reply = std::string(kDiscoveryReplyPrefix) + ":" + std::to_string(port_);
+  asio::error_code ec;
+  s.send_to(asio::buffer(reply), from, 0, ec);
+  observer_.discovery_answered();
+  observer_.log("Discovery from " + from.address().to_string() + ":" + std::to_string(from.port()));
+  return true;
+}
+
+void RelayServer::handle_discovery_socket() {
+  asio::ip::udp::endpoint from;
+  asio::error_code ec;
+  size_t n = discoverySock_->receive_from(asio::buffer(buffer_), from, 0, ec);
+  if (ec || n == 0) return;
+  answer_discovery(*discoverySock_, from, n);
+}
+
+void RelayServer::handle(const asio::ip::udp::endpoint& from, size_t n) {
+  if (answer_discovery(sock_, from, n)) return;
+
+  auto now = std::chrono::steady_clock::now();
+  std::string key = from.address().to_string() + ":" + std::to_string(from.port());
+  MsgType type;
+  if (!peek_msg_type(buffer_.data(), n, type)) return; // not a LANjam datagram
+
+  if (type == MsgType::Hello) {
+    HelloMsg hello;
+    if (!decode_hello(buffer_.data(), n, hello)) return;
+    observer_.handshake_received();
+    SessionConfig before = session_.config();
+    WelcomeMsg welcome = session_.join(key, hello);
+    send_welcome(from, welcome);
+    if (welcome.status == WelcomeStatus::Rejected) {
+      observer_.log("Handshake from " + key + " rejected: " + to_string(welcome.reason));
+      return;
+    }
+    auto [it, inserted] = peers_.insert_or_assign(key, Peer{from, now});
+    observer_.peer_seen(key, welcome.sender_id, 0, now);
+    if (inserted) {
+      observer_.log("Peer joined " + key + " as sender " + std::to_string(welcome.sender_id) +
+                    " (total peers: " + std::to_string(peers_.size()) + ")");
+    }
+    send_transport(from);
+    const auto& after = session_.config();
+    if (after.block_frames != before.block_frames || after.channels != before.channels ||
+        after.format != before.format || after.fec_level != before.fec_level) {
+      broadcast_update();
+    } else {
+      observer_.session_changed(session_, false);
+    }
+    return;
+  }
+  if (type == MsgType::ClockPing) {
+    ClockPingMsg ping;
+    auto it = peers_.find(key);
+    if (it == peers_.end() || !decode_clock_ping(buffer_.data(), n, ping)) return;
+    it->second.lastSeen = now;
+    ClockPongMsg pong;
+    pong.t0 = ping.t0;
+    pong.t1 = pong.t2 = steady_now_ns(); // answered as soon as it is read
+    send(from, encode_clock_pong(reply_.data(), reply_.size(), pong));
+    return;
+  }
+  if (type == MsgType::TransportRequest) {
+    TransportRequestMsg req;
+    if (!peers_.count(key) || !decode_transport_request(buffer_.data(), n, req)) return;
+    if (transport_.apply(req, steady_now_ns())) {
+      const auto& st = transport_.state();
+      observer_.log(std::string("Transport ") + (st.playing ? "playing" : "stopped") + " at " +
+                    std::to_string(static_cast<int>(std::lround(st.bpm))) + " BPM from " + key);
+      broadcast_transport();
+    }
+    return;
+  }
+  if (type != MsgType::Audio || n < kAudioHeaderSize) return;
+
+  auto it = peers_.find(key);
+  if (it == peers_.end()) return; // no handshake yet: drop rather than relay garbage
+  it->second.lastSeen = now;
+
+  // stamp the authoritative sender id so receivers can demultiplex
+  uint32_t senderId = session_.sender_id(key);
+  WireWriter stamp(buffer_.data() + kSenderIdOffset, 4);
+  stamp.u32(senderId);
+  observer_.peer_seen(key, senderId, 0, now);
+
+  for (auto& [peerKey, peer] : peers_) {
+    if (peerKey == key) continue;
+    asio::error_code sendEc;
+    sock_.send_to(asio::buffer(buffer_.data(), n), peer.ep, 0, sendEc);
+    if (sendEc) {
+      observer_.log("Send error to " + peerKey + ": " + sendEc.message());
+      continue;
+    }
+    ++forwardedSinceBeacon_;
+    observer_.peer_seen(peerKey, session_.sender_id(peerKey), 1, now);
+  }
+}
+
+void RelayServer::send(const asio::ip::udp::endpoint& to, size_t len) {
+  asio::error_code ec;
+  if (len) sock_.send_to(asio::buffer(reply_.data(), len), to, 0, ec);
+}
+
+void RelayServer::send_welcome(const asio::ip::udp::endpoint& to, const WelcomeMsg& msg) {
+  send(to, encode_welcome(reply_.data(), reply_.size(), msg));
+}
+
+// tell every peer about a session change (e.g. a smaller block size)
+void RelayServer::broadcast_update() {
+  for (auto& [k, peer] : peers_) {
+    WelcomeMsg msg;
+    msg.status = WelcomeStatus::Update;
+    msg.sender_id = session_.sender_id(k);
+    msg.config = session_.config();
+    send_welcome(peer.ep, msg);
+  }
+  observer_.session_changed(session_, true);
+}
+
+void RelayServer::send_transport(const asio::ip::udp::endpoint& to) {
+  send(to, encode_transport_state(reply_.data(), reply_.size(), transport_.state()));
+}
+
+void RelayServer::broadcast_transport() {
+  lastTransport_ = std::chrono::steady_clock::now();
+  for (auto& [k, peer] : peers_) send_transport(peer.ep);
+}
+
+// periodic beacon so clients see this server without probing
+void RelayServer::send_beacon() {
+  auto now = std::chrono::steady_clock::now();
+  auto elapsed = now - lastBeacon_;
+  if (elapsed < std::chrono::milliseconds(kBeaconIntervalMs)) return;
+  double secs = std::chrono::duration<double>(elapsed).count();
+  ServerBeacon beacon;
+  beacon.port = port_;
+  beacon.peers = static_cast<uint32_t>(peers_.size());
+  beacon.load = static_cast<uint32_t>(static_cast<double>(forwardedSinceBeacon_) / secs);
+  beacon.rooms = {kDefaultRoom};
+  asio::error_code ec;
+  sock_.send_to(asio::buffer(format_beacon(beacon)), beaconEp_, 0, ec);
+  if (!ec) observer_.beacon_sent();
+  lastBeacon_ = now;
+  forwardedSinceBeacon_ = 0;
+}
+
+// expire silent peers so the session can grow back
+void RelayServer::expire_peers() {
+  auto now = std::chrono::steady_clock::now();
+  if (now - lastExpiry_ < std::chrono::milliseconds(kBeaconIntervalMs)) return;
+  lastExpiry_ = now;
+  bool changed = false;
+  for (auto it = peers_.begin(); it != peers_.end();) {
+    if (now - it->second.lastSeen > std::chrono::milliseconds(kPeerTimeoutMs)) {
+      observer_.log("Peer " + it->first + " timed out");
+      changed |= session_.leave(it->first);
+      observer_.peer_removed(it->first);
+      it = peers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (changed) broadcast_update();
+  else observer_.session_changed(session_, false);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/Session.h"
+#include "common/SharedTransport.h"
+
+// What a relay reports back to the program hosting it. The console server
+// prints the log lines; the GUI server also keeps its peer table and
+// counters from the other hooks.
+class RelayObserver {
+public:
+  virtual ~RelayObserver() = default;
+  virtual void log(const std::string& line) = 0;
+  // After a join, a leave or an expiry pass; `updated` when the peers were re-sent the config
+  virtual void session_changed(const SessionNegotiator& /*session*/, bool /*updated*/) {}
+  // A datagram from, or `forwarded` datagrams relayed to, a negotiated peer
+  virtual void peer_seen(const std::string& /*key*/, uint32_t /*senderId*/, uint64_t /*forwarded*/,
+                         std::chrono::steady_clock::time_point /*now*/) {}
+  virtual void peer_removed(const std::string& /*key*/) {}
+  virtual void discovery_answered() {}
+  virtual void beacon_sent() {}
+  virtual void handshake_received() {}
+};
+
+// The relay loop shared by both servers: answers discovery probes, sends
+// beacons, negotiates the session, answers clock pings, owns the shared
+// transport and forwards audio between negotiated peers.
+class RelayServer {
+public:
+  // Binds the relay port (and the discovery port when it differs); throws on failure
+  RelayServer(asio::io_context& io, uint16_t port, RelayObserver& observer);
+
+  // Housekeeping plus at most one datagram. False when nothing was read,
+  // so the caller can sleep before the next pass.
+  bool poll();
+
+private:
+  struct Peer {
+    asio::ip::udp::endpoint ep;
+    std::chrono::steady_clock::time_point lastSeen;
+  };
+
+  bool answer_discovery(asio::ip::udp::socket& s, const asio::ip::udp::endpoint& from, size_t n);
+  void handle_discovery_socket();
+  void handle(const asio::ip::udp::endpoint& from, size_t n);
+  void send(const asio::ip::udp::endpoint& to, size_t len);
+  void send_welcome(const asio::ip::udp::endpoint& to, const WelcomeMsg& msg);
+  void broadcast_update();
+  void send_transport(const asio::ip::udp::endpoint& to);
+  void broadcast_transport();
+  void send_beacon();
+  void expire_peers();
+
+  uint16_t port_;
+  RelayObserver& observer_;
+  asio::ip::udp::socket sock_;
+  std::unique_ptr<asio::ip::udp::socket> discoverySock_;
+  asio::ip::udp::endpoint beaconEp_;
+  std::vector<uint8_t> buffer_ = std::vector<uint8_t>(1500);
+  std::vector<uint8_t> reply_ = std::vector<uint8_t>(64);
+  std::unordered_map<std::string, Peer> peers_; // negotiated peers only
+  SessionNegotiator session_;
+  TransportLeader transport_; // re-sent now and then for anyone who missed it
+  std::chrono::steady_clock::time_point lastTransport_;
+  std::chrono::steady_clock::time_point lastBeacon_;
+  std::chrono::steady_clock::time_point lastExpiry_;
+  uint64_t forwardedSinceBeacon_ = 0;
+};
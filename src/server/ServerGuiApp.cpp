@@ -93,8 +93,9 @@ int run_server_gui(ServerState& shared) {
     ImGui::EndDisabled();
 
     ImGui::Separator();
-    ImGui::Text("Discoveries: %" PRIu64 "   Handshakes: %" PRIu64 "   Packets: %" PRIu64,
+    ImGui::Text("Discoveries: %" PRIu64 "   Beacons: %" PRIu64 "   Handshakes: %" PRIu64 "   Packets: %" PRIu64,
                 shared.discoveryCount.load(),
+                shared.beaconCount.load(),
                 shared.handshakeCount.load(),
                 shared.packetsForwarded.load());
     ImGui::EndChild();
@@ -102,9 +103,11 @@ int run_server_gui(ServerState& shared) {
     ImGui::Spacing();
 
     std::vector<ServerPeerInfo> peersSnapshot;
+    std::string sessionSummary;
     {
       std::lock_guard<std::mutex> lock(shared.peersMutex);
       peersSnapshot = shared.peers;
+      sessionSummary = shared.sessionSummary;
     }
     std::vector<std::string> logSnapshot;
     {
@@ -117,8 +120,10 @@ int run_server_gui(ServerState& shared) {
     ImGui::SetColumnWidth(0, avail.x * 0.55f);
 
     ImGui::Text("Peers (%zu)", peersSnapshot.size());
-    if (ImGui::BeginTable("PeersTable", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable)) {
+    if (!sessionSummary.empty()) ImGui::TextWrapped("Session: %s", sessionSummary.c_str());
+    if (ImGui::BeginTable("PeersTable", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable)) {
       ImGui::TableSetupColumn("Endpoint");
+      ImGui::TableSetupColumn("Id");
       ImGui::TableSetupColumn("Packets");
       ImGui::TableSetupColumn("Last seen (ms)");
       ImGui::TableHeadersRow();
@@ -128,8 +133,10 @@ int run_server_gui(ServerState& shared) {
         ImGui::TableSetColumnIndex(0);
         ImGui::TextUnformatted(peer.endpoint.c_str());
         ImGui::TableSetColumnIndex(1);
-        ImGui::Text("%" PRIu64, peer.packetsForwarded);
+        ImGui::Text("%u", peer.senderId);
         ImGui::TableSetColumnIndex(2);
+        ImGui::Text("%" PRIu64, peer.packetsForwarded);
+        ImGui::TableSetColumnIndex(3);
         auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - peer.lastSeen).count();
         ImGui::Text("%lld", static_cast<long long>(ms));
       }
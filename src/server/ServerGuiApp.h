@@ -9,6 +9,7 @@
 
 struct ServerPeerInfo {
   std::string endpoint;
+  uint32_t senderId = 0;
   uint64_t packetsForwarded = 0;
   std::chrono::steady_clock::time_point lastSeen;
 };
@@ -21,11 +22,13 @@ struct ServerState {
   std::atomic<bool> quitRequested{false};
 
   std::atomic<uint64_t> discoveryCount{0};
+  std::atomic<uint64_t> beaconCount{0};
   std::atomic<uint64_t> handshakeCount{0};
   std::atomic<uint64_t> packetsForwarded{0};
 
   std::mutex peersMutex;
   std::vector<ServerPeerInfo> peers;
+  std::string sessionSummary; // negotiated session parameters (guarded by peersMutex)
 
   std::mutex logMutex;
   std::deque<std::string> log;
@@ -1,6 +1,7 @@
 #include "ServerGuiApp.h"
-#include "common/Discovery.h"
+#include "Relay.h"
 
+#include <algorithm>
 #include <asio.hpp>
 #include <atomic>
 #include <chrono>
@@ -9,7 +10,6 @@
 #include <mutex>
 #include <string>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
 namespace {
@@ -20,7 +20,8 @@ void push_log(ServerState& state, const std::string& line) {
   while (state.log.size() > 200) state.log.pop_front();
 }
 
-void update_peer(ServerState& state, const std::string& endpoint, uint64_t addPackets, std::chrono::steady_clock::time_point now) {
+void update_peer(ServerState& state, const std::string& endpoint, uint64_t addPackets,
+                 std::chrono::steady_clock::time_point now, uint32_t senderId) {
   std::lock_guard<std::mutex> lock(state.peersMutex);
   auto it = std::find_if(state.peers.begin(), state.peers.end(), [&](const ServerPeerInfo& p){ return p.endpoint == endpoint; });
   if (it == state.peers.end()) {
@@ -28,13 +29,57 @@ void update_peer(ServerState& state, const std::string& endpoint, uint64_t addPa
     info.endpoint = endpoint;
     info.lastSeen = now;
     info.packetsForwarded = addPackets;
+    info.senderId = senderId;
     state.peers.push_back(info);
   } else {
+    it->senderId = senderId;
     it->lastSeen = now;
     it->packetsForwarded += addPackets;
   }
 }
 
+void remove_peer(ServerState& state, const std::string& endpoint) {
+  std::lock_guard<std::mutex> lock(state.peersMutex);
+  state.peers.erase(std::remove_if(state.peers.begin(), state.peers.end(),
+                                   [&](const ServerPeerInfo& p) { return p.endpoint == endpoint; }),
+                    state.peers.end());
+}
+
+void publish_session(ServerState& state, const SessionNegotiator& session) {
+  const auto& cfg = session.config();
+  std::string summary = session.peer_count() == 0
+      ? std::string("no peers")
+      : std::to_string(cfg.sample_rate) + " Hz, " + std::to_string(cfg.block_frames) + " frames, " +
+        std::to_string(cfg.channels) + " ch, pcm " + to_string(cfg.format) + ", fec " + std::to_string(cfg.fec_level);
+  std::lock_guard<std::mutex> lock(state.peersMutex);
+  state.sessionSummary = std::move(summary);
+}
+
+// Feeds the relay's events into the state the GUI draws
+class GuiObserver : public RelayObserver {
+public:
+  explicit GuiObserver(ServerState& state) : state_(state) {}
+  void log(const std::string& line) override { push_log(state_, line); }
+  void session_changed(const SessionNegotiator& session, bool updated) override {
+    publish_session(state_, session);
+    if (!updated) return;
+    std::lock_guard<std::mutex> lock(state_.peersMutex);
+    push_log(state_, "Session updated: " + state_.sessionSummary);
+  }
+  void peer_seen(const std::string& key, uint32_t senderId, uint64_t forwarded,
+                 std::chrono::steady_clock::time_point now) override {
+    state_.packetsForwarded.fetch_add(forwarded);
+    update_peer(state_, key, forwarded, now, senderId);
+  }
+  void peer_removed(const std::string& key) override { remove_peer(state_, key); }
+  void discovery_answered() override { state_.discoveryCount.fetch_add(1); }
+  void beacon_sent() override { state_.beaconCount.fetch_add(1); }
+  void handshake_received() override { state_.handshakeCount.fetch_add(1); }
+
+private:
+  ServerState& state_;
+};
+
 } // namespace
 
 int main() {
@@ -51,98 +96,16 @@ int main() {
 
         try {
           asio::io_context io;
-          asio::ip::udp::socket sock(io, asio::ip::udp::endpoint(asio::ip::udp::v4(), listenPort));
-          sock.non_blocking(true);
-
-          std::unique_ptr<asio::ip::udp::socket> discoverySock;
-          if (listenPort != kDiscoveryPort) {
-            asio::ip::udp::endpoint discoverEp(asio::ip::udp::v4(), kDiscoveryPort);
-            discoverySock = std::make_unique<asio::ip::udp::socket>(io, discoverEp);
-            discoverySock->set_option(asio::socket_base::reuse_address(true));
-            discoverySock->non_blocking(true);
-          }
+          GuiObserver observer(state);
+          RelayServer relay(io, listenPort, observer);
 
           state.running.store(true);
           serverLoopActive.store(true);
           push_log(state, "Listening on UDP port " + std::to_string(listenPort));
 
-          std::vector<uint8_t> buffer(1500);
-          std::unordered_map<std::string, asio::ip::udp::endpoint> peers;
-
-          auto handle_discovery = [&](asio::ip::udp::socket& ds) {
-            asio::ip::udp::endpoint from;
-            asio::error_code ec;
-            size_t n = ds.receive_from(asio::buffer(buffer), from, 0, ec);
-            if (ec == asio::error::would_block || ec == asio::error::try_again) return;
-            if (ec || n == 0) return;
-            std::string_view payload(reinterpret_cast<const char*>(buffer.data()), n);
-            if (payload.rfind(kDiscoveryMsg, 0) == 0) {
-              std::string reply = std::string(kDiscoveryReplyPrefix) + ":" + std::to_string(listenPort);
-              ds.send_to(asio::buffer(reply), from);
-              state.discoveryCount.fetch_add(1);
-              push_log(state, "Discovery from " + from.address().to_string() + ":" + std::to_string(from.port()));
-            }
-          };
           while (!state.quitRequested.load() && !state.stopRequested.load()) {
-            if (discoverySock) handle_discovery(*discoverySock);
-
-            asio::ip::udp::endpoint from;
-            asio::error_code ec;
-            size_t n = sock.receive_from(asio::buffer(buffer), from, 0, ec);
-            if (ec == asio::error::would_block || ec == asio::error::try_again) {
-              std::this_thread::sleep_for(std::chrono::milliseconds(2));
-              continue;
-            }
-            if (ec) {
-              push_log(state, std::string("Receive error: ") + ec.message());
-              std::this_thread::sleep_for(std::chrono::milliseconds(10));
-              continue;
-            }
-            if (!n) continue;
-
-            auto now = std::chrono::steady_clock::now();
-            std::string_view payload(reinterpret_cast<const char*>(buffer.data()), n);
-            if (payload.rfind(kDiscoveryMsg, 0) == 0) {
-              std::string reply = std::string(kDiscoveryReplyPrefix) + ":" + std::to_string(listenPort);
-              sock.send_to(asio::buffer(reply), from);
-              state.discoveryCount.fetch_add(1);
-              push_log(state, "Discovery from " + from.address().to_string() + ":" + std::to_string(from.port()));
-              continue;
-            }
-            if (payload.rfind(kHelloMsg, 0) == 0) {
-              sock.send_to(asio::buffer(kWelcomeMsg, std::strlen(kWelcomeMsg)), from);
-              state.handshakeCount.fetch_add(1);
-              std::string key = from.address().to_string() + ":" + std::to_string(from.port());
-              peers[key] = from;
-              update_peer(state, key, 0, now);
-              push_log(state, "Handshake hello from " + key + " -> welcome sent");
-              continue;
-            }
-
-            std::string key = from.address().to_string() + ":" + std::to_string(from.port());
-            auto it = peers.find(key);
-            if (it == peers.end()) {
-              peers[key] = from;
-              update_peer(state, key, 0, now);
-              push_log(state, "Peer joined " + key + " (total peers: " + std::to_string(peers.size()) + ")");
-            } else {
-              it->second = from;
-            }
-
-            for (auto& [peerKey, ep] : peers) {
-              if (peerKey == key) continue;
-              asio::error_code sendEc;
-              sock.send_to(asio::buffer(buffer.data(), n), ep, 0, sendEc);
-              if (sendEc) {
-                push_log(state, "Send error to " + peerKey + ": " + sendEc.message());
-                continue;
-              }
-              state.packetsForwarded.fetch_add(1);
-              update_peer(state, peerKey, 1, now);
-            }
+            if (!relay.poll()) std::this_thread::sleep_for(std::chrono::milliseconds(2));
           }
-
-          sock.close();
         } catch (const std::exception& e) {
           push_log(state, std::string("Server error: ") + e.what());
         }
@@ -150,6 +113,7 @@ int main() {
         {
           std::lock_guard<std::mutex> lock(state.peersMutex);
           state.peers.clear();
+          state.sessionSummary.clear();
         }
 
         state.stopRequested.store(false);